@@ -4,13 +4,14 @@ in vec3 vNormal;
 out vec3 oNormal;
 out vec3 oPos;
 
-uniform mat4 mM;
-
-//= mat4(1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+uniform mat4 mvpM;
+uniform mat4 mvM;
+uniform mat3 nM;
 
 void main() {
-  gl_Position = mM * vec4(vPos.x, vPos.y, vPos.z, 1.0);
-  oPos = gl_Position.xyz;
-  oNormal = (mM * vec4(vNormal, 1.0)).xyz;
+  vec4 pos = vec4(vPos.x, vPos.y, vPos.z, 1.0);
+  gl_Position = mvpM * pos;
+  oPos = (mvM * pos).xyz;
+  // Normals are directions, transform by the inverse transpose
+  oNormal = nM * vNormal;
 }
-
@@ -0,0 +1,12 @@
+#version 330
+in vec3 oNormal;
+in vec3 oColor;
+out vec4 pColor;
+
+void main() {
+  // Baked values (curvature, occlusion) are the colour, with a
+  // little head-on shading so the shape still reads
+  vec3 norm = normalize(oNormal);
+  float shade = 0.6 + 0.4 * abs(norm.z);
+  pColor = vec4(oColor * shade, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec3 vColor;
+out vec3 oNormal;
+out vec3 oColor;
+
+uniform mat4 mvpM;
+uniform mat4 mvM;
+uniform mat3 nM;
+
+void main() {
+  vec4 pos = vec4(vPos.x, vPos.y, vPos.z, 1.0);
+  gl_Position = mvpM * pos;
+  // Normals are directions, transform by the inverse transpose
+  oNormal = nM * vNormal;
+  oColor = vColor;
+}
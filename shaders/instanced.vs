@@ -0,0 +1,19 @@
+#version 330
+in vec3 vPos;
+in vec3 vNormal;
+in mat4 iM;
+out vec3 oNormal;
+out vec3 oPos;
+
+uniform mat4 mvpM;
+uniform mat4 mvM;
+uniform mat3 nM;
+
+void main() {
+  vec4 pos = iM * vec4(vPos.x, vPos.y, vPos.z, 1.0);
+  gl_Position = mvpM * pos;
+  oPos = (mvM * pos).xyz;
+  // Instance transforms are rotation, translation and uniform
+  // scale only, so their upper 3x3 is a valid normal transform.
+  oNormal = nM * (mat3(iM) * vNormal);
+}
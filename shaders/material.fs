@@ -0,0 +1,39 @@
+#version 330
+in vec3 oNormal;
+in vec3 oPos;
+flat in int oMaterial;
+out vec4 pColor;
+
+struct materialData {
+  vec4 diffuse;   // rgb, opacity
+  vec4 specular;  // rgb, shininess
+};
+
+layout(std140) uniform materials {
+  materialData material[512];
+};
+
+uniform vec3 lightPos = normalize(vec3(0.0f,0.2f,-1.0f));
+
+void main() {
+  materialData m = material[oMaterial];
+
+  // Ambient light source
+  float ambientStrength = 0.1;
+  vec3 ambient = ambientStrength * m.diffuse.rgb;
+
+  // Diffuse light source
+  vec3 norm = normalize(oNormal);
+  vec3 lightDir = -lightPos;
+  float diffuseStrength = max(dot(lightPos,norm),0.0);
+  vec3 diffuse = diffuseStrength * m.diffuse.rgb;
+
+  // Specular light source
+  vec3 viewPos = normalize(vec3(0.0,0.0,1.0));
+  vec3 viewDir = normalize(viewPos - oPos);
+  vec3 reflectDir = reflect(-lightDir, norm);
+  float specularStrength = pow(max(dot(viewDir,reflectDir),0.0), m.specular.a);
+  vec3 specular = specularStrength * m.specular.rgb;
+
+  pColor = vec4(ambient + diffuse + specular, m.diffuse.a);
+}
@@ -0,0 +1,22 @@
+#version 330
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in uint vMaterial;
+out vec3 oNormal;
+out vec3 oPos;
+flat out int oMaterial;
+
+uniform mat4 mvpM;
+uniform mat4 mvM;
+uniform mat3 nM;
+// First material of the uniform block currently bound
+uniform int materialBase;
+
+void main() {
+  vec4 pos = vec4(vPos.x, vPos.y, vPos.z, 1.0);
+  gl_Position = mvpM * pos;
+  oPos = (mvM * pos).xyz;
+  // Normals are directions, transform by the inverse transpose
+  oNormal = nM * vNormal;
+  oMaterial = int(vMaterial) - materialBase;
+}
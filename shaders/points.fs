@@ -0,0 +1,12 @@
+#version 330
+in vec3 oColor;
+out vec4 pColor;
+
+void main() {
+  // Round points
+  vec2 d = gl_PointCoord - vec2(0.5);
+  if (dot(d, d) > 0.25) {
+    discard;
+  }
+  pColor = vec4(oColor, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec4 vColor;
+out vec3 oColor;
+
+uniform mat4 mvpM;
+uniform mat4 mvM;
+uniform float spacing;      // of the node being drawn, model units
+uniform float pixelScale;   // pixels per unit at distance 1
+
+void main() {
+  vec4 pos = vec4(vPos, 1.0);
+  gl_Position = mvpM * pos;
+  // Points grow to cover their node's spacing on screen, so
+  // coarse nodes far away still read as a surface
+  float depth = max(-(mvM * pos).z, 1e-4);
+  gl_PointSize = clamp(spacing * length(mvM[0].xyz) * pixelScale / depth, 1.0, 8.0);
+  oColor = vColor.rgb;
+}
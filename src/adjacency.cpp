@@ -0,0 +1,139 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <adjacency.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+
+namespace twg {
+
+  using adjacency = meshAdjacency;
+
+  struct edgeCounts {
+    std::size_t boundary = 0;
+    std::size_t nonManifold = 0;
+  };
+
+  /**
+   * Pair the twins of the edges from vertex a to higher
+   * numbered vertices.  Every half-edge touching a is either a
+   * corner of a (leaving it) or the edge before one (arriving),
+   * so a's own corner list sees both directions and no other
+   * vertex writes these twins.
+   */
+  static edgeCounts pairTwins(adjacency &adj, const mesh &m, uint32_t a)
+  {
+    struct incident { uint32_t other, halfEdge; bool leaving; };
+    static thread_local std::vector<incident> edges;
+    edges.clear();
+    for(uint32_t i = adj.cornerOffsets[a]; i < adj.cornerOffsets[a + 1]; ++i)
+      {
+	uint32_t h = adj.corners[i];
+	uint32_t to = m.elements[adjacency::next(h)];
+	uint32_t from = m.elements[adjacency::prev(h)];
+	if(to > a)
+	  {
+	    edges.push_back({to, h, true});
+	  }
+	if(from > a)
+	  {
+	    edges.push_back({from, adjacency::prev(h), false});
+	  }
+      }
+    std::sort(edges.begin(), edges.end(),
+	      [](const incident &x, const incident &y) {
+		return x.other != y.other ? x.other < y.other : x.halfEdge < y.halfEdge;
+	      });
+    edgeCounts counts;
+    for(std::size_t i = 0; i < edges.size();)
+      {
+	std::size_t j = i + 1;
+	while(j < edges.size() && edges[j].other == edges[i].other)
+	  {
+	    ++j;
+	  }
+	if(j - i == 1)
+	  {
+	    ++counts.boundary;
+	  }
+	else if(j - i == 2 && edges[i].leaving != edges[i + 1].leaving)
+	  {
+	    adj.twin[edges[i].halfEdge] = edges[i + 1].halfEdge;
+	    adj.twin[edges[i + 1].halfEdge] = edges[i].halfEdge;
+	  }
+	else
+	  {
+	    ++counts.nonManifold;
+	  }
+	i = j;
+      }
+    return counts;
+  }
+
+  meshAdjacency buildAdjacency(const mesh &m)
+  {
+    adjacency adj;
+    std::size_t vertices = m.vertices.size();
+    std::size_t corners = m.elements.size() / 3 * 3;
+
+    // Vertex to corner CSR from one stable radix sort
+    std::vector<std::pair<uint32_t, uint32_t>> items(corners);
+    parallelFor(0, corners, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t h = lo; h < hi; ++h)
+	  {
+	    items[h] = {m.elements[h], static_cast<uint32_t>(h)};
+	  }
+      });
+    unsigned bits = 0;
+    while(bits < 32 && (uint64_t(1) << bits) < vertices)
+      {
+	++bits;
+      }
+    radixSort(items, bits);
+
+    adj.corners.resize(corners);
+    adj.cornerOffsets.assign(vertices + 1, static_cast<uint32_t>(corners));
+    parallelFor(0, corners, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    adj.corners[i] = items[i].second;
+	    uint32_t first = i == 0 ? 0 : items[i - 1].first + 1;
+	    for(uint32_t v = first; v <= items[i].first; ++v)
+	      {
+		adj.cornerOffsets[v] = static_cast<uint32_t>(i);
+	      }
+	  }
+      });
+    if(corners == 0)
+      {
+	std::fill(adj.cornerOffsets.begin(), adj.cornerOffsets.end(), 0);
+      }
+    std::vector<std::pair<uint32_t, uint32_t>>().swap(items);
+
+    adj.twin.assign(corners, adjacency::invalid);
+    edgeCounts counts = parallelReduce
+      (0, vertices, edgeCounts{},
+       [&](std::size_t lo, std::size_t hi) {
+	edgeCounts c;
+	for(std::size_t v = lo; v < hi; ++v)
+	  {
+	    edgeCounts e = pairTwins(adj, m, static_cast<uint32_t>(v));
+	    c.boundary += e.boundary;
+	    c.nonManifold += e.nonManifold;
+	  }
+	return c;
+      },
+       [](const edgeCounts &a, const edgeCounts &b) {
+	return edgeCounts{a.boundary + b.boundary, a.nonManifold + b.nonManifold};
+      });
+    adj.boundaryEdges = counts.boundary;
+    adj.nonManifoldEdges = counts.nonManifold;
+    return adj;
+  }
+
+} /* End twg namespace */
@@ -7,3 +7,26 @@
  *
  */
 #include <meshtool.cpp>
+#include <stream.cpp>
+#include <formats.cpp>
+#include <gltf.cpp>
+#include <materials.cpp>
+#include <scene.cpp>
+#include <stats.cpp>
+#include <voxel.cpp>
+#include <isosurface.cpp>
+#include <weld.cpp>
+#include <adjacency.cpp>
+#include <subdivision.cpp>
+#include <bvh.cpp>
+#include <bake.cpp>
+#include <codec.cpp>
+#include <capture.cpp>
+#include <headless.cpp>
+#include <daemon.cpp>
+#include <batch.cpp>
+#include <pointcloud.cpp>
+#include <sharedmesh.cpp>
+#include <watch.cpp>
+#include <sequence.cpp>
+#include <bench.cpp>
@@ -0,0 +1,244 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <bake.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+
+namespace twg {
+
+  using adjacency = meshAdjacency;
+
+  bool parseBakeKind(const std::string &name, bakeKind &kind)
+  {
+    if(name == "mean")
+      {
+	kind = bakeKind::mean;
+      }
+    else if(name == "gaussian")
+      {
+	kind = bakeKind::gaussian;
+      }
+    else if(name == "ao" || name == "occlusion")
+      {
+	kind = bakeKind::occlusion;
+      }
+    else
+      {
+	return false;
+      }
+    return true;
+  }
+
+  // Cotangent of the angle between a and b
+  static float cotangent(const glm::vec3 &a, const glm::vec3 &b)
+  {
+    float s = glm::length(glm::cross(a, b));
+    return s > 1e-20f ? glm::dot(a, b) / s : 0.0f;
+  }
+
+  void computeCurvature(const mesh &m, const meshAdjacency &adj,
+			std::vector<float> &mean, std::vector<float> &gaussian)
+  {
+    std::size_t count = m.vertices.size();
+    mean.assign(count, 0.0f);
+    gaussian.assign(count, 0.0f);
+    parallelFor(0, count, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t v = lo; v < hi; ++v)
+	  {
+	    const glm::vec3 &p = m.vertices[v].point;
+	    glm::vec3 laplacian(0.0f);
+	    float area = 0.0f, angles = 0.0f;
+	    bool boundary = false;
+	    for(uint32_t i = adj.cornerOffsets[v]; i < adj.cornerOffsets[v + 1]; ++i)
+	      {
+		uint32_t h = adj.corners[i];
+		boundary = boundary || adj.twin[h] == adjacency::invalid
+		  || adj.twin[adjacency::prev(h)] == adjacency::invalid;
+		const glm::vec3 &pj = m.vertices[m.elements[adjacency::next(h)]].point;
+		const glm::vec3 &pk = m.vertices[m.elements[adjacency::prev(h)]].point;
+		glm::vec3 a = pj - p, b = pk - p;
+		glm::vec3 n = glm::cross(a, b);
+		float twiceArea = glm::length(n);
+		area += twiceArea / 6.0f;
+		angles += std::atan2(twiceArea, glm::dot(a, b));
+		// Edge p-pj is opposite the angle at pk and vice versa
+		laplacian += cotangent(p - pk, pj - pk) * a + cotangent(p - pj, pk - pj) * b;
+	      }
+	    if(boundary || area <= 0.0f)
+	      {
+		continue;
+	      }
+	    mean[v] = -glm::dot(laplacian, m.vertices[v].normal) / (4.0f * area);
+	    gaussian[v] = (2.0f * static_cast<float>(M_PI) - angles) / area;
+	  }
+      });
+  }
+
+  /**
+   * Orthonormal basis around unit n (Duff et al., "Building an
+   * orthonormal basis, revisited").
+   */
+  static void basis(const glm::vec3 &n, glm::vec3 &t, glm::vec3 &b)
+  {
+    float sign = std::copysign(1.0f, n.z);
+    float a = -1.0f / (sign + n.z);
+    float c = n.x * n.y * a;
+    t = glm::vec3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+    b = glm::vec3(c, sign + n.y * n.y * a, -n.y);
+  }
+
+  std::vector<float> computeOcclusion(const mesh &m, const meshBvh &bvh,
+				      int rays, float distance)
+  {
+    std::size_t count = m.vertices.size();
+    std::vector<float> open(count, 1.0f);
+    if(count == 0 || rays <= 0)
+      {
+	return open;
+      }
+    glm::vec3 lo{FLT_MAX}, hi{-FLT_MAX};
+    for(const Vertex &v : m.vertices)
+      {
+	lo = glm::min(lo, v.point);
+	hi = glm::max(hi, v.point);
+      }
+    float diagonal = std::max(glm::length(hi - lo), 1e-6f);
+    float reach = distance > 0.0f ? distance : 0.25f * diagonal;
+    float offset = 1e-4f * diagonal;
+
+    // Cosine weighted spiral over the hemisphere, z up; every
+    // vertex turns it by its own angle so patterns do not line up
+    std::size_t padded = (rays + 3) & ~std::size_t(3);
+    std::vector<glm::vec3> local(padded, glm::vec3(0.0f, 0.0f, 1.0f));
+    for(int i = 0; i < rays; ++i)
+      {
+	float r2 = (i + 0.5f) / rays;
+	float phi = i * 2.39996323f;
+	float r = std::sqrt(r2);
+	local[i] = glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(1.0f - r2));
+      }
+
+    constexpr std::size_t blockSize = 64;
+    std::size_t blocks = (count + blockSize - 1) / blockSize;
+    std::atomic<std::size_t> nextBlock{0};
+    parallelFor(0, workerCount(), [&](std::size_t, std::size_t, unsigned) {
+	glm::vec3 dir[4];
+	for(std::size_t block; (block = nextBlock.fetch_add(1)) < blocks;)
+	  {
+	    std::size_t end = std::min(count, (block + 1) * blockSize);
+	    for(std::size_t v = block * blockSize; v < end; ++v)
+	      {
+		glm::vec3 n = m.vertices[v].normal;
+		float len = glm::length(n);
+		if(len <= 0.0f)
+		  {
+		    continue;
+		  }
+		n /= len;
+		glm::vec3 t, b;
+		basis(n, t, b);
+		float turn = (static_cast<uint32_t>(v) * 2654435761u >> 8) * (2.0f * static_cast<float>(M_PI) / 16777216.0f);
+		float c = std::cos(turn), s = std::sin(turn);
+		glm::vec3 origin = m.vertices[v].point + offset * n;
+		int escaped = 0;
+		for(std::size_t i = 0; i < padded; i += 4)
+		  {
+		    unsigned active = 0;
+		    for(unsigned k = 0; k < 4; ++k)
+		      {
+			const glm::vec3 &d = local[i + k];
+			dir[k] = (d.x * c - d.y * s) * t + (d.x * s + d.y * c) * b + d.z * n;
+			if(i + k < std::size_t(rays))
+			  {
+			    active |= 1u << k;
+			  }
+		      }
+		    unsigned hit = bvh.occluded4(origin, dir, reach, active);
+		    for(unsigned k = 0; k < 4; ++k)
+		      {
+			escaped += (active & ~hit) >> k & 1;
+		      }
+		  }
+		open[v] = static_cast<float>(escaped) / rays;
+	      }
+	  }
+      });
+    return open;
+  }
+
+  void colorize(mesh &m, const std::vector<float> &values, bool isSigned)
+  {
+    m.colors.resize(values.size());
+    if(!isSigned)
+      {
+	parallelFor(0, values.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	    for(std::size_t i = lo; i < hi; ++i)
+	      {
+		m.colors[i] = glm::vec3(values[i]);
+	      }
+	  });
+	return;
+      }
+    std::vector<float> magnitude(values.size());
+    for(std::size_t i = 0; i < values.size(); ++i)
+      {
+	magnitude[i] = std::fabs(values[i]);
+      }
+    float scale = 1.0f;
+    if(!magnitude.empty())
+      {
+	auto at = magnitude.begin() + magnitude.size() * 95 / 100;
+	std::nth_element(magnitude.begin(), at, magnitude.end());
+	scale = *at > 0.0f ? *at : 1.0f;
+      }
+    const glm::vec3 white(0.92f), red(0.85f, 0.2f, 0.15f), blue(0.15f, 0.3f, 0.85f);
+    parallelFor(0, values.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    float t = glm::clamp(values[i] / scale, -1.0f, 1.0f);
+	    m.colors[i] = glm::mix(white, t > 0.0f ? red : blue, std::fabs(t));
+	  }
+      });
+  }
+
+  bakeStats bake(mesh &m, bakeKind kind, int rays)
+  {
+    bakeStats stats;
+    auto start = std::chrono::steady_clock::now();
+    auto lap = [&start] {
+      auto now = std::chrono::steady_clock::now();
+      double s = std::chrono::duration<double>(now - start).count();
+      start = now;
+      return s;
+    };
+    if(kind == bakeKind::occlusion)
+      {
+	meshBvh bvh;
+	bvh.build(m);
+	stats.buildSeconds = lap();
+	std::vector<float> open = computeOcclusion(m, bvh, rays);
+	stats.bakeSeconds = lap();
+	stats.rays = m.vertices.size() * std::size_t(std::max(rays, 0));
+	colorize(m, open, false);
+      }
+    else if(kind != bakeKind::none)
+      {
+	meshAdjacency adj = buildAdjacency(m);
+	stats.buildSeconds = lap();
+	std::vector<float> mean, gaussian;
+	computeCurvature(m, adj, mean, gaussian);
+	stats.bakeSeconds = lap();
+	colorize(m, kind == bakeKind::mean ? mean : gaussian, true);
+      }
+    return stats;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,550 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <batch.hpp>
+#include <formats.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace twg {
+
+  static const uint64_t hashPrime32 = 0x9E3779B1ull;
+  static const uint64_t hashPrime64 = 0x9E3779B185EBCA87ull;
+  static const std::size_t stripeBytes = 64, stripesPerBlock = 16;
+
+  // 24 words from splitmix64; stripe s of a block is keyed
+  // with the eight words starting at word s, the scramble with
+  // the last eight
+  alignas(16) static const uint64_t hashKey[24] = {
+    0x3d079d0203a88f28ull, 0xb67efd9582c0e144ull, 0x477f907b59e6084full,
+    0x0d349a4d36b85094ull, 0xf12d482bc646225full, 0x261d202cc0c936bcull,
+    0xaa6586c104b140fdull, 0xdd39bf552926c901ull, 0xc45f6b4705631871ull,
+    0xae892f12b1021ba1ull, 0xdf79d237969dbb68ull, 0x819319a67b86f784ull,
+    0x1ec39854e54c18bcull, 0xf6f654fbe6287d22ull, 0x4b112f70b3fc8a86ull,
+    0xcf4cd8c27e39a538ull, 0x1fa45f89c86afec1ull, 0x40eb5e871b01b7afull,
+    0xee6150d9aff4dfb8ull, 0x632d0fa70b41824dull, 0x09308cfcd2ed6d89ull,
+    0x7611a31c618444a6ull, 0x4d73eb2dff084339ull, 0xf875c0edea1efbcfull,
+  };
+
+#ifdef __SSE2__
+  // Each register holds lanes 2j and 2j+1
+  static void hashStripe(__m128i acc[4], const uint8_t *p, const uint64_t *key)
+  {
+    for(int j = 0; j < 4; ++j)
+      {
+	__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p) + j);
+	__m128i mixed = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i *>(key) + j));
+	__m128i product = _mm_mul_epu32(mixed, _mm_shuffle_epi32(mixed, _MM_SHUFFLE(0, 3, 0, 1)));
+	__m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+	acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(swapped, product));
+      }
+  }
+
+  static void hashScramble(__m128i acc[4])
+  {
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(hashPrime32));
+    for(int j = 0; j < 4; ++j)
+      {
+	__m128i a = _mm_xor_si128(acc[j], _mm_srli_epi64(acc[j], 47));
+	a = _mm_xor_si128(a, _mm_load_si128(reinterpret_cast<const __m128i *>(hashKey + 16) + j));
+	__m128i lo = _mm_mul_epu32(a, prime);
+	__m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+	acc[j] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+      }
+  }
+#else
+  static void hashStripe(uint64_t acc[8], const uint8_t *p, const uint64_t *key)
+  {
+    for(int i = 0; i < 8; ++i)
+      {
+	uint64_t data;
+	std::memcpy(&data, p + 8 * i, 8);
+	uint64_t mixed = data ^ key[i];
+	acc[i ^ 1] += data;
+	acc[i] += (mixed & 0xffffffffu) * (mixed >> 32);
+      }
+  }
+
+  static void hashScramble(uint64_t acc[8])
+  {
+    for(int i = 0; i < 8; ++i)
+      {
+	uint64_t a = acc[i] ^ (acc[i] >> 47);
+	acc[i] = (a ^ hashKey[16 + i]) * hashPrime32;
+      }
+  }
+#endif
+
+  static uint64_t hashFold(uint64_t a, uint64_t b)
+  {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+
+  uint64_t contentHash(const void *data, std::size_t size)
+  {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint64_t lanes[8] = {
+      hashPrime32, hashPrime64, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull,
+      0x85EBCA77C2B2AE63ull, 0x27D4EB2F165667C5ull, 0x61C8864E7A143579ull, hashPrime32 ^ hashPrime64,
+    };
+#ifdef __SSE2__
+    __m128i acc[4];
+    for(int j = 0; j < 4; ++j)
+      {
+	acc[j] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes) + j);
+      }
+#else
+    uint64_t *acc = lanes;
+#endif
+    std::size_t stripes = size / stripeBytes;
+    for(std::size_t s = 0; s < stripes; ++s)
+      {
+	hashStripe(acc, p + s * stripeBytes, hashKey + s % stripesPerBlock);
+	if(s % stripesPerBlock == stripesPerBlock - 1)
+	  {
+	    hashScramble(acc);
+	  }
+      }
+    // The tail is zero padded to a stripe; the length below
+    // tells it apart from real zeros
+    uint8_t tail[stripeBytes] = {};
+    std::memcpy(tail, p + stripes * stripeBytes, size - stripes * stripeBytes);
+    hashStripe(acc, tail, hashKey + 15);
+#ifdef __SSE2__
+    for(int j = 0; j < 4; ++j)
+      {
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes) + j, acc[j]);
+      }
+#endif
+    uint64_t h = size * hashPrime64;
+    for(int i = 0; i < 8; i += 2)
+      {
+	h += hashFold(lanes[i] ^ hashKey[i + 3], lanes[i + 1] ^ hashKey[i + 4]);
+      }
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ull;
+    return h ^ (h >> 32);
+  }
+
+  bool hashFile(const std::string &filename, uint64_t &hash)
+  {
+    mappedFile file{filename};
+    if(!file.good())
+      {
+	return false;
+      }
+    hash = contentHash(file.data(), file.size());
+    return true;
+  }
+
+  // Strips suffix from name when it ends with it, in any case
+  static bool stripSuffix(std::string &name, const char *suffix)
+  {
+    std::size_t n = std::strlen(suffix);
+    if(name.size() <= n)
+      {
+	return false;
+      }
+    for(std::size_t i = 0; i < n; ++i)
+      {
+	if(std::tolower(static_cast<unsigned char>(name[name.size() - n + i])) != suffix[i])
+	  {
+	    return false;
+	  }
+      }
+    name.resize(name.size() - n);
+    return true;
+  }
+
+  std::string outputName(const std::string &dir, const std::string &input,
+			 const std::string &extension, bool keepSource)
+  {
+    std::size_t slash = input.find_last_of('/');
+    std::string base = input.substr(slash == std::string::npos ? 0 : slash + 1);
+    if(!keepSource)
+      {
+	static const char *const compression[] = {".gz", ".zst"};
+	static const char *const formats[] = {".obj", ".mshz", ".stl", ".ply", ".glb", ".gltf"};
+	for(const char *suffix : compression)
+	  {
+	    if(stripSuffix(base, suffix))
+	      {
+		break;
+	      }
+	  }
+	for(const char *suffix : formats)
+	  {
+	    if(stripSuffix(base, suffix))
+	      {
+		break;
+	      }
+	  }
+      }
+    return (dir.empty() ? std::string{"."} : dir) + "/" + base + extension;
+  }
+
+  std::vector<std::string> outputNames(const std::string &dir,
+				       const std::vector<std::string> &inputs,
+				       const std::string &extension)
+  {
+    std::vector<std::string> names(inputs.size());
+    std::unordered_map<std::string, std::size_t> uses;
+    for(std::size_t i = 0; i < inputs.size(); ++i)
+      {
+	names[i] = outputName(dir, inputs[i], extension);
+	++uses[names[i]];
+      }
+    for(std::size_t i = 0; i < inputs.size(); ++i)
+      {
+	if(uses[names[i]] > 1)
+	  {
+	    names[i] = outputName(dir, inputs[i], extension, true);
+	  }
+      }
+    return names;
+  }
+
+  static std::string manifestHeader(const std::string &settings)
+  {
+    return "# meshtool manifest 1 " + settings;
+  }
+
+  bool conversionManifest::load(const std::string &filename, const std::string &settings)
+  {
+    entries.clear();
+    std::ifstream in{filename};
+    if(!in)
+      {
+	return false;
+      }
+    std::string line;
+    if(!std::getline(in, line) || line != manifestHeader(settings))
+      {
+	LOG("[Ok] Manifest "); LOG(filename); LOG(" is for other settings, converting everything\n");
+	return false;
+      }
+    while(std::getline(in, line))
+      {
+	std::string field[7];
+	std::size_t begin = 0;
+	int n = 0;
+	for(; n < 7 && begin <= line.size(); ++n)
+	  {
+	    std::size_t end = std::min(line.find('\t', begin), line.size());
+	    field[n] = line.substr(begin, end - begin);
+	    begin = end + 1;
+	  }
+	if(n != 7 || field[0].empty())
+	  {
+	    continue;
+	  }
+	manifestEntry &e = entries[field[0]];
+	e.size = std::strtoull(field[1].c_str(), nullptr, 10);
+	e.mtime = std::strtoll(field[2].c_str(), nullptr, 10);
+	e.hash = std::strtoull(field[3].c_str(), nullptr, 16);
+	e.output = field[4];
+	e.outputSize = std::strtoull(field[5].c_str(), nullptr, 10);
+	e.outputHash = std::strtoull(field[6].c_str(), nullptr, 16);
+      }
+    return true;
+  }
+
+  bool conversionManifest::save(const std::string &filename, const std::string &settings) const
+  {
+    std::vector<const std::pair<const std::string, manifestEntry> *> sorted;
+    sorted.reserve(entries.size());
+    for(const auto &e : entries)
+      {
+	sorted.push_back(&e);
+      }
+    std::sort(sorted.begin(), sorted.end(),
+	      [](const auto *a, const auto *b) { return a->first < b->first; });
+
+    // Written aside and renamed, so an interrupted run leaves
+    // the old manifest intact
+    std::string temporary = filename + ".tmp";
+    std::FILE *out = std::fopen(temporary.c_str(), "w");
+    if(!out)
+      {
+	LOG("[Error] Cannot open: "); LOG(temporary); LOG("\n");
+	return false;
+      }
+    std::fprintf(out, "%s\n", manifestHeader(settings).c_str());
+    for(const auto *e : sorted)
+      {
+	const manifestEntry &m = e->second;
+	std::fprintf(out, "%s\t%llu\t%lld\t%016llx\t%s\t%llu\t%016llx\n", e->first.c_str(),
+		     static_cast<unsigned long long>(m.size), static_cast<long long>(m.mtime),
+		     static_cast<unsigned long long>(m.hash), m.output.c_str(),
+		     static_cast<unsigned long long>(m.outputSize),
+		     static_cast<unsigned long long>(m.outputHash));
+      }
+    bool ok = std::fclose(out) == 0;
+    if(!ok || std::rename(temporary.c_str(), filename.c_str()) != 0)
+      {
+	LOG("[Error] Failed writing: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    return true;
+  }
+
+  static bool statFile(const std::string &filename, uint64_t &size, int64_t &mtime)
+  {
+    struct stat info;
+    if(::stat(filename.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+      {
+	return false;
+      }
+    size = static_cast<uint64_t>(info.st_size);
+    mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+  }
+
+  static bool sameBytes(const std::string &a, const std::string &b)
+  {
+    mappedFile x{a}, y{b};
+    return x.good() && y.good() && x.size() == y.size()
+      && (x.size() == 0 || std::memcmp(x.data(), y.data(), x.size()) == 0);
+  }
+
+  static bool copyFile(const std::string &from, const std::string &to)
+  {
+    mappedFile in{from};
+    std::FILE *out = in.good() ? std::fopen(to.c_str(), "wb") : nullptr;
+    if(!out)
+      {
+	LOG("[Error] Cannot copy "); LOG(from); LOG(" to "); LOG(to); LOG("\n");
+	return false;
+      }
+    bool ok = in.size() == 0 || std::fwrite(in.data(), 1, in.size(), out) == in.size();
+    return std::fclose(out) == 0 && ok;
+  }
+
+  enum class batchState { failed, unchanged, touched, changed, duplicate };
+
+  struct batchItem {
+    batchState state = batchState::failed;
+    manifestEntry entry;
+    std::size_t source = 0;    // duplicate: the item whose output is copied
+    std::string error;         // why it failed, logged with the results
+    bool unreadable = false;
+  };
+
+  batchStats convertBatch(const std::vector<std::string> &inputs, const batchOptions &options)
+  {
+    batchStats stats;
+    stats.inputs = inputs.size();
+    auto start = std::chrono::steady_clock::now();
+    std::string manifestFile = options.manifest.empty()
+      ? (options.dir.empty() ? std::string{"."} : options.dir) + "/.meshtool-manifest"
+      : options.manifest;
+    conversionManifest manifest;
+    manifest.load(manifestFile, options.settings);
+
+    // Scan: stat everything, hash only what stat cannot vouch for
+    std::vector<batchItem> items(inputs.size());
+    std::vector<std::string> outputs = outputNames(options.dir, inputs, options.extension);
+    std::vector<std::size_t> hashed(workerCount(), 0);
+    parallelFor(0, inputs.size(), [&](std::size_t lo, std::size_t hi, unsigned w) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    batchItem &item = items[i];
+	    manifestEntry &e = item.entry;
+	    e.output = outputs[i];
+	    item.error = "not able to read it";
+	    item.unreadable = true;
+	    if(!statFile(inputs[i], e.size, e.mtime))
+	      {
+		item.error = "not found";
+		continue;
+	      }
+	    auto found = manifest.entries.find(inputs[i]);
+	    const manifestEntry *old = found == manifest.entries.end() ? nullptr : &found->second;
+	    uint64_t outputSize;
+	    int64_t outputTime;
+	    bool outputKept = old && old->output == e.output
+	      && statFile(old->output, outputSize, outputTime) && outputSize == old->outputSize;
+	    if(outputKept && old->size == e.size && old->mtime == e.mtime)
+	      {
+		e = *old;
+		item.state = batchState::unchanged;
+		item.error.clear();
+		item.unreadable = false;
+		continue;
+	      }
+	    if(!hashFile(inputs[i], e.hash))
+	      {
+		continue;
+	      }
+	    hashed[w] += e.size;
+	    item.state = batchState::changed;
+	    item.error.clear();
+	    item.unreadable = false;
+	    if(outputKept && old->hash == e.hash)
+	      {
+		e.outputSize = old->outputSize;
+		e.outputHash = old->outputHash;
+		item.state = batchState::touched;
+	      }
+	  }
+      });
+    for(std::size_t h : hashed)
+      {
+	stats.hashedBytes += h;
+      }
+
+    // Two inputs may not write the same output; identical
+    // changed inputs share one conversion, preferring an
+    // output that already exists from this or a past run
+    std::unordered_map<std::string, std::size_t> writers;
+    std::unordered_map<uint64_t, std::size_t> settled, primaries;
+    for(std::size_t i = 0; i < items.size(); ++i)
+      {
+	batchItem &item = items[i];
+	if(item.state == batchState::failed)
+	  {
+	    continue;
+	  }
+	auto writer = writers.emplace(item.entry.output, i);
+	if(!writer.second)
+	  {
+	    item.error = "writes " + item.entry.output + " too, like "
+	      + inputs[writer.first->second];
+	    item.state = batchState::failed;
+	  }
+	else if(item.state != batchState::changed)
+	  {
+	    settled.emplace(item.entry.hash, i);
+	  }
+      }
+    const std::size_t none = ~std::size_t(0);
+    auto identical = [&](const std::unordered_map<uint64_t, std::size_t> &known, std::size_t i) {
+      auto found = known.find(items[i].entry.hash);
+      return found != known.end() && items[found->second].entry.size == items[i].entry.size
+	&& sameBytes(inputs[i], inputs[found->second]) ? found->second : none;
+    };
+    std::vector<std::size_t> converts, copies;
+    for(std::size_t i = 0; i < items.size(); ++i)
+      {
+	batchItem &item = items[i];
+	if(item.state != batchState::changed)
+	  {
+	    continue;
+	  }
+	std::size_t source = identical(settled, i);
+	if(source == none)
+	  {
+	    source = identical(primaries, i);
+	  }
+	if(source == none)
+	  {
+	    primaries.emplace(item.entry.hash, i);
+	    converts.push_back(i);
+	  }
+	else
+	  {
+	    item.state = batchState::duplicate;
+	    item.source = source;
+	    copies.push_back(i);
+	  }
+      }
+    auto scanned = std::chrono::steady_clock::now();
+    stats.scanSeconds = std::chrono::duration<double>(scanned - start).count();
+
+    // One task per conversion rather than parallelFor ranges:
+    // input sizes in a library vary by orders of magnitude
+    threadPool &pool = threadPool::shared();
+    taskGroup converting, copying;
+    for(std::size_t i : converts)
+      {
+	pool.run(converting, [&, i] {
+	    manifestEntry &e = items[i].entry;
+	    mesh m;
+	    int64_t written;
+	    // The loaders log in pieces; print each input's lines whole
+	    std::ostringstream log;
+	    std::ostream *sink = logSink;
+	    logSink = &log;
+	    if(!options.load(inputs[i], m))
+	      {
+		items[i].state = batchState::failed;
+		items[i].error = "not able to load it";
+		items[i].unreadable = true;
+	      }
+	    else if(!options.save(m, e.output) || !statFile(e.output, e.outputSize, written)
+		    || !hashFile(e.output, e.outputHash))
+	      {
+		items[i].state = batchState::failed;
+		items[i].error = "not able to write " + e.output;
+	      }
+	    logSink = sink;
+	    LOG(log.str());
+	  });
+      }
+    pool.wait(converting);
+    for(std::size_t i : copies)
+      {
+	pool.run(copying, [&, i] {
+	    batchItem &item = items[i];
+	    const batchItem &source = items[item.source];
+	    if(source.state == batchState::failed || !copyFile(source.entry.output, item.entry.output))
+	      {
+		item.state = batchState::failed;
+		item.error = source.state == batchState::failed
+		  ? "its identical input " + inputs[item.source] + " failed"
+		  : "not able to copy to " + item.entry.output;
+		return;
+	      }
+	    item.entry.outputSize = source.entry.outputSize;
+	    item.entry.outputHash = source.entry.outputHash;
+	  });
+      }
+    pool.wait(copying);
+    stats.convertSeconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - scanned).count();
+
+    for(std::size_t i = 0; i < items.size(); ++i)
+      {
+	switch(items[i].state)
+	  {
+	  case batchState::failed:
+	    ++stats.failed;
+	    stats.unreadable += items[i].unreadable ? 1 : 0;
+	    LOG("[Error] "); LOG(inputs[i]); LOG(": "); LOG(items[i].error); LOG("\n");
+	    manifest.entries.erase(inputs[i]);
+	    continue;
+	  case batchState::unchanged:
+	    ++stats.unchanged;
+	    continue;
+	  case batchState::touched:
+	    ++stats.touched;
+	    break;
+	  case batchState::changed:
+	    ++stats.converted;
+	    break;
+	  case batchState::duplicate:
+	    ++stats.duplicates;
+	    break;
+	  }
+	manifest.entries[inputs[i]] = items[i].entry;
+      }
+    manifest.save(manifestFile, options.settings);
+    return stats;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,625 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <bench.hpp>
+#include <voxel.hpp>
+#include <isosurface.hpp>
+#include <weld.hpp>
+#include <adjacency.hpp>
+#include <subdivision.hpp>
+#include <bake.hpp>
+#include <codec.hpp>
+#include <formats.hpp>
+#include <gltf.hpp>
+#include <materials.hpp>
+#include <headless.hpp>
+#include <cstdio>
+
+namespace twg {
+
+  template <typename F>
+  static double timeSeconds(F fn)
+  {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+  }
+
+  /**
+   * Voxelize each input at 256^3 up to 4096^3, surface and
+   * solid.
+   */
+  static int benchVoxel(const std::vector<std::string> &inputs)
+  {
+    for(const std::string &file : inputs)
+      {
+	mesh m = loadObject(file);
+	for(uint32_t res = 256; res <= 4096; res <<= 1)
+	  {
+	    for(voxelMode mode : {voxelMode::surface, voxelMode::solid})
+	      {
+		sparseVoxelOctree tree;
+		double s = timeSeconds([&] { tree = voxelize(m, res, mode); });
+		std::cout << "voxel " << file << " res=" << res
+			  << " mode=" << (mode == voxelMode::solid ? "solid" : "surface")
+			  << " ms=" << s * 1e3
+			  << " voxels=" << tree.voxelCount()
+			  << " bricks=" << tree.brickCount()
+			  << " nodes=" << tree.nodes.size()
+			  << " bytes=" << tree.memoryBytes() << "\n";
+	      }
+	  }
+      }
+    return 0;
+  }
+
+  /**
+   * Extract a 512^3 analytic field (a sphere with a gyroid
+   * ripple) with both methods, then the solid voxelization of
+   * each input at 512^3.  Rates are in grid cells per second;
+   * the edge counts, taken outside the timing, check the
+   * output stays a manifold.
+   */
+  static int benchIsosurface(const std::vector<std::string> &inputs)
+  {
+    const int n = 512;
+    denseVolume v;
+    v.dims = glm::ivec3(n);
+    v.spacing = 2.0f / (n - 1);
+    v.origin = glm::vec3(-1.0f);
+    v.values.resize(std::size_t(n) * n * n);
+    parallelFor(0, std::size_t(n) * n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  for(int x = 0; x < n; ++x)
+	    {
+	      glm::vec3 p = v.origin + v.spacing * glm::vec3(x, i % n, i / n);
+	      glm::vec3 q = 12.0f * p;
+	      float ripple = std::sin(q.x) * std::cos(q.y) + std::sin(q.y) * std::cos(q.z)
+		+ std::sin(q.z) * std::cos(q.x);
+	      v.values[i * n + x] = glm::length(p) - 0.8f + 0.03f * ripple;
+	    }
+      });
+    double cells = std::pow(double(n - 1), 3);
+    auto report = [&](const std::string &name, const char *method, double s,
+		      const mesh &m) {
+      std::cout << "isosurface " << name << " method=" << method
+		<< " ms=" << s * 1e3 << " cells_per_s=" << cells / s
+		<< " vertices=" << m.vertices.size()
+		<< " triangles=" << m.elements.size() / 3;
+      meshAdjacency adj = buildAdjacency(m);
+      std::cout << " boundary_edges=" << adj.boundaryEdges
+		<< " non_manifold_edges=" << adj.nonManifoldEdges << "\n";
+    };
+    for(isoMethod method : {isoMethod::marchingCubes, isoMethod::dualContouring})
+      {
+	const char *label = method == isoMethod::marchingCubes ? "mc" : "dc";
+	mesh m;
+	double s = timeSeconds([&] { m = extractIsosurface(v, 0.0f, method); });
+	report("sdf512", label, s, m);
+      }
+    for(const std::string &file : inputs)
+      {
+	sparseVoxelOctree tree = voxelize(loadObject(file), n, voxelMode::solid);
+	for(isoMethod method : {isoMethod::marchingCubes, isoMethod::dualContouring})
+	  {
+	    const char *label = method == isoMethod::marchingCubes ? "mc" : "dc";
+	    mesh m;
+	    double s = timeSeconds([&] { m = extractIsosurface(tree, method); });
+	    report(file, label, s, m);
+	  }
+      }
+    return 0;
+  }
+
+  /**
+   * Give every triangle corner its own vertex, the way STL and
+   * many exporters store meshes.
+   */
+  static mesh explode(const mesh &m)
+  {
+    mesh out;
+    out.vertices.resize(m.elements.size());
+    out.elements.resize(m.elements.size());
+    for(std::size_t i = 0; i < m.elements.size(); ++i)
+      {
+	out.vertices[i] = m.vertices[m.elements[i]];
+	out.elements[i] = static_cast<GLuint>(i);
+      }
+    return out;
+  }
+
+  /**
+   * Weld exploded copies of each input and of a 256^3 sphere
+   * isosurface (about 1.2 million corners).
+   */
+  static int benchWeld(const std::vector<std::string> &inputs)
+  {
+    std::vector<std::pair<std::string, mesh>> meshes;
+    for(const std::string &file : inputs)
+      {
+	meshes.emplace_back(file, loadObject(file));
+      }
+    const int n = 256;
+    denseVolume v;
+    v.dims = glm::ivec3(n);
+    v.spacing = 2.0f / (n - 1);
+    v.origin = glm::vec3(-1.0f);
+    v.values.resize(std::size_t(n) * n * n);
+    for(std::size_t i = 0; i < v.values.size(); ++i)
+      {
+	glm::vec3 p = v.origin + v.spacing * glm::vec3(i % n, (i / n) % n, i / (std::size_t(n) * n));
+	v.values[i] = glm::length(p) - 0.8f;
+      }
+    meshes.emplace_back("sphere256", extractIsosurface(v, 0.0f, isoMethod::marchingCubes));
+    for(auto &entry : meshes)
+      {
+	mesh m = explode(entry.second);
+	weldStats s = weldVertices(m, 1e-6f);
+	std::cout << "weld " << entry.first << " before=" << s.verticesBefore
+		  << " after=" << s.verticesAfter
+		  << " reduction=" << double(s.verticesBefore) / std::max<std::size_t>(s.verticesAfter, 1)
+		  << " ms=" << s.seconds * 1e3
+		  << " ms_per_million=" << s.msPerMillion() << "\n";
+      }
+    return 0;
+  }
+
+  /**
+   * Closed torus of 2 * n * n triangles on an n x n grid.
+   */
+  static mesh torusGrid(uint32_t n)
+  {
+    mesh m;
+    m.vertices.resize(std::size_t(n) * n);
+    m.elements.resize(std::size_t(n) * n * 6);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t j = lo; j < hi; ++j)
+	  for(uint32_t i = 0; i < n; ++i)
+	    {
+	      float u = 2.0f * M_PI * i / n, v = 2.0f * M_PI * j / n;
+	      glm::vec3 normal(std::cos(u) * std::cos(v), std::sin(v), std::sin(u) * std::cos(v));
+	      glm::vec3 ring(std::cos(u), 0.0f, std::sin(u));
+	      m.vertices[j * n + i] = Vertex{ring + 0.3f * normal, normal};
+	      GLuint a = j * n + i, b = j * n + (i + 1) % n;
+	      GLuint c = ((j + 1) % n) * n + (i + 1) % n, d = ((j + 1) % n) * n + i;
+	      GLuint *e = &m.elements[(j * n + i) * 6];
+	      e[0] = a; e[1] = d; e[2] = c;
+	      e[3] = a; e[4] = c; e[5] = b;
+	    }
+      });
+    return m;
+  }
+
+  /**
+   * Build adjacency for each input and for tori from 131K to
+   * 10.6M triangles.
+   */
+  static int benchAdjacency(const std::vector<std::string> &inputs)
+  {
+    auto run = [](const std::string &name, const mesh &m) {
+      meshAdjacency adj;
+      double s = timeSeconds([&] { adj = buildAdjacency(m); });
+      std::size_t triangles = m.elements.size() / 3;
+      std::cout << "adjacency " << name << " triangles=" << triangles
+		<< " ms=" << s * 1e3
+		<< " ns_per_triangle=" << s * 1e9 / std::max<std::size_t>(triangles, 1)
+		<< " bytes_per_triangle=" << double(adj.memoryBytes()) / std::max<std::size_t>(triangles, 1)
+		<< " boundary_edges=" << adj.boundaryEdges
+		<< " non_manifold_edges=" << adj.nonManifoldEdges << "\n";
+    };
+    for(const std::string &file : inputs)
+      {
+	run(file, loadObject(file));
+      }
+    for(uint32_t n : {256u, 1024u, 2304u})
+      {
+	run("torus" + std::to_string(n), torusGrid(n));
+      }
+    return 0;
+  }
+
+  /**
+   * Uniform Loop subdivision of each input and a 8K triangle
+   * torus, 1 to 4 levels, then adaptive levels on the torus
+   * seen close up at 1920x1080.
+   */
+  static int benchSubdivision(const std::vector<std::string> &inputs)
+  {
+    auto run = [](const std::string &name, const mesh &cage,
+		  const subdivisionOptions &options, const char *mode) {
+      mesh m = cage;
+      subdivisionStats s = subdivide(m, options);
+      std::cout << "subdivision " << name << " mode=" << mode
+		<< " levels=" << s.levels
+		<< " triangles_in=" << s.trianglesBefore
+		<< " triangles_out=" << s.trianglesAfter
+		<< " ms=" << s.seconds * 1e3
+		<< " triangles_per_s_per_core=" << s.trianglesPerSecondPerCore()
+		<< " workers=" << workerCount() << "\n";
+    };
+    std::vector<std::pair<std::string, mesh>> meshes;
+    for(const std::string &file : inputs)
+      {
+	mesh m = loadObject(file);
+	weldVertices(m, 1e-6f);
+	smoothNormals(m);
+	meshes.emplace_back(file, std::move(m));
+      }
+    meshes.emplace_back("torus64", torusGrid(64));
+    for(const auto &entry : meshes)
+      {
+	for(int levels = 1; levels <= 4; ++levels)
+	  {
+	    subdivisionOptions options;
+	    options.levels = levels;
+	    run(entry.first, entry.second, options, "uniform");
+	  }
+      }
+    subdivisionOptions options;
+    options.levels = 6;
+    options.viewport = glm::vec2(1920.0f, 1080.0f);
+    options.viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+      * glm::lookAt(glm::vec3(1.0f, 0.2f, 0.6f), glm::vec3(1.0f, 0.0f, -1.0f),
+		    glm::vec3(0.0f, 1.0f, 0.0f));
+    for(float pixels : {32.0f, 8.0f})
+      {
+	options.maxEdgePixels = pixels;
+	run("torus64", meshes.back().second, options,
+	    pixels > 8.0f ? "adaptive32px" : "adaptive8px");
+      }
+    return 0;
+  }
+
+  /**
+   * Curvature and 64 ray ambient occlusion for each input and
+   * for tori of 65K and 1M vertices.
+   */
+  static int benchBake(const std::vector<std::string> &inputs)
+  {
+    auto run = [](const std::string &name, const mesh &source) {
+      for(bakeKind kind : {bakeKind::mean, bakeKind::occlusion})
+	{
+	  mesh m = source;
+	  bakeStats s = bake(m, kind, 64);
+	  std::cout << "bake " << name << " kind=" << (kind == bakeKind::mean ? "curvature" : "ao")
+		    << " vertices=" << m.vertices.size()
+		    << " triangles=" << m.elements.size() / 3
+		    << " build_ms=" << s.buildSeconds * 1e3
+		    << " bake_ms=" << s.bakeSeconds * 1e3;
+	  if(s.rays > 0)
+	    {
+	      std::cout << " rays=" << s.rays
+			<< " mrays_per_s=" << s.raysPerSecond() * 1e-6
+			<< " mrays_per_s_per_core=" << s.raysPerSecond() * 1e-6 / workerCount();
+	    }
+	  std::cout << " workers=" << workerCount() << "\n";
+	}
+    };
+    for(const std::string &file : inputs)
+      {
+	mesh m = loadObject(file);
+	weldVertices(m, 1e-6f);
+	smoothNormals(m);
+	run(file, m);
+      }
+    for(uint32_t n : {256u, 1024u})
+      {
+	run("torus" + std::to_string(n), torusGrid(n));
+      }
+    return 0;
+  }
+
+  /**
+   * Encode and decode the vertex and index buffers of each
+   * input, a 2M triangle torus and a sphere isosurface.
+   * Decode rates are raw (decoded) bytes per second.
+   */
+  static int benchCodec(const std::vector<std::string> &inputs)
+  {
+    std::vector<std::pair<std::string, mesh>> meshes;
+    for(const std::string &file : inputs)
+      {
+	meshes.emplace_back(file, loadObject(file));
+      }
+    meshes.emplace_back("torus1024", torusGrid(1024));
+    const int n = 256;
+    denseVolume v;
+    v.dims = glm::ivec3(n);
+    v.spacing = 2.0f / (n - 1);
+    v.origin = glm::vec3(-1.0f);
+    v.values.resize(std::size_t(n) * n * n);
+    for(std::size_t i = 0; i < v.values.size(); ++i)
+      {
+	glm::vec3 p = v.origin + v.spacing * glm::vec3(i % n, (i / n) % n, i / (std::size_t(n) * n));
+	v.values[i] = glm::length(p) - 0.8f;
+      }
+    meshes.emplace_back("sphere256", extractIsosurface(v, 0.0f, isoMethod::marchingCubes));
+
+    const int rounds = 5;
+    for(auto &entry : meshes)
+      {
+	const mesh &m = entry.second;
+	std::size_t vertexRaw = m.vertices.size() * sizeof(Vertex);
+	std::size_t indexRaw = m.elements.size() * sizeof(GLuint);
+	std::vector<uint8_t> vertexData, indexData;
+	double vertexEncode = timeSeconds([&] {
+	    vertexData = encodeVertexBuffer(m.vertices.data(), m.vertices.size(), sizeof(Vertex));
+	  });
+	double indexEncode = timeSeconds([&] { indexData = encodeIndexBuffer(m.elements); });
+	std::vector<Vertex> vertices(m.vertices.size());
+	std::vector<GLuint> elements;
+	bool ok = true;
+	double vertexDecode = timeSeconds([&] {
+	    for(int r = 0; r < rounds; ++r)
+	      {
+		ok &= decodeVertexBuffer(vertexData.data(), vertexData.size(), vertices.data(),
+					 vertices.size(), sizeof(Vertex));
+	      }
+	  }) / rounds;
+	double indexDecode = timeSeconds([&] {
+	    for(int r = 0; r < rounds; ++r)
+	      {
+		ok &= decodeIndexBuffer(indexData.data(), indexData.size(), elements);
+	      }
+	  }) / rounds;
+	ok &= std::memcmp(vertices.data(), m.vertices.data(), vertexRaw) == 0;
+	ok &= elements.size() == m.elements.size();
+	for(std::size_t t = 0; ok && t < elements.size(); t += 3)
+	  {
+	    // Triangles may come back rotated
+	    bool same = false;
+	    for(int r = 0; r < 3; ++r)
+	      {
+		same |= elements[t] == m.elements[t + r]
+		  && elements[t + 1] == m.elements[t + (r + 1) % 3]
+		  && elements[t + 2] == m.elements[t + (r + 2) % 3];
+	      }
+	    ok &= same;
+	  }
+	std::cout << "codec " << entry.first << " ok=" << ok
+		  << " vertex_ratio=" << double(vertexRaw) / vertexData.size()
+		  << " vertex_encode_ms=" << vertexEncode * 1e3
+		  << " vertex_decode_gbps=" << vertexRaw / vertexDecode * 1e-9
+		  << " index_ratio=" << double(indexRaw) / indexData.size()
+		  << " index_bits_per_triangle=" << 8.0 * indexData.size() / std::max<std::size_t>(m.elements.size() / 3, 1)
+		  << " index_encode_ms=" << indexEncode * 1e3
+		  << " index_decode_gbps=" << indexRaw / indexDecode * 1e-9 << "\n";
+      }
+    return 0;
+  }
+
+  /**
+   * Load binary STL, PLY and glTF: each such input, and a 2M
+   * triangle torus written to the temporary directory.  Files
+   * are read once first so the page cache is warm; MB/s is
+   * file bytes per second, against a plain fread of the file.
+   */
+  static int benchImport(const std::vector<std::string> &inputs)
+  {
+    std::vector<std::string> files;
+    std::vector<std::string> scratch;
+    for(const std::string &file : inputs)
+      {
+	meshFormat format = detectFormat(file);
+	if(format == meshFormat::stl || format == meshFormat::ply || format == meshFormat::gltf)
+	  {
+	    files.push_back(file);
+	  }
+      }
+    mesh torus = torusGrid(1024);
+    const char *dir = std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "/tmp";
+    for(const char *ext : {".stl", ".ply", ".glb"})
+      {
+	std::string name = std::string(dir) + "/meshtool_bench_torus1024" + ext;
+	bool ok = ext[1] == 's' ? saveStl(torus, name) : ext[1] == 'p' ? savePly(torus, name)
+	  : saveGlb(torus, name);
+	if(ok)
+	  {
+	    files.push_back(name);
+	    scratch.push_back(name);
+	  }
+      }
+
+    const int rounds = 3;
+    for(const std::string &file : files)
+      {
+	meshFormat format = detectFormat(file);
+	// glTF is timed as far as the view handed to glBufferData
+	gltfAsset asset;
+	auto load = [&](mesh &m) {
+	  if(format == meshFormat::gltf)
+	    {
+	      bool loaded = asset.load(file);
+	      m.vertices.resize(asset.view().vertexCount);
+	      m.elements.resize(asset.view().elementCount);
+	      return loaded;
+	    }
+	  return format == meshFormat::stl ? loadStl(file, m) : loadPly(file, m);
+	};
+	mesh m;
+	bool ok = load(m);
+	double s = timeSeconds([&] {
+	    for(int r = 0; r < rounds; ++r)
+	      {
+		mesh loaded;
+		ok &= load(loaded);
+	      }
+	  }) / rounds;
+	std::size_t bytes = 0;
+	double raw = timeSeconds([&] {
+	    for(int r = 0; r < rounds; ++r)
+	      {
+		if(std::FILE *f = std::fopen(file.c_str(), "rb"))
+		  {
+		    std::fseek(f, 0, SEEK_END);
+		    bytes = static_cast<std::size_t>(std::ftell(f));
+		    std::rewind(f);
+		    std::vector<char> buffer(bytes);
+		    bytes = std::fread(buffer.data(), 1, bytes, f);
+		    std::fclose(f);
+		  }
+	      }
+	  }) / rounds;
+	std::size_t triangles = m.elements.size() / 3;
+	const char *name = format == meshFormat::stl ? "stl" : format == meshFormat::ply ? "ply"
+	  : asset.zeroCopy() ? "gltf_zero_copy" : "gltf";
+	std::cout << "import " << file << " ok=" << ok << " format=" << name
+		  << " triangles=" << triangles << " vertices=" << m.vertices.size()
+		  << " ms=" << s * 1e3 << " mb_per_s=" << bytes / s * 1e-6
+		  << " raw_read_mb_per_s=" << bytes / raw * 1e-6
+		  << " mtriangles_per_s=" << triangles / s * 1e-6 << "\n";
+      }
+    for(const std::string &file : scratch)
+      {
+	std::remove(file.c_str());
+      }
+    return 0;
+  }
+
+  /**
+   * Draw multi-material meshes headless, batched through the
+   * material uniform buffer against one draw per range: each
+   * input with materials, and a 524K triangle torus whose faces
+   * are scattered over 600 materials.  Frame time includes
+   * glFinish.
+   */
+  static int benchMaterials(const std::vector<std::string> &inputs)
+  {
+    std::vector<std::pair<std::string, mesh>> meshes;
+    for(const std::string &file : inputs)
+      {
+	mesh m = loadObject(file);
+	if(!m.materials.empty())
+	  {
+	    meshes.emplace_back(file, std::move(m));
+	  }
+      }
+    mesh torus = torusGrid(512);
+    torus.materials.resize(600);
+    std::vector<GLuint> faceMaterial(torus.elements.size() / 3);
+    for(std::size_t t = 0; t < faceMaterial.size(); ++t)
+      {
+	faceMaterial[t] = static_cast<GLuint>((t * 2654435761u >> 7) % torus.materials.size());
+	torus.materials[faceMaterial[t]].diffuse = glm::vec3((t % 7) / 7.0f, (t % 5) / 5.0f, 0.5f);
+      }
+    groupByMaterial(torus, faceMaterial);
+    meshes.emplace_back("torus512", std::move(torus));
+
+    headlessContext context;
+    offscreenRenderer target;
+    if(!context.init() || !target.init(1024, 1024))
+      {
+	return 1;
+      }
+    Program program{"shaders/material.vs", "shaders/material.fs"};
+    glUseProgram(program.ID);
+    glm::mat4 identity(1.0f);
+    glm::mat3 normal(1.0f);
+    glUniformMatrix4fv(glGetUniformLocation(program.ID, "mvpM"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(program.ID, "mvM"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix3fv(glGetUniformLocation(program.ID, "nM"), 1, GL_FALSE, glm::value_ptr(normal));
+
+    const int frames = 30;
+    for(auto &entry : meshes)
+      {
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	materialDraw batches;
+	batches.upload(entry.second, program.ID);
+	target.bind();
+	auto run = [&](bool perRange) {
+	  glFinish();
+	  return timeSeconds([&] {
+	      for(int f = 0; f < frames; ++f)
+		{
+		  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		  if(perRange)
+		    {
+		      batches.drawPerRange();
+		    }
+		  else
+		    {
+		      batches.draw();
+		    }
+		  glFinish();
+		}
+	    }) / frames;
+	};
+	run(false);
+	double batched = run(false);
+	std::size_t batchedDraws = batches.draws, batchedChanges = batches.stateChanges;
+	double perRange = run(true);
+	std::cout << "materials " << entry.first << " materials=" << batches.materialCount()
+		  << " ranges=" << batches.rangeCount()
+		  << " triangles=" << entry.second.elements.size() / 3
+		  << " batched_draws=" << batchedDraws
+		  << " batched_state_changes=" << batchedChanges
+		  << " batched_frame_ms=" << batched * 1e3
+		  << " per_range_draws=" << batches.draws
+		  << " per_range_state_changes=" << batches.stateChanges
+		  << " per_range_frame_ms=" << perRange * 1e3 << "\n";
+	batches.release();
+	glDeleteVertexArrays(1, &vao);
+      }
+    glDeleteProgram(program.ID);
+    target.release();
+    context.release();
+    return 0;
+  }
+
+  int runBenchmark(const std::string &kind,
+		   const std::vector<std::string> &inputs)
+  {
+    std::vector<std::string> files = inputs;
+    if(files.empty())
+      {
+	files.push_back("meshes/suzanne.obj");
+      }
+    if(kind == "voxel")
+      {
+	return benchVoxel(files);
+      }
+    if(kind == "isosurface")
+      {
+	return benchIsosurface(files);
+      }
+    if(kind == "weld")
+      {
+	return benchWeld(files);
+      }
+    if(kind == "adjacency")
+      {
+	return benchAdjacency(files);
+      }
+    if(kind == "codec")
+      {
+	return benchCodec(files);
+      }
+    if(kind == "import")
+      {
+	return benchImport(files);
+      }
+    if(kind == "materials")
+      {
+	return benchMaterials(files);
+      }
+    if(kind == "subdivision")
+      {
+	return benchSubdivision(files);
+      }
+    if(kind == "bake")
+      {
+	return benchBake(files);
+      }
+    LOG("[Error] Unknown benchmark: "); LOG(kind); LOG("\n");
+    return 1;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,235 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <bvh.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cfloat>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace twg {
+
+  struct bvhBuild {
+    std::vector<bvhNode> &nodes;
+    std::vector<uint32_t> &order;
+    const std::vector<glm::vec3> &lo, &hi, &centroid;
+
+    uint32_t node(std::size_t begin, std::size_t end)
+    {
+      uint32_t index = static_cast<uint32_t>(nodes.size());
+      nodes.push_back(bvhNode{});
+      glm::vec3 boxLo{FLT_MAX}, boxHi{-FLT_MAX}, cLo{FLT_MAX}, cHi{-FLT_MAX};
+      for(std::size_t i = begin; i < end; ++i)
+	{
+	  uint32_t t = order[i];
+	  boxLo = glm::min(boxLo, lo[t]);
+	  boxHi = glm::max(boxHi, hi[t]);
+	  cLo = glm::min(cLo, centroid[t]);
+	  cHi = glm::max(cHi, centroid[t]);
+	}
+      nodes[index].lo = boxLo;
+      nodes[index].hi = boxHi;
+      if(end - begin <= meshBvh::leafSize)
+	{
+	  nodes[index].first = static_cast<uint32_t>(begin);
+	  nodes[index].count = static_cast<uint32_t>(end - begin);
+	  return index;
+	}
+      glm::vec3 extent = cHi - cLo;
+      int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+      std::size_t mid = begin + (end - begin) / 2;
+      std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+		       [&](uint32_t a, uint32_t b) { return centroid[a][axis] < centroid[b][axis]; });
+      node(begin, mid);
+      uint32_t right = node(mid, end);
+      nodes[index].first = right;
+      nodes[index].count = 0;
+      return index;
+    }
+  };
+
+  void meshBvh::build(const mesh &m)
+  {
+    std::size_t count = m.elements.size() / 3;
+    std::vector<glm::vec3> lo(count), hi(count), centroid(count);
+    std::vector<uint32_t> order(count);
+    parallelFor(0, count, [&](std::size_t begin, std::size_t end, unsigned) {
+	for(std::size_t t = begin; t < end; ++t)
+	  {
+	    const glm::vec3 &a = m.vertices[m.elements[3 * t]].point;
+	    const glm::vec3 &b = m.vertices[m.elements[3 * t + 1]].point;
+	    const glm::vec3 &c = m.vertices[m.elements[3 * t + 2]].point;
+	    lo[t] = glm::min(a, glm::min(b, c));
+	    hi[t] = glm::max(a, glm::max(b, c));
+	    centroid[t] = (a + b + c) / 3.0f;
+	    order[t] = static_cast<uint32_t>(t);
+	  }
+      });
+    nodes.clear();
+    nodes.reserve(count > 0 ? 2 * count / leafSize + 1 : 0);
+    if(count > 0)
+      {
+	bvhBuild{nodes, order, lo, hi, centroid}.node(0, count);
+      }
+    triangles.resize(count);
+    parallelFor(0, count, [&](std::size_t begin, std::size_t end, unsigned) {
+	for(std::size_t i = begin; i < end; ++i)
+	  {
+	    std::size_t t = order[i];
+	    const glm::vec3 &a = m.vertices[m.elements[3 * t]].point;
+	    const glm::vec3 &b = m.vertices[m.elements[3 * t + 1]].point;
+	    const glm::vec3 &c = m.vertices[m.elements[3 * t + 2]].point;
+	    triangles[i] = bvhTriangle{a, b - a, c - a};
+	  }
+      });
+  }
+
+  bool meshBvh::occluded(const glm::vec3 &origin, const glm::vec3 &dir, float tMax) const
+  {
+    if(nodes.empty())
+      {
+	return false;
+      }
+    glm::vec3 inv = 1.0f / dir;
+    uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while(top > 0)
+      {
+	const bvhNode &n = nodes[stack[--top]];
+	glm::vec3 t1 = (n.lo - origin) * inv, t2 = (n.hi - origin) * inv;
+	glm::vec3 tNear = glm::min(t1, t2), tFar = glm::max(t1, t2);
+	float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+	if(enter > exit)
+	  {
+	    continue;
+	  }
+	if(n.count == 0)
+	  {
+	    stack[top++] = n.first;
+	    stack[top++] = static_cast<uint32_t>(&n - nodes.data()) + 1;
+	    continue;
+	  }
+	for(uint32_t i = n.first; i < n.first + n.count; ++i)
+	  {
+	    const bvhTriangle &tri = triangles[i];
+	    glm::vec3 p = glm::cross(dir, tri.e2);
+	    float det = glm::dot(tri.e1, p);
+	    if(std::fabs(det) < 1e-12f)
+	      {
+		continue;
+	      }
+	    float invDet = 1.0f / det;
+	    glm::vec3 s = origin - tri.v0;
+	    float u = glm::dot(s, p) * invDet;
+	    glm::vec3 q = glm::cross(s, tri.e1);
+	    float v = glm::dot(dir, q) * invDet;
+	    float t = glm::dot(tri.e2, q) * invDet;
+	    if(u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < tMax)
+	      {
+		return true;
+	      }
+	  }
+      }
+    return false;
+  }
+
+  unsigned meshBvh::occluded4(const glm::vec3 &origin, const glm::vec3 dir[4],
+			      float tMax, unsigned active) const
+  {
+#ifdef __SSE__
+    if(nodes.empty())
+      {
+	return 0;
+      }
+    __m128 dx = _mm_setr_ps(dir[0].x, dir[1].x, dir[2].x, dir[3].x);
+    __m128 dy = _mm_setr_ps(dir[0].y, dir[1].y, dir[2].y, dir[3].y);
+    __m128 dz = _mm_setr_ps(dir[0].z, dir[1].z, dir[2].z, dir[3].z);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 ix = _mm_div_ps(one, dx), iy = _mm_div_ps(one, dy), iz = _mm_div_ps(one, dz);
+    __m128 zero = _mm_setzero_ps(), far = _mm_set1_ps(tMax);
+    unsigned hit = 0;
+    uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while(top > 0)
+      {
+	const bvhNode &n = nodes[stack[--top]];
+	// Slabs: the origin is shared, so lo - origin is a scalar
+	__m128 ax = _mm_mul_ps(_mm_set1_ps(n.lo.x - origin.x), ix);
+	__m128 bx = _mm_mul_ps(_mm_set1_ps(n.hi.x - origin.x), ix);
+	__m128 ay = _mm_mul_ps(_mm_set1_ps(n.lo.y - origin.y), iy);
+	__m128 by = _mm_mul_ps(_mm_set1_ps(n.hi.y - origin.y), iy);
+	__m128 az = _mm_mul_ps(_mm_set1_ps(n.lo.z - origin.z), iz);
+	__m128 bz = _mm_mul_ps(_mm_set1_ps(n.hi.z - origin.z), iz);
+	__m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(ax, bx), _mm_min_ps(ay, by)),
+				  _mm_max_ps(_mm_min_ps(az, bz), zero));
+	__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(ax, bx), _mm_max_ps(ay, by)),
+				 _mm_min_ps(_mm_max_ps(az, bz), far));
+	if(!(_mm_movemask_ps(_mm_cmple_ps(enter, exit)) & active & ~hit))
+	  {
+	    continue;
+	  }
+	if(n.count == 0)
+	  {
+	    stack[top++] = n.first;
+	    stack[top++] = static_cast<uint32_t>(&n - nodes.data()) + 1;
+	    continue;
+	  }
+	for(uint32_t i = n.first; i < n.first + n.count; ++i)
+	  {
+	    const bvhTriangle &tri = triangles[i];
+	    // Origin terms once per triangle, direction terms per lane
+	    glm::vec3 s = origin - tri.v0;
+	    glm::vec3 q = glm::cross(s, tri.e1);
+	    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, _mm_set1_ps(tri.e2.z)),
+				   _mm_mul_ps(dz, _mm_set1_ps(tri.e2.y)));
+	    __m128 py = _mm_sub_ps(_mm_mul_ps(dz, _mm_set1_ps(tri.e2.x)),
+				   _mm_mul_ps(dx, _mm_set1_ps(tri.e2.z)));
+	    __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, _mm_set1_ps(tri.e2.y)),
+				   _mm_mul_ps(dy, _mm_set1_ps(tri.e2.x)));
+	    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(tri.e1.x)),
+					       _mm_mul_ps(py, _mm_set1_ps(tri.e1.y))),
+				    _mm_mul_ps(pz, _mm_set1_ps(tri.e1.z)));
+	    __m128 invDet = _mm_div_ps(one, det);
+	    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(s.x)),
+							_mm_mul_ps(py, _mm_set1_ps(s.y))),
+					     _mm_mul_ps(pz, _mm_set1_ps(s.z))), invDet);
+	    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(q.x)),
+							_mm_mul_ps(dy, _mm_set1_ps(q.y))),
+					     _mm_mul_ps(dz, _mm_set1_ps(q.z))), invDet);
+	    __m128 t = _mm_mul_ps(_mm_set1_ps(glm::dot(tri.e2, q)), invDet);
+	    __m128 ok = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+	    ok = _mm_and_ps(ok, _mm_cmple_ps(_mm_add_ps(u, v), one));
+	    ok = _mm_and_ps(ok, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, far)));
+	    // 1/0 gives inf or nan, both fail one of the tests above
+	    hit |= _mm_movemask_ps(ok) & active;
+	    if(hit == active)
+	      {
+		return hit;
+	      }
+	  }
+      }
+    return hit;
+#else
+    unsigned hit = 0;
+    for(unsigned k = 0; k < 4; ++k)
+      {
+	if((active >> k & 1) && occluded(origin, dir[k], tMax))
+	  {
+	    hit |= 1u << k;
+	  }
+      }
+    return hit;
+#endif
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,248 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <capture.hpp>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+namespace twg {
+
+  static void putBigEndian(std::vector<uint8_t> &out, uint32_t value)
+  {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+  }
+
+  static void putChunk(std::vector<uint8_t> &out, const char *type,
+		       const uint8_t *data, std::size_t size)
+  {
+    putBigEndian(out, static_cast<uint32_t>(size));
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    uLong crc = crc32(0L, out.data() + start, static_cast<uInt>(size + 4));
+    putBigEndian(out, static_cast<uint32_t>(crc));
+  }
+
+  bool writePng(const std::string &filename, int width, int height,
+		const std::vector<uint8_t> &rgba)
+  {
+    // Rows flipped to top first, each with the Sub filter,
+    // which suits the flat shaded backgrounds of the viewer
+    std::size_t row = 3 * static_cast<std::size_t>(width) + 1;
+    std::vector<uint8_t> raw(row * height);
+    for(int y = 0; y < height; ++y)
+      {
+	const uint8_t *src = rgba.data() + 4 * static_cast<std::size_t>(width) * (height - 1 - y);
+	uint8_t *dst = raw.data() + row * y;
+	dst[0] = 1;
+	for(int x = 0; x < width; ++x)
+	  {
+	    for(int c = 0; c < 3; ++c)
+	      {
+		uint8_t left = x > 0 ? src[4 * (x - 1) + c] : 0;
+		dst[1 + 3 * x + c] = static_cast<uint8_t>(src[4 * x + c] - left);
+	      }
+	  }
+      }
+    uLongf packed = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> idat(packed);
+    if(compress2(idat.data(), &packed, raw.data(), static_cast<uLong>(raw.size()),
+		 Z_BEST_SPEED) != Z_OK)
+      {
+	LOG("[Error] PNG compression failed: "); LOG(filename); LOG("\n");
+	return false;
+      }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> out(signature, signature + 8);
+    std::vector<uint8_t> header;
+    putBigEndian(header, static_cast<uint32_t>(width));
+    putBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bit RGB, no interlace
+    putChunk(out, "IHDR", header.data(), header.size());
+    putChunk(out, "IDAT", idat.data(), packed);
+    putChunk(out, "IEND", nullptr, 0);
+
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    if(!file)
+      {
+	LOG("[Error] Cannot open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    if(!ok)
+      {
+	LOG("[Error] Failed writing: "); LOG(filename); LOG("\n");
+      }
+    return ok;
+  }
+
+  void frameCapture::init(int w, int h)
+  {
+    width = w;
+    height = h;
+    GLsizeiptr bytes = 4 * static_cast<GLsizeiptr>(w) * h;
+    encodeLimit = static_cast<int>(std::min<std::size_t>(maxEncodes, encodeBudget / bytes));
+    encodeLimit = std::max(encodeLimit, 2);
+    for(slot &s : slots)
+      {
+	glGenBuffers(1, &s.pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+	glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+      }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    LOG("[Ok] Capture ring of "); LOG(ringSize); LOG(" pixel buffers, ");
+    LOG(w); LOG("x"); LOG(h); LOG("\n");
+  }
+
+  /**
+   * Copy a finished slot out of its mapped buffer and queue the
+   * encode.  The copy keeps the mapping short, the buffer is
+   * free for the next readback as soon as it returns.
+   */
+  void frameCapture::collect(slot &s)
+  {
+    glDeleteSync(s.fence);
+    s.fence = 0;
+    std::size_t bytes = 4 * static_cast<std::size_t>(width) * height;
+    std::vector<uint8_t> pixels(bytes);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+					  static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT);
+    if(mapped)
+      {
+	std::memcpy(pixels.data(), mapped, bytes);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(!mapped)
+      {
+	LOG("[Error] Capture buffer map failed: "); LOG(s.filename); LOG("\n");
+	return;
+      }
+
+    // Bounded queue: wait for an encoder to finish a frame
+    // rather than let a slow disk grow memory without limit
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      written.wait(guard, [&] { return queued < encodeLimit; });
+      ++queued;
+    }
+    int w = width, h = height;
+    std::string filename = std::move(s.filename);
+    threadPool::shared().run(encodes, [this, w, h, filename, pixels = std::move(pixels)] {
+	writePng(filename, w, h, pixels);
+	{
+	  std::lock_guard<std::mutex> guard(lock);
+	  --queued;
+	}
+	written.notify_one();
+      });
+    ++captured;
+  }
+
+  /**
+   * Read the bound framebuffer; in the viewer call it before
+   * the swap.  When the next slot is still in flight the GPU
+   * is a whole ring behind and only then does this wait for it.
+   */
+  void frameCapture::request(const std::string &filename)
+  {
+    if(!active())
+      {
+	return;
+      }
+    auto start = std::chrono::steady_clock::now();
+    slot &s = slots[head];
+    if(s.fence)
+      {
+	glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+	collect(s);
+      }
+    s.filename = filename;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    head = (head + 1) % ringSize;
+    busyMs += std::chrono::duration<double, std::milli>
+      (std::chrono::steady_clock::now() - start).count();
+  }
+
+  /**
+   * Collect every slot whose fence has signalled, oldest first,
+   * without waiting on the GPU.
+   */
+  void frameCapture::poll()
+  {
+    if(!active())
+      {
+	return;
+      }
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < ringSize; ++i)
+      {
+	slot &s = slots[(head + i) % ringSize];
+	if(!s.fence)
+	  {
+	    continue;
+	  }
+	GLenum state = glClientWaitSync(s.fence, 0, 0);
+	if(state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+	  {
+	    break; // later slots were fenced later
+	  }
+	collect(s);
+      }
+    busyMs += std::chrono::duration<double, std::milli>
+      (std::chrono::steady_clock::now() - start).count();
+  }
+
+  /**
+   * Drain the ring and wait for every queued encode.
+   */
+  void frameCapture::finish()
+  {
+    if(!active())
+      {
+	return;
+      }
+    for(int i = 0; i < ringSize; ++i)
+      {
+	slot &s = slots[(head + i) % ringSize];
+	if(s.fence)
+	  {
+	    glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+	    collect(s);
+	  }
+      }
+    threadPool::shared().wait(encodes);
+  }
+
+  void frameCapture::release()
+  {
+    finish();
+    for(slot &s : slots)
+      {
+	if(s.pbo)
+	  {
+	    glDeleteBuffers(1, &s.pbo);
+	    s.pbo = 0;
+	  }
+      }
+    width = height = 0;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,748 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <codec.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace twg {
+
+  static inline uint32_t zigzag(int32_t v)
+  {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+  }
+
+  static inline int32_t unzigzag(uint32_t v)
+  {
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+  }
+
+  static void putVarint(std::vector<uint8_t> &out, uint32_t v)
+  {
+    while(v >= 0x80)
+      {
+	out.push_back(static_cast<uint8_t>(v | 0x80));
+	v >>= 7;
+      }
+    out.push_back(static_cast<uint8_t>(v));
+  }
+
+  static bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v)
+  {
+    v = 0;
+    for(int shift = 0; shift < 35; shift += 7)
+      {
+	if(p == end)
+	  {
+	    return false;
+	  }
+	uint8_t b = *p++;
+	v |= uint32_t(b & 0x7f) << shift;
+	if(!(b & 0x80))
+	  {
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  static void putWord(std::vector<uint8_t> &out, uint32_t v)
+  {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &v, 4);
+    out.insert(out.end(), bytes, bytes + 4);
+  }
+
+  static uint32_t getWord(const uint8_t *p)
+  {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+  }
+
+  /**
+   * Coder state shared by encoder and decoder.  Edges are
+   * stored the way the neighbouring triangle will walk them
+   * (reversed), so a match is a plain compare.  Vertex
+   * reference codes: 0 the next new vertex, 1..14 a FIFO
+   * entry, 15 an explicit zigzag delta in the data stream.
+   */
+  struct indexFifos {
+    static const unsigned size = 16;
+    uint32_t edges[size][2];
+    uint32_t vertices[size];
+    unsigned edgeHead = 0, vertexHead = 0;
+    uint32_t next = 0, last = 0;
+
+    indexFifos()
+    {
+      std::memset(edges, 0xff, sizeof(edges));
+      std::memset(vertices, 0xff, sizeof(vertices));
+    }
+
+    void pushEdge(uint32_t a, uint32_t b)
+    {
+      edges[edgeHead % size][0] = a;
+      edges[edgeHead % size][1] = b;
+      ++edgeHead;
+    }
+
+    void pushVertex(uint32_t v)
+    {
+      vertices[vertexHead++ % size] = v;
+    }
+
+    int findEdge(uint32_t a, uint32_t b) const
+    {
+      for(unsigned d = 0; d < size - 1; ++d)
+	{
+	  const uint32_t *e = edges[(edgeHead - 1 - d) % size];
+	  if(e[0] == a && e[1] == b)
+	    {
+	      return d;
+	    }
+	}
+      return -1;
+    }
+
+    unsigned encode(uint32_t v, std::vector<uint8_t> &data)
+    {
+      if(v == next)
+	{
+	  ++next;
+	  pushVertex(v);
+	  return 0;
+	}
+      for(unsigned d = 0; d < size - 2; ++d)
+	{
+	  if(vertices[(vertexHead - 1 - d) % size] == v)
+	    {
+	      return d + 1;
+	    }
+	}
+      putVarint(data, zigzag(static_cast<int32_t>(v - last)));
+      last = v;
+      pushVertex(v);
+      return 15;
+    }
+
+    bool decode(unsigned code, const uint8_t *&data, const uint8_t *end, uint32_t &v)
+    {
+      if(code == 0)
+	{
+	  v = next++;
+	  pushVertex(v);
+	}
+      else if(code < 15)
+	{
+	  v = vertices[(vertexHead - code) % size];
+	}
+      else
+	{
+	  uint32_t delta;
+	  if(!getVarint(data, end, delta))
+	    {
+	      return false;
+	    }
+	  v = last + static_cast<uint32_t>(unzigzag(delta));
+	  last = v;
+	  pushVertex(v);
+	}
+      return true;
+    }
+  };
+
+  /**
+   * Layout: triangle count, code byte count, code bytes, then
+   * the varint data.  A code byte is (edge << 4 | third) when
+   * the triangle shares a FIFO edge, or (0xf0 | first) plus a
+   * second byte (second << 4 | third) when it does not.
+   */
+  std::vector<uint8_t> encodeIndexBuffer(const std::vector<GLuint> &elements)
+  {
+    std::size_t triangles = elements.size() / 3;
+    std::vector<uint8_t> codes, data;
+    codes.reserve(triangles);
+    indexFifos f;
+    for(std::size_t t = 0; t < triangles; ++t)
+      {
+	const GLuint *tri = &elements[3 * t];
+	int edge = -1, r = 0;
+	for(; r < 3 && edge < 0; ++r)
+	  {
+	    edge = f.findEdge(tri[r], tri[(r + 1) % 3]);
+	  }
+	if(edge >= 0)
+	  {
+	    --r;
+	    uint32_t a = tri[r], b = tri[(r + 1) % 3], c = tri[(r + 2) % 3];
+	    codes.push_back(static_cast<uint8_t>(edge << 4 | f.encode(c, data)));
+	    f.pushEdge(c, b);
+	    f.pushEdge(a, c);
+	  }
+	else
+	  {
+	    uint32_t a = tri[0], b = tri[1], c = tri[2];
+	    codes.push_back(static_cast<uint8_t>(0xf0 | f.encode(a, data)));
+	    unsigned second = f.encode(b, data) << 4;
+	    codes.push_back(static_cast<uint8_t>(second | f.encode(c, data)));
+	    f.pushEdge(b, a);
+	    f.pushEdge(c, b);
+	    f.pushEdge(a, c);
+	  }
+      }
+    std::vector<uint8_t> out;
+    out.reserve(8 + codes.size() + data.size());
+    putWord(out, static_cast<uint32_t>(triangles));
+    putWord(out, static_cast<uint32_t>(codes.size()));
+    out.insert(out.end(), codes.begin(), codes.end());
+    out.insert(out.end(), data.begin(), data.end());
+    return out;
+  }
+
+  bool decodeIndexBuffer(const uint8_t *in, std::size_t size,
+			 std::vector<GLuint> &elements)
+  {
+    if(size < 8)
+      {
+	return false;
+      }
+    // Every triangle takes at least its code byte
+    std::size_t triangles = getWord(in), codeBytes = getWord(in + 4);
+    if(codeBytes > size - 8 || triangles > codeBytes)
+      {
+	return false;
+      }
+    const uint8_t *code = in + 8, *codeEnd = code + codeBytes;
+    const uint8_t *data = codeEnd, *end = in + size;
+    elements.resize(3 * triangles);
+    indexFifos f;
+    for(std::size_t t = 0; t < triangles; ++t)
+      {
+	if(code == codeEnd)
+	  {
+	    return false;
+	  }
+	GLuint *tri = &elements[3 * t];
+	uint8_t c = *code++;
+	if(c >> 4 != 15)
+	  {
+	    const uint32_t *e = f.edges[(f.edgeHead - 1 - (c >> 4)) % indexFifos::size];
+	    tri[0] = e[0];
+	    tri[1] = e[1];
+	    if(!f.decode(c & 15, data, end, tri[2]))
+	      {
+		return false;
+	      }
+	    f.pushEdge(tri[2], tri[1]);
+	    f.pushEdge(tri[0], tri[2]);
+	  }
+	else
+	  {
+	    if(code == codeEnd || !f.decode(c & 15, data, end, tri[0]))
+	      {
+		return false;
+	      }
+	    uint8_t second = *code++;
+	    if(!f.decode(second >> 4, data, end, tri[1])
+	       || !f.decode(second & 15, data, end, tri[2]))
+	      {
+		return false;
+	      }
+	    f.pushEdge(tri[1], tri[0]);
+	    f.pushEdge(tri[2], tri[1]);
+	    f.pushEdge(tri[0], tri[2]);
+	  }
+      }
+    return true;
+  }
+
+  static const std::size_t blockVertices = 256;
+  static const std::size_t groupBytes = 16;
+
+  /**
+   * One byte plane of a block: a 2 bit mode per 16 byte group
+   * (all zero, 2, 4 or 8 bits per byte), then the packed
+   * groups.  The last group is zero padded.
+   */
+  static void encodePlane(const uint8_t *plane, std::size_t n, std::vector<uint8_t> &out)
+  {
+    std::size_t groups = (n + groupBytes - 1) / groupBytes;
+    std::size_t header = out.size();
+    out.resize(out.size() + (groups + 3) / 4, 0);
+    for(std::size_t g = 0; g < groups; ++g)
+      {
+	uint8_t v[groupBytes] = {};
+	std::memcpy(v, plane + g * groupBytes, std::min(groupBytes, n - g * groupBytes));
+	uint8_t high = 0;
+	for(uint8_t b : v)
+	  {
+	    high |= b;
+	  }
+	unsigned mode = high == 0 ? 0 : high < 4 ? 1 : high < 16 ? 2 : 3;
+	out[header + g / 4] |= mode << (2 * (g % 4));
+	if(mode == 1)
+	  {
+	    for(std::size_t j = 0; j < groupBytes; j += 4)
+	      {
+		out.push_back(v[j] | v[j + 1] << 2 | v[j + 2] << 4 | v[j + 3] << 6);
+	      }
+	  }
+	else if(mode == 2)
+	  {
+	    for(std::size_t j = 0; j < groupBytes; j += 2)
+	      {
+		out.push_back(v[j] | v[j + 1] << 4);
+	      }
+	  }
+	else if(mode == 3)
+	  {
+	    out.insert(out.end(), v, v + groupBytes);
+	  }
+      }
+  }
+
+  static const uint8_t *decodePlane(const uint8_t *p, const uint8_t *end,
+				    uint8_t *plane, std::size_t n)
+  {
+    std::size_t groups = (n + groupBytes - 1) / groupBytes;
+    const uint8_t *header = p;
+    p += (groups + 3) / 4;
+    if(p > end)
+      {
+	return nullptr;
+      }
+    for(std::size_t g = 0; g < groups; ++g)
+      {
+	uint8_t *v = plane + g * groupBytes;
+	unsigned mode = (header[g / 4] >> (2 * (g % 4))) & 3;
+	std::size_t bytes = mode == 0 ? 0 : std::size_t(4) << (mode - 1);
+	if(std::size_t(end - p) < bytes)
+	  {
+	    return nullptr;
+	  }
+	if(mode == 0)
+	  {
+	    std::memset(v, 0, groupBytes);
+	  }
+	else if(mode == 1)
+	  {
+	    for(std::size_t j = 0; j < groupBytes; ++j)
+	      {
+		v[j] = (p[j >> 2] >> (2 * (j & 3))) & 3;
+	      }
+	  }
+	else if(mode == 2)
+	  {
+	    for(std::size_t j = 0; j < groupBytes; ++j)
+	      {
+		v[j] = (p[j >> 1] >> (4 * (j & 1))) & 15;
+	      }
+	  }
+	else
+	  {
+	    std::memcpy(v, p, groupBytes);
+	  }
+	p += bytes;
+      }
+    return p;
+  }
+
+  /**
+   * Layout: block count, the byte size of every block, then
+   * the blocks.  A block starts with one byte per word telling
+   * whether the word is delta coded by subtraction (zigzag) or
+   * xor, then holds stride planes: byte k of word w of every
+   * vertex is plane (w * 4 + k).
+   */
+  std::vector<uint8_t> encodeVertexBuffer(const void *vertices, std::size_t count,
+					  std::size_t stride)
+  {
+    const uint8_t *src = static_cast<const uint8_t *>(vertices);
+    std::size_t words = stride / 4;
+    std::size_t blocks = (count + blockVertices - 1) / blockVertices;
+    std::vector<std::vector<uint8_t>> encoded(blocks);
+    parallelFor(0, blocks, [&](std::size_t lo, std::size_t hi, unsigned) {
+	std::vector<uint32_t> deltas[2];
+	std::vector<uint8_t> candidate[2];
+	uint8_t plane[blockVertices];
+	for(std::size_t b = lo; b < hi; ++b)
+	  {
+	    std::size_t first = b * blockVertices;
+	    std::size_t n = std::min(blockVertices, count - first);
+	    std::vector<uint8_t> &out = encoded[b];
+	    out.assign(words, 0);
+	    for(std::size_t w = 0; w < words; ++w)
+	      {
+		// Keep whichever of subtract and xor packs smaller
+		deltas[0].resize(n);
+		deltas[1].resize(n);
+		uint32_t prev = 0;
+		for(std::size_t i = 0; i < n; ++i)
+		  {
+		    uint32_t cur = getWord(src + (first + i) * stride + 4 * w);
+		    deltas[0][i] = zigzag(static_cast<int32_t>(cur - prev));
+		    deltas[1][i] = cur ^ prev;
+		    prev = cur;
+		  }
+		for(int mode = 0; mode < 2; ++mode)
+		  {
+		    candidate[mode].clear();
+		    for(unsigned k = 0; k < 4; ++k)
+		      {
+			for(std::size_t i = 0; i < n; ++i)
+			  {
+			    plane[i] = static_cast<uint8_t>(deltas[mode][i] >> (8 * k));
+			  }
+			encodePlane(plane, n, candidate[mode]);
+		      }
+		  }
+		int best = candidate[1].size() < candidate[0].size();
+		out[w] = static_cast<uint8_t>(best);
+		out.insert(out.end(), candidate[best].begin(), candidate[best].end());
+	      }
+	  }
+      });
+    std::vector<uint8_t> out;
+    putWord(out, static_cast<uint32_t>(blocks));
+    for(const std::vector<uint8_t> &e : encoded)
+      {
+	putWord(out, static_cast<uint32_t>(e.size()));
+      }
+    for(const std::vector<uint8_t> &e : encoded)
+      {
+	out.insert(out.end(), e.begin(), e.end());
+      }
+    return out;
+  }
+
+  bool decodeVertexBuffer(const uint8_t *in, std::size_t size,
+			  void *vertices, std::size_t count, std::size_t stride)
+  {
+    uint8_t *dst = static_cast<uint8_t *>(vertices);
+    std::size_t words = stride / 4;
+    std::size_t blocks = (count + blockVertices - 1) / blockVertices;
+    if(stride % 4 != 0 || size < 4 + 4 * blocks || getWord(in) != blocks)
+      {
+	return false;
+      }
+    std::vector<std::size_t> offsets(blocks + 1, 4 + 4 * blocks);
+    for(std::size_t b = 0; b < blocks; ++b)
+      {
+	offsets[b + 1] = offsets[b] + getWord(in + 4 + 4 * b);
+      }
+    if(offsets[blocks] > size)
+      {
+	return false;
+      }
+    std::vector<char> failed(blocks, 0);
+    parallelFor(0, blocks, [&](std::size_t lo, std::size_t hi, unsigned) {
+	std::vector<uint8_t> planes(stride * blockVertices);
+	for(std::size_t b = lo; b < hi; ++b)
+	  {
+	    std::size_t first = b * blockVertices;
+	    std::size_t n = std::min(blockVertices, count - first);
+	    const uint8_t *modes = in + offsets[b], *end = in + offsets[b + 1];
+	    const uint8_t *p = words <= std::size_t(end - modes) ? modes + words : nullptr;
+	    for(std::size_t k = 0; k < stride && p; ++k)
+	      {
+		p = decodePlane(p, end, &planes[k * blockVertices], n);
+	      }
+	    if(!p)
+	      {
+		failed[b] = 1;
+		continue;
+	      }
+	    for(std::size_t w = 0; w < words; ++w)
+	      {
+		const uint8_t *b0 = &planes[(4 * w) * blockVertices];
+		const uint8_t *b1 = b0 + blockVertices, *b2 = b1 + blockVertices;
+		const uint8_t *b3 = b2 + blockVertices;
+		uint32_t prev = 0;
+		uint8_t *out = dst + first * stride + 4 * w;
+		if(modes[w])
+		  {
+		    for(std::size_t i = 0; i < n; ++i, out += stride)
+		      {
+			prev ^= b0[i] | uint32_t(b1[i]) << 8 | uint32_t(b2[i]) << 16
+			  | uint32_t(b3[i]) << 24;
+			std::memcpy(out, &prev, 4);
+		      }
+		  }
+		else
+		  {
+		    for(std::size_t i = 0; i < n; ++i, out += stride)
+		      {
+			prev += static_cast<uint32_t>(unzigzag(b0[i] | uint32_t(b1[i]) << 8
+							     | uint32_t(b2[i]) << 16
+							     | uint32_t(b3[i]) << 24));
+			std::memcpy(out, &prev, 4);
+		      }
+		  }
+	      }
+	  }
+      });
+    return std::find(failed.begin(), failed.end(), 1) == failed.end();
+  }
+
+  struct mshzHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t stride;
+    uint32_t vertexBytes;
+    uint32_t indexBytes;
+  };
+
+  static_assert(sizeof(Vertex) % 4 == 0, "vertex codec works on 32 bit words");
+  static_assert(sizeof(materialRange) == 12, "ranges are written as three words");
+
+  static void putWord(std::ofstream &out, std::size_t v)
+  {
+    uint32_t word = static_cast<uint32_t>(v);
+    out.write(reinterpret_cast<const char *>(&word), sizeof(word));
+  }
+
+  /**
+   * Bounds checked reads from the version 2 tail.
+   */
+  struct mshzTail {
+    const uint8_t *p, *end;
+
+    bool take(void *out, std::size_t bytes)
+    {
+      if(std::size_t(end - p) < bytes)
+	{
+	  return false;
+	}
+      std::copy(p, p + bytes, static_cast<uint8_t *>(out));
+      p += bytes;
+      return true;
+    }
+
+    bool word(uint32_t &v) { return take(&v, sizeof(v)); }
+  };
+
+  bool saveCompressed(const mesh &m, const std::string &filename)
+  {
+    // First use order keeps vertex deltas small and lets the
+    // index coder hit its "next vertex" code
+    const uint32_t unused = 0xffffffffu;
+    std::vector<uint32_t> remap(m.vertices.size(), unused);
+    bool colored = !m.colors.empty() && m.colors.size() == m.vertices.size();
+    mesh ordered;
+    ordered.vertices.reserve(m.vertices.size());
+    ordered.elements.resize(m.elements.size());
+    for(std::size_t i = 0; i < m.elements.size(); ++i)
+      {
+	uint32_t &r = remap[m.elements[i]];
+	if(r == unused)
+	  {
+	    r = static_cast<uint32_t>(ordered.vertices.size());
+	    ordered.vertices.push_back(m.vertices[m.elements[i]]);
+	    if(colored)
+	      {
+		ordered.colors.push_back(m.colors[m.elements[i]]);
+	      }
+	  }
+	ordered.elements[i] = r;
+      }
+    for(std::size_t v = 0; v < m.vertices.size(); ++v)
+      {
+	if(remap[v] == unused)
+	  {
+	    ordered.vertices.push_back(m.vertices[v]);
+	    if(colored)
+	      {
+		ordered.colors.push_back(m.colors[v]);
+	      }
+	  }
+      }
+    std::vector<uint8_t> vertexData = encodeVertexBuffer(ordered.vertices.data(),
+							 ordered.vertices.size(),
+							 sizeof(Vertex));
+    std::vector<uint8_t> indexData = encodeIndexBuffer(ordered.elements);
+
+    std::ofstream out{filename, ios::out | ios::binary};
+    if(!out)
+      {
+	LOG("[Error] Not able to write: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    // Version 1 readers still open plain meshes
+    bool extras = colored || !m.materials.empty();
+    mshzHeader h{{'M', 'S', 'H', 'Z'}, extras ? 2u : 1u,
+		 static_cast<uint32_t>(ordered.vertices.size()),
+		 static_cast<uint32_t>(ordered.elements.size() / 3 * 3),
+		 static_cast<uint32_t>(sizeof(Vertex)),
+		 static_cast<uint32_t>(vertexData.size()),
+		 static_cast<uint32_t>(indexData.size())};
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(vertexData.data()), vertexData.size());
+    out.write(reinterpret_cast<const char *>(indexData.data()), indexData.size());
+    if(extras)
+      {
+	std::vector<uint8_t> colorData;
+	if(colored)
+	  {
+	    colorData = encodeVertexBuffer(ordered.colors.data(), ordered.colors.size(),
+					   sizeof(glm::vec3));
+	  }
+	putWord(out, colorData.size());
+	out.write(reinterpret_cast<const char *>(colorData.data()), colorData.size());
+	putWord(out, m.materials.size());
+	for(const material &mat : m.materials)
+	  {
+	    float values[8] = {mat.diffuse.x, mat.diffuse.y, mat.diffuse.z,
+			       mat.specular.x, mat.specular.y, mat.specular.z,
+			       mat.shininess, mat.opacity};
+	    putWord(out, mat.name.size());
+	    out.write(mat.name.data(), mat.name.size());
+	    out.write(reinterpret_cast<const char *>(values), sizeof(values));
+	  }
+	putWord(out, m.materialRanges.size());
+	out.write(reinterpret_cast<const char *>(m.materialRanges.data()),
+		  m.materialRanges.size() * sizeof(materialRange));
+      }
+    return static_cast<bool>(out);
+  }
+
+  /**
+   * The version 2 tail after the index section: colours coded
+   * like the vertices, then materials and their ranges.  Every
+   * count is checked against the bytes left before use.
+   */
+  static bool loadExtras(const std::vector<uint8_t> &data, const mshzHeader &h, mesh &m)
+  {
+    mshzTail tail{data.data() + h.vertexBytes + h.indexBytes, data.data() + data.size()};
+    uint32_t colorBytes = 0;
+    if(!tail.word(colorBytes) || colorBytes > std::size_t(tail.end - tail.p))
+      {
+	return false;
+      }
+    if(colorBytes)
+      {
+	m.colors.resize(h.vertexCount);
+	if((std::size_t(h.vertexCount) + 63) / 64 * sizeof(glm::vec3) > colorBytes
+	   || !decodeVertexBuffer(tail.p, colorBytes, m.colors.data(), h.vertexCount,
+				  sizeof(glm::vec3)))
+	  {
+	    return false;
+	  }
+	tail.p += colorBytes;
+      }
+    uint32_t materials = 0;
+    float values[8];
+    if(!tail.word(materials) || materials > std::size_t(tail.end - tail.p) / (4 + sizeof(values)))
+      {
+	return false;
+      }
+    m.materials.resize(materials);
+    for(material &mat : m.materials)
+      {
+	uint32_t length = 0;
+	if(!tail.word(length) || length > std::size_t(tail.end - tail.p))
+	  {
+	    return false;
+	  }
+	mat.name.assign(reinterpret_cast<const char *>(tail.p), length);
+	tail.p += length;
+	if(!tail.take(values, sizeof(values)))
+	  {
+	    return false;
+	  }
+	mat.diffuse = glm::vec3{values[0], values[1], values[2]};
+	mat.specular = glm::vec3{values[3], values[4], values[5]};
+	mat.shininess = values[6];
+	mat.opacity = values[7];
+      }
+    uint32_t ranges = 0;
+    if(!tail.word(ranges) || ranges > std::size_t(tail.end - tail.p) / sizeof(materialRange))
+      {
+	return false;
+      }
+    m.materialRanges.resize(ranges);
+    tail.take(m.materialRanges.data(), ranges * sizeof(materialRange));
+    std::size_t next = 0;
+    for(const materialRange &r : m.materialRanges)
+      {
+	if(r.material >= materials || r.first < next || r.first > h.indexCount
+	   || r.count > h.indexCount - r.first)
+	  {
+	    return false;
+	  }
+	next = std::size_t(r.first) + r.count;
+      }
+    return true;
+  }
+
+  bool loadCompressed(const std::string &filename, mesh &m)
+  {
+    std::ifstream in{filename, ios::in | ios::binary};
+    if(!in)
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    mshzHeader h;
+    if(!in.read(reinterpret_cast<char *>(&h), sizeof(h))
+       || std::memcmp(h.magic, "MSHZ", 4) != 0 || (h.version != 1 && h.version != 2)
+       || h.stride != sizeof(Vertex))
+      {
+	LOG("[Error] Not a meshtool .mshz file: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    // Counts are checked against what the file can hold before
+    // anything is sized from them: each byte plane spends at
+    // least a mode byte per 64 vertices, each triangle a code
+    // byte.
+    in.seekg(0, ios::end);
+    std::size_t remaining = std::size_t(in.tellg()) - sizeof(h);
+    in.seekg(sizeof(h));
+    if(std::size_t(h.vertexBytes) + h.indexBytes > remaining)
+      {
+	LOG("[Error] Truncated .mshz file: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    if((std::size_t(h.vertexCount) + 63) / 64 * h.stride > h.vertexBytes
+       || h.indexCount % 3 != 0 || h.indexCount / 3 > h.indexBytes)
+      {
+	LOG("[Error] Corrupt .mshz file: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    std::vector<uint8_t> data(h.version == 1 ? std::size_t(h.vertexBytes) + h.indexBytes : remaining);
+    if(!in.read(reinterpret_cast<char *>(data.data()), data.size()))
+      {
+	LOG("[Error] Truncated .mshz file: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    m.vertices.resize(h.vertexCount);
+    if(!decodeVertexBuffer(data.data(), h.vertexBytes, m.vertices.data(),
+			   h.vertexCount, sizeof(Vertex))
+       || !decodeIndexBuffer(data.data() + h.vertexBytes, h.indexBytes, m.elements)
+       || m.elements.size() != h.indexCount
+       || std::any_of(m.elements.begin(), m.elements.end(),
+		      [&](GLuint e) { return e >= h.vertexCount; }))
+      {
+	LOG("[Error] Corrupt .mshz file: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    m.colors.clear();
+    m.materials.clear();
+    m.materialRanges.clear();
+    if(h.version == 2 && !loadExtras(data, h, m))
+      {
+	LOG("[Error] Corrupt .mshz file: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    return true;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,653 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <daemon.hpp>
+#include <headless.hpp>
+#include <capture.hpp>
+#include <stats.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace twg {
+
+  std::shared_ptr<const mesh> meshCache::get(const std::string &path, const loader &load,
+					     std::string &error)
+  {
+    struct stat info;
+    if(::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+      {
+	error = "cannot open " + path;
+	return nullptr;
+      }
+    uint64_t size = static_cast<uint64_t>(info.st_size);
+    int64_t mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    {
+      std::lock_guard<std::mutex> guard{lock};
+      auto found = index.find(path);
+      if(found != index.end() && found->second->size == size && found->second->mtime == mtime)
+	{
+	  order.splice(order.begin(), order, found->second);
+	  ++hitCount;
+	  return found->second->data;
+	}
+      ++missCount;
+    }
+
+    // Decode outside the lock so other requests keep going; two
+    // clients missing on the same file both decode it
+    auto decoded = std::make_shared<mesh>();
+    if(!load(path, *decoded))
+      {
+	error = "cannot read " + path;
+	return nullptr;
+      }
+    std::size_t bytes = decoded->vertices.size() * sizeof(Vertex)
+      + decoded->elements.size() * sizeof(GLuint)
+      + decoded->colors.size() * sizeof(glm::vec3);
+
+    std::lock_guard<std::mutex> guard{lock};
+    auto found = index.find(path);
+    if(found != index.end())
+      {
+	used -= found->second->bytes;
+	order.erase(found->second);
+	index.erase(found);
+      }
+    order.push_front(entry{path, size, mtime, bytes, decoded});
+    index[path] = order.begin();
+    used += bytes;
+    while(used > budget && order.size() > 1)
+      {
+	used -= order.back().bytes;
+	index.erase(order.back().path);
+	order.pop_back();
+      }
+    return decoded;
+  }
+
+  std::size_t meshCache::hits() const
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    return hitCount;
+  }
+
+  std::size_t meshCache::misses() const
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    return missCount;
+  }
+
+  std::size_t meshCache::bytes() const
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    return used;
+  }
+
+  std::size_t meshCache::entries() const
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    return order.size();
+  }
+
+  using daemonClock = std::chrono::steady_clock;
+
+  static std::atomic<bool> daemonStop{false};
+
+  static void stopDaemon(int)
+  {
+    daemonStop = true;
+  }
+
+  static double millisecondsSince(daemonClock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(daemonClock::now() - start).count();
+  }
+
+  static bool sendAll(int fd, const std::string &data)
+  {
+    std::size_t sent = 0;
+    while(sent < data.size())
+      {
+	ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+	if(n <= 0)
+	  {
+	    return false;
+	  }
+	sent += static_cast<std::size_t>(n);
+      }
+    return true;
+  }
+
+  /**
+   * Counts and latencies of one request kind.  Dispatch is the
+   * part of a request's latency outside its own work and GL
+   * queue wait: parsing, bookkeeping and writing the reply.
+   */
+  struct requestCounter {
+    std::size_t count = 0, errors = 0;
+    double totalMs = 0.0, maxMs = 0.0, queuedMs = 0.0, dispatchMs = 0.0;
+  };
+
+  struct requestResult {
+    std::string verb;
+    std::string reply;
+    bool ok = false;
+    double workMs = 0.0;
+    double queuedMs = 0.0;
+  };
+
+  /**
+   * A thumbnail waiting for the GL thread, which renders and
+   * reads it back; the requesting thread encodes the PNG.
+   */
+  struct thumbnailJob {
+    const mesh *data;
+    int size;
+    std::vector<uint8_t> pixels;
+    daemonClock::time_point started;
+    std::promise<bool> rendered;
+  };
+
+  class daemonServer {
+  public:
+    explicit daemonServer(const daemonOptions &options)
+      : options{options}, cache{options.cacheBytes} {}
+    int run();
+
+  private:
+    struct client {
+      int fd;
+      bool finished = false;
+      std::thread thread;
+    };
+
+    const daemonOptions &options;
+    meshCache cache;
+    daemonClock::time_point startTime;
+    std::atomic<int> depth{0}, peakDepth{0};
+    std::atomic<std::size_t> rejected{0};     // connections over maxClients
+    std::mutex countersLock;
+    std::map<std::string, requestCounter> counters;
+
+    std::mutex clientsLock;
+    std::list<client> clients;
+
+    std::mutex glLock;
+    std::condition_variable glReady;
+    std::deque<thumbnailJob *> glQueue;
+    bool glRunning = true;
+    bool glAvailable = false;
+    std::thread glThread;
+
+    void glLoop(std::promise<bool> ready);
+    void serve(client &c);
+    void reap(bool all);
+    requestResult handle(const std::string &line);
+    void record(const requestResult &r, double totalMs);
+    std::string status();
+  };
+
+  /**
+   * The only thread that touches GL: the context is created
+   * once, with a renderer for the common size that lives as
+   * long as it does.  Renderers for other sizes are kept for
+   * the few sizes used last, so a client asking for many
+   * sizes (up to 8192^2 each) cannot pile up framebuffers.
+   */
+  void daemonServer::glLoop(std::promise<bool> ready)
+  {
+    // Shaders compile here at startup for the common size, so a
+    // missing shader stops the daemon before it takes requests
+    const int commonSize = 256;
+    const std::size_t keptSizes = 3;
+    headlessContext context;
+    offscreenRenderer common;
+    std::list<std::pair<int, offscreenRenderer>> recent;   // most recent first
+    bool ok = context.init() && common.init(commonSize, commonSize);
+    ready.set_value(ok);
+    if(!ok)
+      {
+	return;
+      }
+    for(;;)
+      {
+	thumbnailJob *job;
+	{
+	  std::unique_lock<std::mutex> guard{glLock};
+	  glReady.wait(guard, [this] { return !glRunning || !glQueue.empty(); });
+	  if(glQueue.empty())
+	    {
+	      break;
+	    }
+	  job = glQueue.front();
+	  glQueue.pop_front();
+	}
+	job->started = daemonClock::now();
+	offscreenRenderer *renderer = &common;
+	if(job->size != commonSize)
+	  {
+	    auto found = std::find_if(recent.begin(), recent.end(),
+				      [job](const std::pair<int, offscreenRenderer> &r) {
+					return r.first == job->size;
+				      });
+	    if(found != recent.end())
+	      {
+		recent.splice(recent.begin(), recent, found);
+	      }
+	    else
+	      {
+		if(recent.size() == keptSizes)
+		  {
+		    recent.back().second.release();
+		    recent.pop_back();
+		  }
+		recent.emplace_front(std::piecewise_construct, std::forward_as_tuple(job->size),
+				     std::forward_as_tuple());
+		if(!recent.front().second.init(job->size, job->size))
+		  {
+		    recent.front().second.release();
+		    recent.pop_front();
+		    job->rendered.set_value(false);
+		    continue;
+		  }
+	      }
+	    renderer = &recent.front().second;
+	  }
+	renderer->upload(*job->data);
+	renderer->render(glm::vec3(0.4f, 0.6f, 0.0f));
+	renderer->read(job->pixels);
+	job->rendered.set_value(true);
+      }
+    for(auto &r : recent)
+      {
+	r.second.release();
+      }
+    common.release();
+    context.release();
+  }
+
+  requestResult daemonServer::handle(const std::string &line)
+  {
+    requestResult r;
+    std::istringstream in{line};
+    in >> r.verb;
+    std::vector<std::string> args;
+    for(std::string arg; in >> arg;)
+      {
+	args.push_back(arg);
+      }
+    auto work = daemonClock::now();
+    std::string error;
+
+    if(r.verb == "ping" && args.empty())
+      {
+	r.reply = "ok";
+      }
+    else if(r.verb == "status" && args.empty())
+      {
+	r.reply = "ok " + status();
+      }
+    else if(r.verb == "shutdown" && args.empty())
+      {
+	daemonStop = true;
+	r.reply = "ok";
+      }
+    else if(r.verb == "convert" && args.size() == 2)
+      {
+	std::shared_ptr<const mesh> data = cache.get(args[0], options.load, error);
+	if(data && !options.save(*data, args[1]))
+	  {
+	    error = "cannot write " + args[1];
+	  }
+	r.reply = error.empty() ? "ok" : "error " + error;
+      }
+    else if(r.verb == "stats" && args.size() == 1)
+      {
+	std::shared_ptr<const mesh> data = cache.get(args[0], options.load, error);
+	r.reply = data ? "ok " + statsJson(args[0], computeStats(*data)) : "error " + error;
+      }
+    else if(r.verb == "thumbnail" && args.size() == 3)
+      {
+	int size = std::atoi(args[0].c_str());
+	std::shared_ptr<const mesh> data;
+	if(size < 1 || size > 8192)
+	  {
+	    error = "bad size " + args[0];
+	  }
+	else if(!glAvailable)
+	  {
+	    error = "no offscreen context";
+	  }
+	else
+	  {
+	    data = cache.get(args[1], options.load, error);
+	  }
+	if(data)
+	  {
+	    thumbnailJob job{data.get(), size, {}, {}, {}};
+	    std::future<bool> rendered = job.rendered.get_future();
+	    auto queued = daemonClock::now();
+	    {
+	      std::lock_guard<std::mutex> guard{glLock};
+	      glQueue.push_back(&job);
+	    }
+	    glReady.notify_one();
+	    if(!rendered.get())
+	      {
+		error = "cannot render at " + args[0];
+	      }
+	    else
+	      {
+		r.queuedMs = std::chrono::duration<double, std::milli>(job.started - queued).count();
+		if(!writePng(args[2], size, size, job.pixels))
+		  {
+		    error = "cannot write " + args[2];
+		  }
+	      }
+	  }
+	r.reply = error.empty() ? "ok" : "error " + error;
+      }
+    else
+      {
+	r.reply = "error bad request: " + line;
+	r.verb = "invalid";
+      }
+    r.ok = r.reply.compare(0, 2, "ok") == 0;
+    r.workMs = millisecondsSince(work) - r.queuedMs;
+    return r;
+  }
+
+  void daemonServer::record(const requestResult &r, double totalMs)
+  {
+    std::lock_guard<std::mutex> guard{countersLock};
+    requestCounter &c = counters[r.verb];
+    ++c.count;
+    c.errors += r.ok ? 0 : 1;
+    c.totalMs += totalMs;
+    c.maxMs = std::max(c.maxMs, totalMs);
+    c.queuedMs += r.queuedMs;
+    c.dispatchMs += std::max(0.0, totalMs - r.workMs - r.queuedMs);
+  }
+
+  std::string daemonServer::status()
+  {
+    std::size_t glDepth;
+    {
+      std::lock_guard<std::mutex> guard{glLock};
+      glDepth = glQueue.size();
+    }
+    std::ostringstream out;
+    out << "{\"uptime_s\": " << millisecondsSince(startTime) * 1e-3
+	<< ", \"workers\": " << workerCount()
+	<< ", \"queue_depth\": " << depth.load()
+	<< ", \"peak_queue_depth\": " << peakDepth.load()
+	<< ", \"rejected_clients\": " << rejected.load()
+	<< ", \"gl_queue\": " << glDepth
+	<< ", \"cache\": {\"entries\": " << cache.entries()
+	<< ", \"bytes\": " << cache.bytes()
+	<< ", \"hits\": " << cache.hits()
+	<< ", \"misses\": " << cache.misses() << "}"
+	<< ", \"requests\": {";
+    std::lock_guard<std::mutex> guard{countersLock};
+    const char *separator = "";
+    for(const auto &entry : counters)
+      {
+	const requestCounter &c = entry.second;
+	double n = static_cast<double>(std::max<std::size_t>(c.count, 1));
+	out << separator << "\"" << entry.first << "\": {\"count\": " << c.count
+	    << ", \"errors\": " << c.errors
+	    << ", \"mean_ms\": " << c.totalMs / n
+	    << ", \"max_ms\": " << c.maxMs
+	    << ", \"queued_ms\": " << c.queuedMs / n
+	    << ", \"dispatch_us\": " << 1e3 * c.dispatchMs / n << "}";
+	separator = ", ";
+      }
+    out << "}}";
+    return out.str();
+  }
+
+  /**
+   * Requests on one connection run in order on its own thread;
+   * the reply goes out before the next line is read, so a
+   * client pipelining requests gets replies in request order.
+   */
+  void daemonServer::serve(client &c)
+  {
+    std::string buffer;
+    char chunk[4096];
+    for(;;)
+      {
+	ssize_t n = ::recv(c.fd, chunk, sizeof(chunk), 0);
+	if(n <= 0)
+	  {
+	    break;
+	  }
+	buffer.append(chunk, static_cast<std::size_t>(n));
+	std::size_t begin = 0, end;
+	bool open = true;
+	while(open && (end = buffer.find('\n', begin)) != std::string::npos)
+	  {
+	    auto received = daemonClock::now();
+	    std::string line = buffer.substr(begin, end - begin);
+	    begin = end + 1;
+	    if(!line.empty() && line.back() == '\r')
+	      {
+		line.pop_back();
+	      }
+	    if(line.empty())
+	      {
+		continue;
+	      }
+	    int now = ++depth;
+	    for(int peak = peakDepth.load(); now > peak && !peakDepth.compare_exchange_weak(peak, now);)
+	      ;
+	    requestResult r = handle(line);
+	    open = sendAll(c.fd, r.reply + "\n");
+	    --depth;
+	    record(r, millisecondsSince(received));
+	  }
+	buffer.erase(0, begin);
+	if(!open || buffer.size() > 65536)
+	  {
+	    break;
+	  }
+      }
+    std::lock_guard<std::mutex> guard{clientsLock};
+    ::close(c.fd);
+    c.finished = true;
+  }
+
+  // Join finished connection threads, or all of them on shutdown
+  void daemonServer::reap(bool all)
+  {
+    std::unique_lock<std::mutex> guard{clientsLock};
+    if(all)
+      {
+	for(client &c : clients)
+	  {
+	    if(!c.finished)
+	      {
+		::shutdown(c.fd, SHUT_RDWR);
+	      }
+	  }
+      }
+    for(auto it = clients.begin(); it != clients.end();)
+      {
+	if(!all && !it->finished)
+	  {
+	    ++it;
+	    continue;
+	  }
+	std::thread t = std::move(it->thread);
+	guard.unlock();
+	t.join();
+	guard.lock();
+	it = clients.erase(it);
+      }
+  }
+
+  int daemonServer::run()
+  {
+    startTime = daemonClock::now();
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(options.socketPath.empty() || options.socketPath.size() >= sizeof(address.sun_path))
+      {
+	LOG("[Error] Bad socket path: "); LOG(options.socketPath); LOG("\n");
+	return 1;
+      }
+    std::memcpy(address.sun_path, options.socketPath.c_str(), options.socketPath.size() + 1);
+
+    // A socket left behind by a daemon that did not shut down
+    // cleanly is replaced; any other file is left alone
+    struct stat info;
+    if(::stat(options.socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+      {
+	::unlink(options.socketPath.c_str());
+      }
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(listener < 0
+       || ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+       || ::listen(listener, 128) != 0)
+      {
+	LOG("[Error] Not able to listen on "); LOG(options.socketPath); LOG(": ");
+	LOG(std::strerror(errno)); LOG("\n");
+	if(listener >= 0)
+	  {
+	    ::close(listener);
+	  }
+	return 1;
+      }
+    daemonStop = false;
+    std::signal(SIGINT, stopDaemon);
+    std::signal(SIGTERM, stopDaemon);
+
+    // Warm everything a request would otherwise pay for first
+    unsigned workers = workerCount();
+    std::promise<bool> ready;
+    std::future<bool> contextReady = ready.get_future();
+    glThread = std::thread(&daemonServer::glLoop, this, std::move(ready));
+    glAvailable = contextReady.get();
+    LOG("[Ok] Listening on "); LOG(options.socketPath); LOG(", "); LOG(workers);
+    LOG((glAvailable ? " workers, offscreen context ready\n"
+	 : " workers, no offscreen context: thumbnails disabled\n"));
+
+    while(!daemonStop)
+      {
+	pollfd waiting{listener, POLLIN, 0};
+	if(::poll(&waiting, 1, 100) > 0)
+	  {
+	    int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+	    std::unique_lock<std::mutex> guard{clientsLock};
+	    std::size_t serving = std::count_if(clients.begin(), clients.end(),
+						[](const client &c) { return !c.finished; });
+	    if(fd >= 0 && serving >= options.maxClients)
+	      {
+		guard.unlock();
+		sendAll(fd, "error busy\n");
+		::close(fd);
+		++rejected;
+	      }
+	    else if(fd >= 0)
+	      {
+		clients.push_back(client{fd, false, std::thread{}});
+		client &c = clients.back();
+		c.thread = std::thread(&daemonServer::serve, this, std::ref(c));
+	      }
+	  }
+	reap(false);
+      }
+    ::close(listener);
+    ::unlink(options.socketPath.c_str());
+    reap(true);
+    {
+      std::lock_guard<std::mutex> guard{glLock};
+      glRunning = false;
+    }
+    glReady.notify_one();
+    glThread.join();
+
+    std::size_t served = 0;
+    for(const auto &entry : counters)
+      {
+	served += entry.second.count;
+      }
+    LOG("[Ok] Daemon stopped after "); LOG(served); LOG(" requests, cache hits= ");
+    LOG(cache.hits()); LOG(" misses= "); LOG(cache.misses()); LOG("\n");
+    return 0;
+  }
+
+  int runDaemon(const daemonOptions &options)
+  {
+    daemonServer server{options};
+    return server.run();
+  }
+
+  int sendRequest(const std::string &socketPath, const std::string &request)
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path))
+      {
+	LOG("[Error] Bad socket path: "); LOG(socketPath); LOG("\n");
+	return 1;
+      }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+      {
+	LOG("[Error] Not able to connect to "); LOG(socketPath); LOG(": ");
+	LOG(std::strerror(errno)); LOG("\n");
+	if(fd >= 0)
+	  {
+	    ::close(fd);
+	  }
+	return 1;
+      }
+    // A busy daemon replies and closes without reading, so the
+    // reply is read even when the send fails
+    std::string reply;
+    char chunk[4096];
+    sendAll(fd, request + "\n");
+    ssize_t n;
+    while(reply.find('\n') == std::string::npos
+	  && (n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0)
+      {
+	reply.append(chunk, static_cast<std::size_t>(n));
+      }
+    ::close(fd);
+    reply = reply.substr(0, reply.find('\n'));
+    if(reply.compare(0, 2, "ok") != 0)
+      {
+	LOG("[Error] "); LOG((reply.empty() ? std::string{"no reply"}
+			      : reply.substr(reply.find(' ') + 1))); LOG("\n");
+	return 1;
+      }
+    if(reply.size() > 3)
+      {
+	std::cout << reply.substr(3) << "\n";
+      }
+    return 0;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,730 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <formats.hpp>
+#include <parallel.hpp>
+#include <weld.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace twg {
+
+  mappedFile::mappedFile(const std::string &filename)
+  {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      {
+	return;
+      }
+    struct stat info;
+    if(::fstat(fd, &info) == 0)
+      {
+	opened = true;
+	length = static_cast<std::size_t>(info.st_size);
+	if(length > 0)
+	  {
+	    void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	    if(p != MAP_FAILED)
+	      {
+		::madvise(p, length, MADV_WILLNEED);
+		bytes = static_cast<const uint8_t *>(p);
+	      }
+	    else
+	      {
+		opened = false;
+	      }
+	  }
+      }
+    ::close(fd);
+  }
+
+  mappedFile::~mappedFile()
+  {
+    if(bytes)
+      {
+	::munmap(const_cast<uint8_t *>(bytes), length);
+      }
+  }
+
+  static bool endsWith(const std::string &s, const std::string &ext)
+  {
+    return s.size() > ext.size()
+      && s.compare(s.size() - ext.size(), ext.size(), ext) == 0;
+  }
+
+  /**
+   * Binary STL has no magic (the header may even start with
+   * "solid"), but its size is exact: 84 + 50 per triangle.
+   */
+  static bool isBinaryStl(const uint8_t *head, std::size_t headSize, uint64_t fileSize)
+  {
+    if(headSize < 84)
+      {
+	return false;
+      }
+    uint32_t count;
+    std::memcpy(&count, head + 80, 4);
+    return fileSize == 84 + 50 * uint64_t(count);
+  }
+
+  meshFormat detectFormat(const std::string &filename)
+  {
+    uint8_t head[84] = {};
+    std::size_t n = 0;
+    uint64_t size = 0;
+    if(std::FILE *file = std::fopen(filename.c_str(), "rb"))
+      {
+	n = std::fread(head, 1, sizeof(head), file);
+	struct stat info;
+	if(::fstat(::fileno(file), &info) == 0)
+	  {
+	    size = static_cast<uint64_t>(info.st_size);
+	  }
+	std::fclose(file);
+      }
+    if(n >= 4 && (std::memcmp(head, "ply\n", 4) == 0 || std::memcmp(head, "ply\r", 4) == 0))
+      {
+	return meshFormat::ply;
+      }
+    if(n >= 4 && std::memcmp(head, "MSHZ", 4) == 0)
+      {
+	return meshFormat::mshz;
+      }
+    if(n >= 4 && std::memcmp(head, "glTF", 4) == 0)
+      {
+	return meshFormat::gltf;
+      }
+    if(isBinaryStl(head, n, size) || endsWith(filename, ".stl") || endsWith(filename, ".STL"))
+      {
+	return meshFormat::stl;
+      }
+    if(endsWith(filename, ".ply") || endsWith(filename, ".PLY"))
+      {
+	return meshFormat::ply;
+      }
+    if(endsWith(filename, ".mshz"))
+      {
+	return meshFormat::mshz;
+      }
+    if(endsWith(filename, ".gltf") || endsWith(filename, ".glb"))
+      {
+	return meshFormat::gltf;
+      }
+    return meshFormat::obj;
+  }
+
+  static void logRate(const std::string &filename, const char *what, std::size_t bytes,
+		      std::chrono::steady_clock::time_point start)
+  {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("[Ok] Read "); LOG(filename); LOG(" ("); LOG(what); LOG(") "); LOG(bytes / 1e6);
+    LOG(" MB in "); LOG(seconds * 1e3); LOG(" ms, "); LOG(bytes / 1e6 / seconds); LOG(" MB/s\n");
+  }
+
+  /**
+   * Merge bit identical positions (-0 and +0 alike) through an
+   * open addressing table; the first occurrence survives, so
+   * the vertex order is the order of first use.  Cheaper than
+   * the grid weld when only exact copies need merging.
+   */
+  static void weldExact(mesh &m)
+  {
+    std::size_t n = m.vertices.size();
+    std::vector<uint64_t> hashes(n);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    glm::vec3 p = m.vertices[i].point + glm::vec3(0.0f);
+	    uint32_t b[3];
+	    std::memcpy(b, &p, sizeof(b));
+	    uint64_t h = (uint64_t(b[0]) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(b[1]) * 0xC2B2AE3D27D4EB4Full)
+	      ^ (uint64_t(b[2]) * 0x165667B19E3779F9ull);
+	    hashes[i] = h ^ (h >> 29);
+	  }
+      });
+    std::size_t capacity = 16;
+    while(capacity < 2 * n)
+      {
+	capacity <<= 1;
+      }
+    const uint32_t empty = ~0u;
+    std::vector<uint32_t> table(capacity, empty);
+    std::vector<uint32_t> remap(n);
+    std::vector<Vertex> kept;
+    kept.reserve(n / 4);
+    for(std::size_t i = 0; i < n; ++i)
+      {
+	glm::vec3 p = m.vertices[i].point + glm::vec3(0.0f);
+	std::size_t slot = hashes[i] & (capacity - 1);
+	for(;; slot = (slot + 1) & (capacity - 1))
+	  {
+	    uint32_t k = table[slot];
+	    if(k == empty)
+	      {
+		table[slot] = static_cast<uint32_t>(kept.size());
+		remap[i] = static_cast<uint32_t>(kept.size());
+		kept.push_back(Vertex{p, m.vertices[i].normal});
+		break;
+	      }
+	    if(kept[k].point == p)
+	      {
+		remap[i] = k;
+		break;
+	      }
+	  }
+      }
+    parallelFor(0, m.elements.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    m.elements[i] = remap[m.elements[i]];
+	  }
+      });
+    m.vertices.swap(kept);
+  }
+
+  bool loadStl(const std::string &filename, mesh &m)
+  {
+    auto start = std::chrono::steady_clock::now();
+    mappedFile file{filename};
+    if(!file.good())
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    if(!isBinaryStl(file.data(), file.size(), file.size()))
+      {
+	LOG("[Error] Not a binary STL (ASCII STL is not supported): "); LOG(filename); LOG("\n");
+	return false;
+      }
+    uint32_t triangles;
+    std::memcpy(&triangles, file.data() + 80, 4);
+    m.vertices.resize(3 * std::size_t(triangles));
+    m.elements.resize(3 * std::size_t(triangles));
+    const uint8_t *records = file.data() + 84;
+    parallelFor(0, triangles, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t t = lo; t < hi; ++t)
+	  {
+	    // normal, three corners, 16 bit attribute
+	    float f[12];
+	    std::memcpy(f, records + 50 * t, sizeof(f));
+	    glm::vec3 normal(f[0], f[1], f[2]);
+	    for(int k = 0; k < 3; ++k)
+	      {
+		m.vertices[3 * t + k] = Vertex{glm::vec3(f[3 + 3 * k], f[4 + 3 * k], f[5 + 3 * k]), normal};
+		m.elements[3 * t + k] = static_cast<GLuint>(3 * t + k);
+	      }
+	  }
+      });
+    logRate(filename, "binary STL", file.size(), start);
+
+    // STL repeats every corner; weld exact duplicates only
+    weldExact(m);
+    smoothNormals(m);
+    LOG("[Ok] STL "); LOG(triangles); LOG(" triangles, "); LOG(m.vertices.size());
+    LOG(" vertices after welding\n");
+    return true;
+  }
+
+  bool saveStl(const mesh &m, const std::string &filename)
+  {
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    if(!file)
+      {
+	LOG("[Error] Not able to write: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    uint32_t triangles = static_cast<uint32_t>(m.elements.size() / 3);
+    std::vector<uint8_t> out(84 + 50 * std::size_t(triangles), 0);
+    std::snprintf(reinterpret_cast<char *>(out.data()), 80, "meshtool binary STL");
+    std::memcpy(out.data() + 80, &triangles, 4);
+    parallelFor(0, triangles, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t t = lo; t < hi; ++t)
+	  {
+	    glm::vec3 p[3];
+	    for(int k = 0; k < 3; ++k)
+	      {
+		p[k] = m.vertices[m.elements[3 * t + k]].point;
+	      }
+	    glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+	    float length = glm::length(n);
+	    n = length > 0.0f ? n / length : glm::vec3(0.0f);
+	    uint8_t *r = out.data() + 84 + 50 * t;
+	    std::memcpy(r, &n, 12);
+	    std::memcpy(r + 12, p, 36);
+	  }
+      });
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+  }
+
+  /**
+   * PLY header model.  Offsets are only meaningful within an
+   * element whose properties are all scalars (fixed records).
+   */
+  enum class plyType { int8, uint8, int16, uint16, int32, uint32, float32, float64, invalid };
+
+  struct plyProperty {
+    std::string name;
+    plyType type = plyType::invalid;
+    bool list = false;
+    plyType countType = plyType::invalid;
+    std::size_t offset = 0;
+  };
+
+  struct plyElement {
+    std::string name;
+    std::size_t count = 0;
+    std::vector<plyProperty> properties;
+    std::size_t stride = 0;
+    bool fixed = true;
+
+    const plyProperty *find(const char *name) const
+    {
+      for(const plyProperty &p : properties)
+	{
+	  if(p.name == name)
+	    {
+	      return &p;
+	    }
+	}
+      return nullptr;
+    }
+  };
+
+  static plyType parsePlyType(const std::string &s)
+  {
+    if(s == "char" || s == "int8") return plyType::int8;
+    if(s == "uchar" || s == "uint8") return plyType::uint8;
+    if(s == "short" || s == "int16") return plyType::int16;
+    if(s == "ushort" || s == "uint16") return plyType::uint16;
+    if(s == "int" || s == "int32") return plyType::int32;
+    if(s == "uint" || s == "uint32") return plyType::uint32;
+    if(s == "float" || s == "float32") return plyType::float32;
+    if(s == "double" || s == "float64") return plyType::float64;
+    return plyType::invalid;
+  }
+
+  static std::size_t plySize(plyType t)
+  {
+    static const std::size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+    return sizes[static_cast<int>(t)];
+  }
+
+  /**
+   * Call fn with a value of the C++ type for t, so a generic
+   * lambda is instantiated once per type and the choice is made
+   * outside the decode loops.
+   */
+  template <typename F>
+  static void withPlyType(plyType t, F fn)
+  {
+    switch(t)
+      {
+      case plyType::int8: fn(int8_t{}); break;
+      case plyType::uint8: fn(uint8_t{}); break;
+      case plyType::int16: fn(int16_t{}); break;
+      case plyType::uint16: fn(uint16_t{}); break;
+      case plyType::int32: fn(int32_t{}); break;
+      case plyType::uint32: fn(uint32_t{}); break;
+      case plyType::float32: fn(float{}); break;
+      case plyType::float64: fn(double{}); break;
+      default: break;
+      }
+  }
+
+  template <typename T, bool Swap>
+  static inline T plyRead(const uint8_t *p)
+  {
+    T value;
+    if(Swap)
+      {
+	uint8_t b[sizeof(T)];
+	for(std::size_t i = 0; i < sizeof(T); ++i)
+	  {
+	    b[i] = p[sizeof(T) - 1 - i];
+	  }
+	std::memcpy(&value, b, sizeof(T));
+      }
+    else
+      {
+	std::memcpy(&value, p, sizeof(T));
+      }
+    return value;
+  }
+
+  /**
+   * Parse the header up to end_header; data is left at the
+   * first body byte.
+   */
+  static bool parsePlyHeader(const mappedFile &file, std::vector<plyElement> &elements,
+			     bool &bigEndian, std::size_t &data)
+  {
+    const char *text = reinterpret_cast<const char *>(file.data());
+    std::size_t pos = 0;
+    std::string format;
+    while(pos < file.size())
+      {
+	const char *nl = static_cast<const char *>(std::memchr(text + pos, '\n', file.size() - pos));
+	std::size_t end = nl ? nl - text : file.size();
+	std::string line(text + pos, end - pos);
+	pos = end + 1;
+	if(!line.empty() && line.back() == '\r')
+	  {
+	    line.pop_back();
+	  }
+	std::istringstream ss{line};
+	std::string word;
+	ss >> word;
+	if(word == "format")
+	  {
+	    ss >> format;
+	  }
+	else if(word == "element")
+	  {
+	    plyElement e;
+	    ss >> e.name >> e.count;
+	    elements.push_back(e);
+	  }
+	else if(word == "property" && !elements.empty())
+	  {
+	    plyElement &e = elements.back();
+	    plyProperty p;
+	    std::string type;
+	    ss >> type;
+	    if(type == "list")
+	      {
+		std::string countType, itemType;
+		ss >> countType >> itemType;
+		p.list = true;
+		p.countType = parsePlyType(countType);
+		p.type = parsePlyType(itemType);
+		e.fixed = false;
+	      }
+	    else
+	      {
+		p.type = parsePlyType(type);
+		p.offset = e.stride;
+		e.stride += plySize(p.type);
+	      }
+	    ss >> p.name;
+	    if(p.type == plyType::invalid || (p.list && p.countType == plyType::invalid))
+	      {
+		LOG("[Error] PLY property type not recognised: "); LOG(line); LOG("\n");
+		return false;
+	      }
+	    e.properties.push_back(p);
+	  }
+	else if(word == "end_header")
+	  {
+	    data = pos;
+	    if(format != "binary_little_endian" && format != "binary_big_endian")
+	      {
+		LOG("[Error] Only binary PLY is supported, format is: "); LOG(format); LOG("\n");
+		return false;
+	      }
+	    bigEndian = format == "binary_big_endian";
+	    return true;
+	  }
+      }
+    LOG("[Error] PLY header has no end_header\n");
+    return false;
+  }
+
+  /**
+   * Length in bytes of one record of an element with list
+   * properties, walking its properties.  False when the record
+   * does not end by end, list counts included.
+   */
+  template <bool Swap>
+  static bool plyRecordSize(const plyElement &e, const uint8_t *p, const uint8_t *end,
+			    std::size_t &size)
+  {
+    std::size_t left = p < end ? std::size_t(end - p) : 0;
+    size = 0;
+    for(const plyProperty &prop : e.properties)
+      {
+	std::size_t bytes = plySize(prop.type);
+	if(prop.list)
+	  {
+	    std::size_t count = 0;
+	    if(left - size < plySize(prop.countType))
+	      {
+		return false;
+	      }
+	    withPlyType(prop.countType, [&](auto c) {
+		count = static_cast<std::size_t>(plyRead<decltype(c), Swap>(p + size));
+	      });
+	    size += plySize(prop.countType);
+	    if(count > (left - size) / bytes)
+	      {
+		return false;
+	      }
+	    bytes *= count;
+	  }
+	if(left - size < bytes)
+	  {
+	    return false;
+	  }
+	size += bytes;
+      }
+    return true;
+  }
+
+  // Whether count records of stride bytes fit between p and end
+  static bool plyFits(const uint8_t *p, const uint8_t *end, std::size_t count, std::size_t stride)
+  {
+    return p <= end && (stride == 0 || count <= std::size_t(end - p) / stride);
+  }
+
+  template <bool Swap>
+  static bool decodePly(const mappedFile &file, const std::vector<plyElement> &elements,
+			std::size_t data, mesh &m, bool &hasNormals)
+  {
+    const uint8_t *p = file.data() + data;
+    const uint8_t *end = file.data() + file.size();
+    hasNormals = false;
+    for(const plyElement &e : elements)
+      {
+	if(e.name == "vertex")
+	  {
+	    const plyProperty *x = e.find("x"), *y = e.find("y"), *z = e.find("z");
+	    const plyProperty *nx = e.find("nx"), *ny = e.find("ny"), *nz = e.find("nz");
+	    if(!e.fixed || !x || !y || !z || x->type != y->type || x->type != z->type
+	       || !plyFits(p, end, e.count, e.stride))
+	      {
+		LOG("[Error] PLY vertex element layout not supported\n");
+		return false;
+	      }
+	    hasNormals = nx && ny && nz && nx->type == ny->type && nx->type == nz->type;
+	    m.vertices.resize(e.count);
+	    std::size_t stride = e.stride;
+	    std::size_t px = x->offset, py = y->offset, pz = z->offset;
+	    std::size_t qx = hasNormals ? nx->offset : 0, qy = hasNormals ? ny->offset : 0;
+	    std::size_t qz = hasNormals ? nz->offset : 0;
+	    const uint8_t *base = p;
+	    withPlyType(x->type, [&](auto pt) {
+		using P = decltype(pt);
+		withPlyType(hasNormals ? nx->type : plyType::float32, [&](auto nt) {
+		    using N = decltype(nt);
+		    bool normals = hasNormals;
+		    parallelFor(0, e.count, [&](std::size_t lo, std::size_t hi, unsigned) {
+			for(std::size_t i = lo; i < hi; ++i)
+			  {
+			    const uint8_t *r = base + i * stride;
+			    Vertex &v = m.vertices[i];
+			    v.point = glm::vec3(plyRead<P, Swap>(r + px), plyRead<P, Swap>(r + py),
+						plyRead<P, Swap>(r + pz));
+			    v.normal = normals
+			      ? glm::vec3(plyRead<N, Swap>(r + qx), plyRead<N, Swap>(r + qy),
+					  plyRead<N, Swap>(r + qz))
+			      : glm::vec3(0.0f);
+			  }
+		      });
+		  });
+	      });
+	    p += e.count * e.stride;
+	  }
+	else if(e.name == "face")
+	  {
+	    const plyProperty *list = e.find("vertex_indices");
+	    if(!list)
+	      {
+		list = e.find("vertex_index");
+	      }
+	    if(!list || !list->list)
+	      {
+		LOG("[Error] PLY face element has no vertex_indices list\n");
+		return false;
+	      }
+	    // Bytes of the face record before the index list
+	    std::size_t before = 0;
+	    bool scalarsOnly = true;
+	    for(const plyProperty &prop : e.properties)
+	      {
+		if(&prop == list)
+		  {
+		    break;
+		  }
+		scalarsOnly &= !prop.list;
+		before += plySize(prop.type);
+	      }
+	    bool ok = true;
+	    withPlyType(list->countType, [&](auto ct) {
+		using C = decltype(ct);
+		withPlyType(list->type, [&](auto it) {
+		    using I = decltype(it);
+		    // Fast path: only the list, and all triangles, so
+		    // the records are fixed size and decode in parallel
+		    std::size_t record = sizeof(C) + 3 * sizeof(I);
+		    bool triangles = e.properties.size() == 1 && plyFits(p, end, e.count, record);
+		    std::size_t nonTriangles = 0;
+		    if(triangles)
+		      {
+			m.elements.resize(3 * e.count);
+			nonTriangles = parallelReduce
+			  (0, e.count, std::size_t(0),
+			   [&](std::size_t lo, std::size_t hi) {
+			    std::size_t bad = 0;
+			    for(std::size_t f = lo; f < hi; ++f)
+			      {
+				const uint8_t *r = p + f * record;
+				bad += plyRead<C, Swap>(r) != C(3);
+				for(int k = 0; k < 3; ++k)
+				  {
+				    m.elements[3 * f + k] = static_cast<GLuint>
+				      (plyRead<I, Swap>(r + sizeof(C) + k * sizeof(I)));
+				  }
+			      }
+			    return bad;
+			  },
+			   [](std::size_t a, std::size_t b) { return a + b; });
+		      }
+		    if(triangles && nonTriangles == 0)
+		      {
+			p += e.count * record;
+			return;
+		      }
+		    // General path: walk the records, fan polygons
+		    m.elements.clear();
+		    for(std::size_t f = 0; f < e.count; ++f)
+		      {
+			std::size_t size;
+			if(!scalarsOnly || !plyRecordSize<Swap>(e, p, end, size))
+			  {
+			    ok = false;
+			    return;
+			  }
+			const uint8_t *r = p + before;
+			std::size_t n = static_cast<std::size_t>(plyRead<C, Swap>(r));
+			r += sizeof(C);
+			if(n < 3)
+			  {
+			    // Points and edges make no triangle, and an empty
+			    // list at the end of the data has no index to read
+			    p += size;
+			    continue;
+			  }
+			GLuint first = static_cast<GLuint>(plyRead<I, Swap>(r));
+			for(std::size_t k = 2; k < n; ++k)
+			  {
+			    m.elements.push_back(first);
+			    m.elements.push_back(static_cast<GLuint>(plyRead<I, Swap>(r + (k - 1) * sizeof(I))));
+			    m.elements.push_back(static_cast<GLuint>(plyRead<I, Swap>(r + k * sizeof(I))));
+			  }
+			p += size;
+		      }
+		  });
+	      });
+	    if(!ok)
+	      {
+		LOG("[Error] PLY face data truncated or not supported\n");
+		return false;
+	      }
+	  }
+	else
+	  {
+	    // Other elements are skipped, as long as they are there
+	    bool present = !e.fixed || plyFits(p, end, e.count, e.stride);
+	    if(e.fixed && present)
+	      {
+		p += e.count * e.stride;
+	      }
+	    for(std::size_t i = 0; !e.fixed && present && i < e.count; ++i)
+	      {
+		std::size_t size;
+		present = plyRecordSize<Swap>(e, p, end, size);
+		p += present ? size : 0;
+	      }
+	    if(!present)
+	      {
+		LOG("[Error] PLY data truncated in element "); LOG(e.name); LOG("\n");
+		return false;
+	      }
+	  }
+      }
+    return true;
+  }
+
+  bool loadPly(const std::string &filename, mesh &m)
+  {
+    auto start = std::chrono::steady_clock::now();
+    mappedFile file{filename};
+    if(!file.good())
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    std::vector<plyElement> elements;
+    bool bigEndian = false;
+    std::size_t data = 0;
+    if(!parsePlyHeader(file, elements, bigEndian, data))
+      {
+	return false;
+      }
+    bool hasNormals = false;
+    bool ok = bigEndian ? decodePly<true>(file, elements, data, m, hasNormals)
+      : decodePly<false>(file, elements, data, m, hasNormals);
+    if(!ok)
+      {
+	return false;
+      }
+    for(GLuint index : m.elements)
+      {
+	if(index >= m.vertices.size())
+	  {
+	    LOG("[Error] PLY face index out of range: "); LOG(filename); LOG("\n");
+	    return false;
+	  }
+      }
+    logRate(filename, bigEndian ? "binary big endian PLY" : "binary PLY", file.size(), start);
+    if(!hasNormals)
+      {
+	smoothNormals(m);
+      }
+    return true;
+  }
+
+  bool savePly(const mesh &m, const std::string &filename)
+  {
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    if(!file)
+      {
+	LOG("[Error] Not able to write: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    std::size_t faces = m.elements.size() / 3;
+    std::string header = "ply\nformat binary_little_endian 1.0\ncomment meshtool\n"
+      "element vertex " + std::to_string(m.vertices.size()) + "\n"
+      "property float x\nproperty float y\nproperty float z\n"
+      "property float nx\nproperty float ny\nproperty float nz\n"
+      "element face " + std::to_string(faces) + "\n"
+      "property list uchar uint vertex_indices\nend_header\n";
+    // Vertex matches the x y z nx ny nz record byte for byte
+    static_assert(sizeof(Vertex) == 24, "Vertex is six packed floats");
+    std::vector<uint8_t> body(faces * 13);
+    parallelFor(0, faces, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t f = lo; f < hi; ++f)
+	  {
+	    body[13 * f] = 3;
+	    std::memcpy(&body[13 * f + 1], &m.elements[3 * f], 12);
+	  }
+      });
+    bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+    ok = ok && std::fwrite(m.vertices.data(), sizeof(Vertex), m.vertices.size(), file)
+      == m.vertices.size();
+    ok = ok && std::fwrite(body.data(), 1, body.size(), file) == body.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,630 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <gltf.hpp>
+#include <parallel.hpp>
+#include <weld.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+namespace twg {
+
+  /**
+   * Just enough JSON for glTF: a parsed tree of values, object
+   * members kept in file order.
+   */
+  struct jsonValue {
+    enum class kind { null, boolean, number, string, array, object };
+    kind type = kind::null;
+    double number = 0.0;
+    std::string text;
+    std::vector<std::string> keys;   // object members, parallel to items
+    std::vector<jsonValue> items;
+
+    const jsonValue *get(const std::string &key) const
+    {
+      for(std::size_t i = 0; i < keys.size(); ++i)
+	{
+	  if(keys[i] == key)
+	    {
+	      return &items[i];
+	    }
+	}
+      return nullptr;
+    }
+
+    double num(const std::string &key, double fallback) const
+    {
+      const jsonValue *v = get(key);
+      return v && v->type == kind::number ? v->number : fallback;
+    }
+
+    const jsonValue *at(const std::string &key, std::size_t index) const
+    {
+      const jsonValue *v = get(key);
+      return v && v->type == kind::array && index < v->items.size() ? &v->items[index] : nullptr;
+    }
+  };
+
+  class jsonReader {
+  public:
+    jsonReader(const char *begin, const char *end) : p{begin}, end{end} {}
+
+    bool parse(jsonValue &v)
+    {
+      return value(v, 0);
+    }
+
+  private:
+    const char *p, *end;
+
+    void skip()
+    {
+      while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+	{
+	  ++p;
+	}
+    }
+
+    bool literal(const char *word)
+    {
+      std::size_t n = std::strlen(word);
+      if(std::size_t(end - p) < n || std::memcmp(p, word, n) != 0)
+	{
+	  return false;
+	}
+      p += n;
+      return true;
+    }
+
+    bool string(std::string &out)
+    {
+      ++p; // opening quote
+      while(p < end && *p != '"')
+	{
+	  if(*p != '\\')
+	    {
+	      out.push_back(*p++);
+	      continue;
+	    }
+	  if(++p >= end)
+	    {
+	      return false;
+	    }
+	  char c = *p++;
+	  switch(c)
+	    {
+	    case 'b': out.push_back('\b'); break;
+	    case 'f': out.push_back('\f'); break;
+	    case 'n': out.push_back('\n'); break;
+	    case 'r': out.push_back('\r'); break;
+	    case 't': out.push_back('\t'); break;
+	    case 'u':
+	      {
+		if(end - p < 4)
+		  {
+		    return false;
+		  }
+		unsigned code = std::strtoul(std::string(p, 4).c_str(), nullptr, 16);
+		p += 4;
+		// UTF-8, surrogates are passed through unpaired
+		if(code < 0x80)
+		  {
+		    out.push_back(static_cast<char>(code));
+		  }
+		else if(code < 0x800)
+		  {
+		    out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+		    out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+		  }
+		else
+		  {
+		    out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+		    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+		    out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+		  }
+		break;
+	      }
+	    default: out.push_back(c); break;
+	    }
+	}
+      if(p >= end)
+	{
+	  return false;
+	}
+      ++p; // closing quote
+      return true;
+    }
+
+    bool value(jsonValue &v, int depth)
+    {
+      skip();
+      if(p >= end || depth > 64)
+	{
+	  return false;
+	}
+      if(*p == '{' || *p == '[')
+	{
+	  bool object = *p == '{';
+	  char close = object ? '}' : ']';
+	  v.type = object ? jsonValue::kind::object : jsonValue::kind::array;
+	  ++p;
+	  skip();
+	  if(p < end && *p == close)
+	    {
+	      ++p;
+	      return true;
+	    }
+	  for(;;)
+	    {
+	      if(object)
+		{
+		  skip();
+		  v.keys.emplace_back();
+		  if(p >= end || *p != '"' || !string(v.keys.back()))
+		    {
+		      return false;
+		    }
+		  skip();
+		  if(p >= end || *p++ != ':')
+		    {
+		      return false;
+		    }
+		}
+	      v.items.emplace_back();
+	      if(!value(v.items.back(), depth + 1))
+		{
+		  return false;
+		}
+	      skip();
+	      if(p < end && *p == ',')
+		{
+		  ++p;
+		  continue;
+		}
+	      if(p < end && *p == close)
+		{
+		  ++p;
+		  return true;
+		}
+	      return false;
+	    }
+	}
+      if(*p == '"')
+	{
+	  v.type = jsonValue::kind::string;
+	  return string(v.text);
+	}
+      if(literal("true") || literal("false"))
+	{
+	  v.type = jsonValue::kind::boolean;
+	  v.number = p[-1] == 'e' && p[-2] == 'u';
+	  return true;
+	}
+      if(literal("null"))
+	{
+	  return true;
+	}
+      const char *start = p;
+      while(p < end && std::strchr("+-0123456789.eE", *p))
+	{
+	  ++p;
+	}
+      if(p == start)
+	{
+	  return false;
+	}
+      v.type = jsonValue::kind::number;
+      v.number = std::strtod(std::string(start, p).c_str(), nullptr);
+      return true;
+    }
+  };
+
+  enum gltfComponent { gltfByte = 5120, gltfUnsignedByte = 5121, gltfShort = 5122,
+		       gltfUnsignedShort = 5123, gltfUnsignedInt = 5125, gltfFloat = 5126 };
+
+  struct gltfAccessor {
+    const uint8_t *base = nullptr;
+    std::size_t count = 0;
+    std::size_t stride = 0;
+    int component = 0;
+    int components = 0;
+    std::size_t bufferView = 0;
+    std::size_t offset = 0;   // within the buffer view
+  };
+
+  struct gltfBuffer {
+    const uint8_t *data = nullptr;
+    std::size_t size = 0;
+  };
+
+  static std::size_t componentSize(int component)
+  {
+    switch(component)
+      {
+      case gltfByte: case gltfUnsignedByte: return 1;
+      case gltfShort: case gltfUnsignedShort: return 2;
+      case gltfUnsignedInt: case gltfFloat: return 4;
+      default: return 0;
+      }
+  }
+
+  /**
+   * A JSON number as a size, false unless it is a whole number
+   * from 0 to limit.  Limits are real sizes, well inside what a
+   * double holds exactly.
+   */
+  static bool toSize(double value, std::size_t limit, std::size_t &out)
+  {
+    if(!(value >= 0.0 && value <= static_cast<double>(limit)) || value != std::floor(value))
+      {
+	return false;
+      }
+    out = static_cast<std::size_t>(value);
+    return true;
+  }
+
+  /**
+   * Resolve accessor reference to a base pointer and stride,
+   * checking it lies inside its buffer view and buffer.  Sums
+   * and products of file values are never formed, so a hostile
+   * file cannot wrap them past the checks.
+   */
+  static bool readAccessor(const jsonValue &doc, const std::vector<gltfBuffer> &buffers,
+			   double reference, gltfAccessor &out)
+  {
+    std::size_t index = 0;
+    const jsonValue *a = toSize(reference, UINT32_MAX, index) ? doc.at("accessors", index) : nullptr;
+    if(!a || !a->get("bufferView") || a->get("sparse"))
+      {
+	LOG("[Error] glTF accessor "); LOG(reference); LOG(" has no buffer view or is sparse\n");
+	return false;
+      }
+    const jsonValue *type = a->get("type");
+    std::string t = type ? type->text : "";
+    out.components = t == "SCALAR" ? 1 : t == "VEC2" ? 2 : t == "VEC3" ? 3 : t == "VEC4" ? 4 : 0;
+    std::size_t component = 0;
+    out.component = toSize(a->num("componentType", 0), gltfFloat, component) ? static_cast<int>(component) : 0;
+    std::size_t element = componentSize(out.component) * out.components;
+    const jsonValue *view = toSize(a->num("bufferView", 0), UINT32_MAX, out.bufferView)
+      ? doc.at("bufferViews", out.bufferView) : nullptr;
+    std::size_t buffer = 0;
+    if(!view || element == 0 || !toSize(view->num("buffer", 0), buffers.size(), buffer)
+       || buffer == buffers.size())
+      {
+	LOG("[Error] glTF accessor "); LOG(index); LOG(" is malformed\n");
+	return false;
+      }
+    std::size_t size = buffers[buffer].size;
+    std::size_t viewOffset = 0, viewLength = 0;
+    bool inside = toSize(view->num("byteOffset", 0), size, viewOffset)
+      && toSize(view->num("byteLength", 0), size - viewOffset, viewLength)
+      && toSize(a->num("byteOffset", 0), viewLength, out.offset)
+      && toSize(a->num("count", 0), viewLength, out.count)
+      && toSize(view->num("byteStride", 0), viewLength, out.stride)
+      && element <= viewLength - out.offset;
+    out.stride = out.stride ? out.stride : element;
+    if(!inside || (out.count > 0 && out.count - 1 > (viewLength - out.offset - element) / out.stride))
+      {
+	LOG("[Error] glTF accessor "); LOG(index); LOG(" is out of bounds\n");
+	return false;
+      }
+    out.base = buffers[buffer].data + viewOffset + out.offset;
+    return true;
+  }
+
+  template <typename T>
+  static T readUnaligned(const uint8_t *p)
+  {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+  }
+
+  bool gltfAsset::load(const std::string &filename)
+  {
+    auto start = std::chrono::steady_clock::now();
+    files.clear();
+    owned = mesh{};
+    data = meshView{};
+    mapped = false;
+    files.emplace_back(new mappedFile{filename});
+    const mappedFile &file = *files.back();
+    if(!file.good())
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+
+    // GLB: 12 byte header, JSON chunk, optional BIN chunk
+    const char *json = reinterpret_cast<const char *>(file.data());
+    std::size_t jsonSize = file.size();
+    gltfBuffer bin;
+    bool glb = file.size() >= 20 && std::memcmp(file.data(), "glTF", 4) == 0;
+    if(glb)
+      {
+	uint32_t length = readUnaligned<uint32_t>(file.data() + 12);
+	if(readUnaligned<uint32_t>(file.data() + 16) != 0x4E4F534A || 20 + uint64_t(length) > file.size())
+	  {
+	    LOG("[Error] GLB has no JSON chunk: "); LOG(filename); LOG("\n");
+	    return false;
+	  }
+	json = reinterpret_cast<const char *>(file.data() + 20);
+	jsonSize = length;
+	std::size_t next = 20 + ((length + 3) & ~3u);
+	if(next + 8 <= file.size() && readUnaligned<uint32_t>(file.data() + next + 4) == 0x004E4942)
+	  {
+	    bin.data = file.data() + next + 8;
+	    bin.size = std::min<std::size_t>(readUnaligned<uint32_t>(file.data() + next),
+					     file.size() - next - 8);
+	  }
+      }
+    jsonValue doc;
+    if(!jsonReader{json, json + jsonSize}.parse(doc) || doc.type != jsonValue::kind::object)
+      {
+	LOG("[Error] glTF JSON could not be parsed: "); LOG(filename); LOG("\n");
+	return false;
+      }
+
+    // Buffers: the GLB chunk, or files next to the .gltf
+    std::vector<gltfBuffer> buffers;
+    std::string dir = filename.substr(0, filename.find_last_of('/') + 1);
+    if(const jsonValue *list = doc.get("buffers"))
+      {
+	for(const jsonValue &b : list->items)
+	  {
+	    const jsonValue *uri = b.get("uri");
+	    if(!uri)
+	      {
+		buffers.push_back(bin);
+		continue;
+	      }
+	    if(uri->text.compare(0, 5, "data:") == 0)
+	      {
+		LOG("[Error] glTF data: URIs are not supported: "); LOG(filename); LOG("\n");
+		return false;
+	      }
+	    files.emplace_back(new mappedFile{dir + uri->text});
+	    if(!files.back()->good())
+	      {
+		LOG("[Error] Not able to open glTF buffer: "); LOG(dir + uri->text); LOG("\n");
+		return false;
+	      }
+	    buffers.push_back({files.back()->data(), files.back()->size()});
+	  }
+      }
+
+    // Triangle primitives of every mesh
+    std::vector<const jsonValue *> primitives;
+    if(const jsonValue *meshes = doc.get("meshes"))
+      {
+	for(const jsonValue &m : meshes->items)
+	  {
+	    if(const jsonValue *list = m.get("primitives"))
+	      {
+		for(const jsonValue &p : list->items)
+		  {
+		    if(p.num("mode", 4) == 4 && p.get("attributes"))
+		      {
+			primitives.push_back(&p);
+		      }
+		  }
+	      }
+	  }
+      }
+
+    struct primitiveData { gltfAccessor position, normal, indices; bool hasNormal, hasIndices; };
+    std::vector<primitiveData> parts;
+    for(const jsonValue *p : primitives)
+      {
+	primitiveData d{};
+	const jsonValue *attributes = p->get("attributes");
+	const jsonValue *position = attributes->get("POSITION");
+	const jsonValue *normal = attributes->get("NORMAL");
+	const jsonValue *indices = p->get("indices");
+	if(!position || !readAccessor(doc, buffers, position->number, d.position))
+	  {
+	    return false;
+	  }
+	d.hasNormal = normal != nullptr;
+	d.hasIndices = indices != nullptr;
+	if((d.hasNormal && !readAccessor(doc, buffers, normal->number, d.normal))
+	   || (d.hasIndices && !readAccessor(doc, buffers, indices->number, d.indices)))
+	  {
+	    return false;
+	  }
+	if(d.position.component != gltfFloat || d.position.components != 3
+	   || (d.hasNormal && (d.normal.component != gltfFloat || d.normal.components != 3
+			       || d.normal.count != d.position.count))
+	   || (d.hasIndices && (d.indices.components != 1 || d.indices.component == gltfFloat)))
+	  {
+	    LOG("[Error] glTF primitive accessors not supported: "); LOG(filename); LOG("\n");
+	    return false;
+	  }
+	parts.push_back(d);
+      }
+
+    // Zero copy: one primitive already in Vertex layout
+    if(parts.size() == 1)
+      {
+	const primitiveData &d = parts[0];
+	mapped = d.hasNormal && d.hasIndices
+	  && d.position.bufferView == d.normal.bufferView
+	  && d.position.stride == sizeof(Vertex) && d.normal.stride == sizeof(Vertex)
+	  && d.normal.offset == d.position.offset + offsetof(Vertex, normal)
+	  && reinterpret_cast<uintptr_t>(d.position.base) % alignof(Vertex) == 0
+	  && d.indices.component == gltfUnsignedInt && d.indices.stride == sizeof(GLuint)
+	  && reinterpret_cast<uintptr_t>(d.indices.base) % alignof(GLuint) == 0;
+	if(mapped)
+	  {
+	    data.vertices = reinterpret_cast<const Vertex *>(d.position.base);
+	    data.vertexCount = d.position.count;
+	    data.elements = reinterpret_cast<const GLuint *>(d.indices.base);
+	    data.elementCount = d.indices.count / 3 * 3;
+	  }
+      }
+
+    bool smooth = false;
+    if(!mapped)
+      {
+	std::size_t vertices = 0, elements = 0;
+	for(const primitiveData &d : parts)
+	  {
+	    vertices += d.position.count;
+	    elements += (d.hasIndices ? d.indices.count : d.position.count) / 3 * 3;
+	    smooth |= !d.hasNormal;
+	  }
+	owned.vertices.resize(vertices);
+	owned.elements.resize(elements);
+	std::size_t firstVertex = 0, firstElement = 0;
+	for(const primitiveData &d : parts)
+	  {
+	    parallelFor(0, d.position.count, [&](std::size_t lo, std::size_t hi, unsigned) {
+		for(std::size_t i = lo; i < hi; ++i)
+		  {
+		    Vertex &v = owned.vertices[firstVertex + i];
+		    std::memcpy(&v.point, d.position.base + i * d.position.stride, 12);
+		    if(d.hasNormal)
+		      {
+			std::memcpy(&v.normal, d.normal.base + i * d.normal.stride, 12);
+		      }
+		  }
+	      });
+	    std::size_t count = (d.hasIndices ? d.indices.count : d.position.count) / 3 * 3;
+	    const gltfAccessor &ix = d.indices;
+	    bool ok = parallelReduce
+	      (0, count, true,
+	       [&](std::size_t lo, std::size_t hi) {
+		bool inRange = true;
+		for(std::size_t i = lo; i < hi; ++i)
+		  {
+		    std::size_t index = i;
+		    if(d.hasIndices)
+		      {
+			const uint8_t *q = ix.base + i * ix.stride;
+			index = ix.component == gltfUnsignedInt ? readUnaligned<uint32_t>(q)
+			  : ix.component == gltfUnsignedShort ? readUnaligned<uint16_t>(q) : *q;
+		      }
+		    inRange &= index < d.position.count;
+		    owned.elements[firstElement + i] = static_cast<GLuint>(firstVertex + index);
+		  }
+		return inRange;
+	      },
+	       [](bool a, bool b) { return a && b; });
+	    if(!ok)
+	      {
+		LOG("[Error] glTF index out of range: "); LOG(filename); LOG("\n");
+		return false;
+	      }
+	    firstVertex += d.position.count;
+	    firstElement += count;
+	  }
+	if(smooth)
+	  {
+	    smoothNormals(owned);
+	  }
+	data = meshView{owned};
+      }
+    else
+      {
+	bool ok = parallelReduce
+	  (0, data.elementCount, true,
+	   [&](std::size_t lo, std::size_t hi) {
+	    bool inRange = true;
+	    for(std::size_t i = lo; i < hi; ++i)
+	      {
+		inRange &= data.elements[i] < data.vertexCount;
+	      }
+	    return inRange;
+	  },
+	   [](bool a, bool b) { return a && b; });
+	if(!ok)
+	  {
+	    LOG("[Error] glTF index out of range: "); LOG(filename); LOG("\n");
+	    return false;
+	  }
+      }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("[Ok] Read "); LOG(filename); LOG(" ("); LOG((glb ? "GLB" : "glTF"));
+    LOG((mapped ? ", zero copy" : ", converted")); LOG(") "); LOG(parts.size());
+    LOG(" primitives, "); LOG(data.elementCount / 3); LOG(" triangles in ");
+    LOG(seconds * 1e3); LOG(" ms\n");
+    return true;
+  }
+
+  void gltfAsset::toMesh(mesh &m) const
+  {
+    m.vertices.assign(data.vertices, data.vertices + data.vertexCount);
+    m.elements.assign(data.elements, data.elements + data.elementCount);
+  }
+
+  /**
+   * One buffer: interleaved vertices (byteStride 24) then the
+   * 32 bit indices, so gltfAsset reads the file zero copy.
+   */
+  bool saveGlb(const mesh &m, const std::string &filename)
+  {
+    std::size_t vertexBytes = m.vertices.size() * sizeof(Vertex);
+    std::size_t indexBytes = m.elements.size() / 3 * 3 * sizeof(GLuint);
+    glm::vec3 lo{0.0f}, hi{0.0f};
+    if(!m.vertices.empty())
+      {
+	lo = hi = m.vertices[0].point;
+	for(const Vertex &v : m.vertices)
+	  {
+	    lo = glm::min(lo, v.point);
+	    hi = glm::max(hi, v.point);
+	  }
+      }
+    std::ostringstream json;
+    json << std::setprecision(9)
+	 << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"meshtool\"},"
+	 << "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+	 << "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1},"
+	 << "\"indices\":2,\"mode\":4}]}],"
+	 << "\"buffers\":[{\"byteLength\":" << vertexBytes + indexBytes << "}],"
+	 << "\"bufferViews\":["
+	 << "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << vertexBytes
+	 << ",\"byteStride\":" << sizeof(Vertex) << ",\"target\":34962},"
+	 << "{\"buffer\":0,\"byteOffset\":" << vertexBytes << ",\"byteLength\":" << indexBytes
+	 << ",\"target\":34963}],"
+	 << "\"accessors\":["
+	 << "{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":" << m.vertices.size()
+	 << ",\"type\":\"VEC3\",\"min\":[" << lo.x << "," << lo.y << "," << lo.z
+	 << "],\"max\":[" << hi.x << "," << hi.y << "," << hi.z << "]},"
+	 << "{\"bufferView\":0,\"byteOffset\":" << offsetof(Vertex, normal)
+	 << ",\"componentType\":5126,\"count\":" << m.vertices.size() << ",\"type\":\"VEC3\"},"
+	 << "{\"bufferView\":1,\"byteOffset\":0,\"componentType\":5125,\"count\":"
+	 << indexBytes / sizeof(GLuint) << ",\"type\":\"SCALAR\"}]}";
+    std::string text = json.str();
+    text.resize((text.size() + 3) & ~std::size_t(3), ' ');
+
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    if(!file)
+      {
+	LOG("[Error] Not able to write: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    uint32_t binBytes = static_cast<uint32_t>(vertexBytes + indexBytes);
+    uint32_t header[5] = {0x46546C67, 2, static_cast<uint32_t>(12 + 8 + text.size() + 8 + binBytes),
+			  static_cast<uint32_t>(text.size()), 0x4E4F534A};
+    uint32_t binHeader[2] = {binBytes, 0x004E4942};
+    bool ok = std::fwrite(header, sizeof(header), 1, file) == 1
+      && std::fwrite(text.data(), 1, text.size(), file) == text.size()
+      && std::fwrite(binHeader, sizeof(binHeader), 1, file) == 1
+      && std::fwrite(m.vertices.data(), 1, vertexBytes, file) == vertexBytes
+      && std::fwrite(m.elements.data(), 1, indexBytes, file) == indexBytes;
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,327 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <headless.hpp>
+#include <materials.hpp>
+#ifdef MESHTOOL_WITH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace twg {
+
+  bool headlessContext::init()
+  {
+#ifdef MESHTOOL_WITH_EGL
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>
+      (eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if(getPlatformDisplay)
+      {
+	dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+      }
+    if(dpy == EGL_NO_DISPLAY)
+      {
+	dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+      }
+    EGLint major = 0, minor = 0;
+    if(dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor))
+      {
+	LOG("[Error] EGL: no display could be initialized\n");
+	return false;
+      }
+    if(!eglBindAPI(EGL_OPENGL_API))
+      {
+	LOG("[Error] EGL: desktop OpenGL is not available\n");
+	eglTerminate(dpy);
+	return false;
+      }
+
+    // No surface is ever created, the config only has to
+    // support desktop GL rendering
+    const EGLint configAttribs[] = {
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configs = 0;
+    EGLContext ctx = EGL_NO_CONTEXT;
+    if(eglChooseConfig(dpy, configAttribs, &config, 1, &configs) && configs > 0)
+      {
+	ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, nullptr);
+      }
+    if(ctx == EGL_NO_CONTEXT)
+      {
+	// EGL_KHR_no_config_context
+	ctx = eglCreateContext(dpy, static_cast<EGLConfig>(nullptr), EGL_NO_CONTEXT, nullptr);
+      }
+    if(ctx == EGL_NO_CONTEXT
+       || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx))
+      {
+	LOG("[Error] EGL: surfaceless context creation failed\n");
+	eglTerminate(dpy);
+	return false;
+      }
+    display = dpy;
+    context = ctx;
+
+    // GLEW built for GLX reports the missing X display, the GL
+    // entry points are loaded regardless
+    glewExperimental = GL_TRUE;
+    glewInit();
+    LOG("[Ok] EGL "); LOG(major); LOG("."); LOG(minor);
+    LOG(" headless, GL_VERSION= "); LOG(glGetString(GL_VERSION));
+    LOG(", GL_RENDERER= "); LOG(glGetString(GL_RENDERER)); LOG("\n");
+    return true;
+#else
+    LOG("[Error] Headless rendering needs a build with MESHTOOL_WITH_EGL\n");
+    return false;
+#endif
+  }
+
+  void headlessContext::release()
+  {
+#ifdef MESHTOOL_WITH_EGL
+    if(display)
+      {
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, context);
+	eglTerminate(display);
+      }
+#endif
+    display = context = nullptr;
+  }
+
+  bool offscreenRenderer::init(int w, int h)
+  {
+    width = w;
+    height = h;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+      {
+	LOG("[Error] Offscreen framebuffer incomplete at "); LOG(w); LOG("x"); LOG(h); LOG("\n");
+	return false;
+      }
+    glViewport(0, 0, w, h);
+
+    program = Program{"shaders/basic.vs", "shaders/basic.fs"};
+    glUseProgram(program.ID);
+
+    // Same camera as the viewer
+    mats.matrixMode(matrices::PROJECTION_MATRIX);
+    mats.perspective(glm::radians(45.0f),
+		     static_cast<float>(w) / static_cast<float>(h), 0.1f, 100.0f);
+    mats.matrixMode(matrices::VIEW_MATRIX);
+    mats.lookAt(glm::vec3(0.0f, 0.0f, 2.5f), glm::vec3(0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+    mats.matrixMode(matrices::MODEL_MATRIX);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    GLint pos = glGetAttribLocation(program.ID, "vPos");
+    GLint normal = glGetAttribLocation(program.ID, "vNormal");
+    if(pos >= 0)
+      {
+	glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			      reinterpret_cast<void *>(offsetof(Vertex, point)));
+	glEnableVertexAttribArray(pos);
+      }
+    if(normal >= 0)
+      {
+	glVertexAttribPointer(normal, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			      reinterpret_cast<void *>(offsetof(Vertex, normal)));
+	glEnableVertexAttribArray(normal);
+      }
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.15, 0.22, 0.15, 1.0);
+    return true;
+  }
+
+  /**
+   * Centre and radius of the bounding box, so render() fits
+   * the mesh the way the scene viewer does.
+   */
+  void offscreenRenderer::frame(const meshView &m)
+  {
+    glm::vec3 lo{std::numeric_limits<float>::max()}, hi{-std::numeric_limits<float>::max()};
+    for(std::size_t i = 0; i < m.vertexCount; ++i)
+      {
+	lo = glm::min(lo, m.vertices[i].point);
+	hi = glm::max(hi, m.vertices[i].point);
+      }
+    center = m.vertexCount == 0 ? glm::vec3(0.0f) : 0.5f * (lo + hi);
+    radius = m.vertexCount == 0 ? 1.0f : std::max(0.5f * glm::length(hi - lo), 1e-6f);
+  }
+
+  /**
+   * Replace the drawn mesh, reusing the buffer objects.
+   */
+  void offscreenRenderer::upload(const meshView &m)
+  {
+    if(materials)
+      {
+	materials->release();
+	delete materials;
+	materials = nullptr;
+      }
+    colored = false;
+    frame(m);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, m.vertexCount * sizeof(Vertex), m.vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m.elementCount * sizeof(GLuint), m.elements,
+		 GL_STATIC_DRAW);
+    count = static_cast<GLsizei>(m.elementCount);
+  }
+
+  void offscreenRenderer::upload(const mesh &m)
+  {
+    if(m.materials.empty() || !m.colors.empty())
+      {
+	upload(meshView{m});
+	if(m.colors.size() == m.vertices.size() && !m.colors.empty())
+	  {
+	    if(!colorVao)
+	      {
+		// Shares vbo and ebo, adds the colour buffer at location 2
+		colorProgram = Program{"shaders/color.vs", "shaders/color.fs"};
+		glGenVertexArrays(1, &colorVao);
+		glBindVertexArray(colorVao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+				      reinterpret_cast<void *>(offsetof(Vertex, point)));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+				      reinterpret_cast<void *>(offsetof(Vertex, normal)));
+		glEnableVertexAttribArray(1);
+		glGenBuffers(1, &colorVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, colorVbo);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+		glEnableVertexAttribArray(2);
+	      }
+	    glBindBuffer(GL_ARRAY_BUFFER, colorVbo);
+	    glBufferData(GL_ARRAY_BUFFER, m.colors.size() * sizeof(glm::vec3),
+			 m.colors.data(), GL_STATIC_DRAW);
+	    colored = true;
+	  }
+	return;
+      }
+    colored = false;
+    if(materials)
+      {
+	materials->release();
+	delete materials;
+      }
+    if(!materialVao)
+      {
+	materialProgram = Program{"shaders/material.vs", "shaders/material.fs"};
+	glGenVertexArrays(1, &materialVao);
+      }
+    frame(meshView{m});
+    glUseProgram(materialProgram.ID);
+    glBindVertexArray(materialVao);
+    materials = new materialDraw;
+    materials->upload(m, materialProgram.ID);
+  }
+
+  void offscreenRenderer::bind()
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+  }
+
+  /**
+   * Draw the uploaded mesh rotated by angles (x, y, z radians,
+   * applied as the viewer does).
+   */
+  void offscreenRenderer::render(const glm::vec3 &angles)
+  {
+    bind();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    GLuint id = materials ? materialProgram.ID : colored ? colorProgram.ID : program.ID;
+    glUseProgram(id);
+    glBindVertexArray(materials ? materialVao : colored ? colorVao : vao);
+
+    mats.loadMatrix(glm::aligned_mat4{glm::eulerAngleYXZ(angles.y, angles.x, angles.z)});
+    mats.scale(glm::vec3(1.0f / radius));
+    mats.translate(-center);
+    glUniformMatrix4fv(glGetUniformLocation(id, "mvM"), 1, GL_FALSE,
+		       glm::value_ptr(mats.getModelViewMatrix()));
+    glUniformMatrix3fv(glGetUniformLocation(id, "nM"), 1, GL_FALSE,
+		       glm::value_ptr(mats.getNormalMatrix()));
+    glUniformMatrix4fv(glGetUniformLocation(id, "mvpM"), 1, GL_FALSE,
+		       glm::value_ptr(mats.getMVPMatrix()));
+    if(materials)
+      {
+	materials->draw();
+      }
+    else
+      {
+	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+      }
+  }
+
+  /**
+   * Synchronous readback of the last render, bottom row first.
+   */
+  void offscreenRenderer::read(std::vector<uint8_t> &rgba)
+  {
+    rgba.resize(4 * static_cast<std::size_t>(width) * height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+  }
+
+  void offscreenRenderer::release()
+  {
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program.ID);
+    if(materials)
+      {
+	materials->release();
+	delete materials;
+	materials = nullptr;
+      }
+    if(materialVao)
+      {
+	glDeleteVertexArrays(1, &materialVao);
+	glDeleteProgram(materialProgram.ID);
+	materialVao = 0;
+      }
+    if(colorVao)
+      {
+	glDeleteBuffers(1, &colorVbo);
+	glDeleteVertexArrays(1, &colorVao);
+	glDeleteProgram(colorProgram.ID);
+	colorVao = colorVbo = 0;
+      }
+    colored = false;
+    glDeleteRenderbuffers(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteFramebuffers(1, &fbo);
+    fbo = color = depth = vao = vbo = ebo = 0;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,66 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __ADJACENCY_HPP__
+#define __ADJACENCY_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * Flat adjacency for an indexed triangle mesh.
+   *
+   * Half-edge h is corner h of the element array: it starts at
+   * elements[h] and runs to elements[next(h)] within face h/3,
+   * so the half-edge table itself is implicit and only twins
+   * are stored.  twin[h] is invalid on boundary, degenerate and
+   * non-manifold edges.
+   *
+   * Vertex v's corners (the half-edges leaving it) are
+   * corners[cornerOffsets[v] .. cornerOffsets[v + 1]), in
+   * ascending order; corner / 3 is the face.
+   */
+  struct meshAdjacency {
+    static constexpr uint32_t invalid = 0xffffffffu;
+
+    std::vector<uint32_t> cornerOffsets;
+    std::vector<uint32_t> corners;
+    std::vector<uint32_t> twin;
+    std::size_t boundaryEdges = 0;
+    std::size_t nonManifoldEdges = 0;
+
+    static uint32_t face(uint32_t h) { return h / 3; }
+    static uint32_t next(uint32_t h) { return h % 3 == 2 ? h - 2 : h + 1; }
+    static uint32_t prev(uint32_t h) { return h % 3 == 0 ? h + 2 : h - 1; }
+
+    std::size_t vertexCount() const
+    {
+      return cornerOffsets.empty() ? 0 : cornerOffsets.size() - 1;
+    }
+    std::size_t valence(uint32_t v) const
+    {
+      return cornerOffsets[v + 1] - cornerOffsets[v];
+    }
+    std::size_t memoryBytes() const
+    {
+      return (cornerOffsets.size() + corners.size() + twin.size()) * sizeof(uint32_t);
+    }
+  };
+
+  /**
+   * Build in parallel: one radix sort of the corners by vertex
+   * gives the CSR, twins are then matched within the short
+   * per vertex corner lists.
+   */
+  meshAdjacency buildAdjacency(const mesh &m);
+
+} /* End twg namespace */
+#endif
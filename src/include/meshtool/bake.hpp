@@ -0,0 +1,65 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __BAKE_HPP__
+#define __BAKE_HPP__
+
+#include <meshtool.hpp>
+#include <adjacency.hpp>
+#include <bvh.hpp>
+
+namespace twg {
+
+  enum class bakeKind { none, mean, gaussian, occlusion };
+
+  bool parseBakeKind(const std::string &name, bakeKind &kind);
+
+  /**
+   * Discrete curvature per vertex from the one-ring in the
+   * adjacency corner lists: mean curvature from the cotangent
+   * Laplacian (positive where convex), Gaussian curvature from
+   * the angle deficit, both over a third of the ring's area.
+   * Boundary and isolated vertices get 0.
+   */
+  void computeCurvature(const mesh &m, const meshAdjacency &adj,
+			std::vector<float> &mean, std::vector<float> &gaussian);
+
+  /**
+   * Ambient occlusion per vertex: the fraction of rays rays
+   * cosine distributed about the normal that escape within
+   * distance (0: a quarter of the bounding box diagonal), so 1
+   * is fully open.  Rays go through the BVH four at a time;
+   * vertices are handed to workers in small blocks because
+   * their cost varies with how enclosed they are.
+   */
+  std::vector<float> computeOcclusion(const mesh &m, const meshBvh &bvh,
+				      int rays = 64, float distance = 0.0f);
+
+  /**
+   * Fill m.colors from per vertex values: grey levels for
+   * occlusion, a blue-white-red ramp for signed curvature
+   * scaled to the 95th percentile of its magnitude.
+   */
+  void colorize(mesh &m, const std::vector<float> &values, bool isSigned);
+
+  struct bakeStats {
+    double buildSeconds = 0.0;    // adjacency or BVH
+    double bakeSeconds = 0.0;
+    std::size_t rays = 0;
+
+    double raysPerSecond() const { return bakeSeconds > 0.0 ? rays / bakeSeconds : 0.0; }
+  };
+
+  /**
+   * Compute kind for m and store it in m.colors.
+   */
+  bakeStats bake(mesh &m, bakeKind kind, int rays = 64);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,111 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __BATCH_HPP__
+#define __BATCH_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace twg {
+
+  /**
+   * 64 bit non-cryptographic hash of a byte range in the style
+   * of XXH3: 64 byte stripes are mixed into eight 64 bit lanes
+   * with a key that slides along a 192 byte table, two lanes
+   * per SSE2 register, and the lanes are scrambled every 16
+   * stripes.  The scalar path gives the same values, so
+   * manifests move between builds.
+   */
+  uint64_t contentHash(const void *data, std::size_t size);
+
+  /**
+   * contentHash of a whole file through a read only mapping.
+   */
+  bool hashFile(const std::string &filename, uint64_t &hash);
+
+  /**
+   * Output file for an input path in dir: directories and a
+   * known mesh extension (.obj.gz, .stl, ...) stripped unless
+   * keepSource is set, extension appended.
+   */
+  std::string outputName(const std::string &dir, const std::string &input,
+			 const std::string &extension, bool keepSource = false);
+
+  /**
+   * outputName for every input, keeping the source extension
+   * (a.stl.png, a.ply.png) for inputs that would otherwise
+   * share a name.  Inputs with one file name in different
+   * directories still clash; callers must check.
+   */
+  std::vector<std::string> outputNames(const std::string &dir,
+				       const std::vector<std::string> &inputs,
+				       const std::string &extension);
+
+  struct manifestEntry {
+    uint64_t size = 0;
+    int64_t mtime = 0;         // nanoseconds
+    uint64_t hash = 0;
+    std::string output;
+    uint64_t outputSize = 0;
+    uint64_t outputHash = 0;
+  };
+
+  /**
+   * What a previous batch run converted, by input path.  Stored
+   * as one tab separated line per input under a header naming
+   * the settings the outputs were made with; a manifest made
+   * with other settings loads empty.
+   */
+  class conversionManifest {
+  public:
+    bool load(const std::string &filename, const std::string &settings);
+    bool save(const std::string &filename, const std::string &settings) const;
+
+    std::unordered_map<std::string, manifestEntry> entries;
+  };
+
+  struct batchOptions {
+    std::string dir;           // outputs go here
+    std::string extension;     // ".mshz", ".ply", ...
+    std::string manifest;      // empty: <dir>/.meshtool-manifest
+    std::string settings;      // load options that change the output
+    std::function<bool(const std::string &, mesh &)> load;
+    std::function<bool(const mesh &, const std::string &)> save;
+  };
+
+  struct batchStats {
+    std::size_t inputs = 0;
+    std::size_t unchanged = 0;   // size and mtime matched
+    std::size_t touched = 0;     // new mtime, same content
+    std::size_t duplicates = 0;  // copied from an identical input
+    std::size_t converted = 0;
+    std::size_t failed = 0;
+    std::size_t unreadable = 0;  // of failed: missing, unreadable or not decodable
+    std::size_t hashedBytes = 0;
+    double scanSeconds = 0.0;
+    double convertSeconds = 0.0;
+  };
+
+  /**
+   * Incremental batch conversion.  Inputs whose size and mtime
+   * match the manifest and whose output is still there are
+   * skipped without reading them; the rest are hashed, and
+   * those whose content is unchanged only get their manifest
+   * entry refreshed.  Of the changed inputs, byte identical
+   * ones (same hash, confirmed by comparing the files) are
+   * converted once and the output copied to the others.  The
+   * remaining conversions run as tasks on the shared pool.
+   */
+  batchStats convertBatch(const std::vector<std::string> &inputs, const batchOptions &options);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,26 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <meshtool.hpp>
+
+namespace twg {
+
+  /**
+   * Headless benchmarks, selected with --bench <kind>.  Each
+   * prints one line per measurement to stdout.  Returns the
+   * process exit code.
+   */
+  int runBenchmark(const std::string &kind,
+		   const std::vector<std::string> &inputs);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,72 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __BVH_HPP__
+#define __BVH_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * Flat BVH node, 32 bytes.  Inner nodes have count 0, their
+   * left child follows them and first is the right child;
+   * leaves hold triangles [first, first + count).
+   */
+  struct bvhNode {
+    glm::vec3 lo;
+    uint32_t first;
+    glm::vec3 hi;
+    uint32_t count;
+  };
+
+  /**
+   * Triangle stored for Moller-Trumbore: a corner and the two
+   * edges leaving it.
+   */
+  struct bvhTriangle {
+    glm::vec3 v0, e1, e2;
+  };
+
+  /**
+   * Bounding volume hierarchy over a mesh's triangles for
+   * occlusion queries.  Built top down by splitting at the
+   * centroid median of the longest axis, up to leafSize
+   * triangles per leaf, in depth first order.
+   *
+   * occluded4 traces a packet of four rays that share an
+   * origin (the AO case), so the origin terms of the box and
+   * triangle tests are scalar and only the directions are
+   * SIMD lanes.  Any hit ends a ray; the packet stops when all
+   * four are blocked.  Without SSE the lanes run one by one.
+   */
+  class meshBvh {
+  public:
+    static constexpr uint32_t leafSize = 4;
+
+    void build(const mesh &m);
+    // Bit i set when ray i of the active lanes hits within (0, tMax)
+    unsigned occluded4(const glm::vec3 &origin, const glm::vec3 dir[4],
+		       float tMax, unsigned active = 0xf) const;
+    bool occluded(const glm::vec3 &origin, const glm::vec3 &dir, float tMax) const;
+
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t memoryBytes() const
+    {
+      return nodes.size() * sizeof(bvhNode) + triangles.size() * sizeof(bvhTriangle);
+    }
+
+  private:
+    std::vector<bvhNode> nodes;
+    std::vector<bvhTriangle> triangles;   // in leaf order
+  };
+
+} /* End twg namespace */
+#endif
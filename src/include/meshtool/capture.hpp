@@ -0,0 +1,78 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __CAPTURE_HPP__
+#define __CAPTURE_HPP__
+
+#include <meshtool.hpp>
+#include <threadpool.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace twg {
+
+  /**
+   * Write an 8 bit RGB PNG from RGBA pixels stored bottom row
+   * first, as glReadPixels returns them.  Alpha is dropped.
+   */
+  bool writePng(const std::string &filename, int width, int height,
+		const std::vector<uint8_t> &rgba);
+
+  /**
+   * Asynchronous framebuffer capture.  request() starts a
+   * glReadPixels of the bound read framebuffer (the back buffer
+   * in the viewer) into the next pixel pack buffer of a ring and
+   * fences it; poll() maps the buffers whose fences have
+   * signalled, usually a frame or two later, and hands the
+   * pixels to the shared thread pool for PNG encoding.  The
+   * render thread only blocks when the GPU falls a whole ring
+   * behind, or when the encode queue is full.  The queue holds
+   * at most encodeBudget bytes of frames (at least two), which
+   * bounds memory at 4K and above.
+   */
+  class frameCapture {
+  public:
+    static constexpr int ringSize = 4;
+    static constexpr int maxEncodes = 16;
+    static constexpr std::size_t encodeBudget = std::size_t(256) << 20;
+
+    void init(int width, int height);
+    void request(const std::string &filename);
+    void poll();
+    void finish();
+    void release();
+
+    bool active() const { return width > 0; }
+    std::size_t frames() const { return captured; }
+    double readbackMs() const { return captured ? busyMs / captured : 0.0; }
+
+  private:
+    struct slot {
+      GLuint pbo = 0;
+      GLsync fence = 0;
+      std::string filename;
+    };
+
+    slot slots[ringSize];
+    int head = 0;              // next slot to read into
+    int width = 0, height = 0;
+    taskGroup encodes;
+    int encodeLimit = maxEncodes;
+    int queued = 0;            // frames copied out, not yet written
+    std::mutex lock;
+    std::condition_variable written;
+    std::size_t captured = 0;
+    double busyMs = 0.0;       // render thread time spent in capture
+
+    void collect(slot &s);
+  };
+
+} /* End twg namespace */
+#endif
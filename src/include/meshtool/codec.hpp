@@ -0,0 +1,53 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __CODEC_HPP__
+#define __CODEC_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * Index buffer codec.  Triangles are coded against a FIFO of
+   * recently seen edges and one of recently seen vertices, so
+   * a mesh in vertex cache order costs about one byte per
+   * triangle before any data bytes.  Triangles may come back
+   * rotated (same winding, different first corner).
+   */
+  std::vector<uint8_t> encodeIndexBuffer(const std::vector<GLuint> &elements);
+  bool decodeIndexBuffer(const uint8_t *data, std::size_t size,
+			 std::vector<GLuint> &elements);
+
+  /**
+   * Vertex buffer codec for strides that are a multiple of 4
+   * bytes.  Vertices are coded in independent blocks of 256:
+   * each 32 bit word is delta coded against the previous
+   * vertex (subtract or xor, whichever packs better per block),
+   * transposed into byte planes, and every 16 bytes of
+   * a plane are packed at 0, 2, 4 or 8 bits.  Blocks decode in
+   * parallel, with fixed size groups for SIMD.
+   */
+  std::vector<uint8_t> encodeVertexBuffer(const void *vertices, std::size_t count,
+					  std::size_t stride);
+  bool decodeVertexBuffer(const uint8_t *data, std::size_t size,
+			  void *vertices, std::size_t count, std::size_t stride);
+
+  /**
+   * Compressed binary mesh (.mshz): header, then the vertex
+   * and index sections above.  Vertices are renumbered into
+   * first use order before encoding.  A mesh with colours or
+   * materials is written as version 2, which appends them.
+   */
+  bool saveCompressed(const mesh &m, const std::string &filename);
+  bool loadCompressed(const std::string &filename, mesh &m);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,97 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __DAEMON_HPP__
+#define __DAEMON_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace twg {
+
+  /**
+   * Decoded meshes shared between daemon requests, keyed by
+   * path and dropped least recently used once their total size
+   * passes the budget.  An entry is only reused while the
+   * file's size and modification time still match, so a
+   * rewritten input is decoded again.
+   */
+  class meshCache {
+  public:
+    using loader = std::function<bool(const std::string &, mesh &)>;
+
+    explicit meshCache(std::size_t budget) : budget{budget} {}
+    std::shared_ptr<const mesh> get(const std::string &path, const loader &load,
+				    std::string &error);
+
+    std::size_t hits() const;
+    std::size_t misses() const;
+    std::size_t bytes() const;
+    std::size_t entries() const;
+
+  private:
+    struct entry {
+      std::string path;
+      uint64_t size;
+      int64_t mtime;
+      std::size_t bytes;
+      std::shared_ptr<const mesh> data;
+    };
+    std::size_t budget;
+    std::size_t used = 0, hitCount = 0, missCount = 0;
+    std::list<entry> order;                   // most recent first
+    std::unordered_map<std::string, std::list<entry>::iterator> index;
+    mutable std::mutex lock;
+  };
+
+  struct daemonOptions {
+    std::string socketPath;
+    std::size_t cacheBytes = std::size_t(512) << 20;
+    std::size_t maxClients = 64;      // connections served at once
+    meshCache::loader load;                                           // input by format
+    std::function<bool(const mesh &, const std::string &)> save;      // output by extension
+  };
+
+  /**
+   * Serve requests on a Unix domain socket until a shutdown
+   * request, SIGINT or SIGTERM.  One request per line, one
+   * reply line per request, either "ok [result]" or "error
+   * <message>":
+   *
+   *   convert <input> <output>
+   *   stats <input>                  (reply carries the JSON)
+   *   thumbnail <size> <input> <output>.png
+   *   status                         (queue depth, latencies, cache)
+   *   ping
+   *   shutdown
+   *
+   * Paths are whitespace separated and relative to the
+   * daemon's working directory.  Every client connection gets
+   * its own thread that runs its requests in order, up to
+   * maxClients connections; past that a connection is sent
+   * "error busy" and closed.  Loads inside a request use the
+   * warm shared pool.  Thumbnails go to one GL thread that
+   * keeps the headless context and renderers for the sizes
+   * used last.
+   */
+  int runDaemon(const daemonOptions &options);
+
+  /**
+   * Send one request line to a daemon and print its reply.
+   * Returns 0 for an "ok" reply.
+   */
+  int sendRequest(const std::string &socketPath, const std::string &request);
+
+} /* End twg namespace */
+#endif
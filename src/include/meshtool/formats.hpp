@@ -0,0 +1,66 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __FORMATS_HPP__
+#define __FORMATS_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * Read only memory mapping of a whole file.
+   */
+  class mappedFile {
+  public:
+    explicit mappedFile(const std::string &filename);
+    ~mappedFile();
+    mappedFile(const mappedFile &) = delete;
+    mappedFile &operator=(const mappedFile &) = delete;
+
+    bool good() const { return opened; }
+    const uint8_t *data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+  private:
+    const uint8_t *bytes = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+  };
+
+  enum class meshFormat { obj, mshz, stl, ply, gltf };
+
+  /**
+   * Input format from the file's magic bytes, then its
+   * extension.  Anything unrecognised is read as .obj, which
+   * also covers gzip and zstd compressed .obj.
+   */
+  meshFormat detectFormat(const std::string &filename);
+
+  /**
+   * Binary STL: the 50 byte triangle records are decoded in
+   * parallel straight from the mapping, then identical corners
+   * are welded and normals smoothed.
+   */
+  bool loadStl(const std::string &filename, mesh &m);
+  bool saveStl(const mesh &m, const std::string &filename);
+
+  /**
+   * Binary PLY, either byte order.  The header is turned into
+   * a record layout (offsets, types, stride) and the vertex and
+   * face loops are instantiated for those types once, so no
+   * per property branching happens in the loops.  Polygons are
+   * fanned into triangles; missing normals are smoothed.
+   */
+  bool loadPly(const std::string &filename, mesh &m);
+  bool savePly(const mesh &m, const std::string &filename);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,49 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __GLTF_HPP__
+#define __GLTF_HPP__
+
+#include <meshtool.hpp>
+#include <formats.hpp>
+#include <memory>
+
+namespace twg {
+
+  /**
+   * Triangle meshes from a glTF 2.0 file, .glb or .gltf with
+   * external .bin buffers.  All primitives are concatenated;
+   * node transforms, materials and sparse accessors are
+   * ignored.
+   *
+   * When the file holds one primitive whose POSITION and NORMAL
+   * are float vec3s interleaved at stride 24 (the Vertex
+   * layout) and whose indices are 32 bit, the view points
+   * straight into the mapped buffer and nothing is decoded or
+   * copied; saveGlb writes files in that layout.  Anything else
+   * is converted into an owned mesh.
+   */
+  class gltfAsset {
+  public:
+    bool load(const std::string &filename);
+    const meshView &view() const { return data; }
+    bool zeroCopy() const { return mapped; }
+    void toMesh(mesh &m) const;
+
+  private:
+    std::vector<std::unique_ptr<mappedFile>> files;
+    mesh owned;
+    meshView data;
+    bool mapped = false;
+  };
+
+  bool saveGlb(const mesh &m, const std::string &filename);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,73 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __HEADLESS_HPP__
+#define __HEADLESS_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * OpenGL context without a window or display server: EGL on
+   * the surfaceless Mesa platform (llvmpipe on CI machines),
+   * falling back to the default EGL display.  Needs a build
+   * with MESHTOOL_WITH_EGL.
+   */
+  class headlessContext {
+  public:
+    bool init();
+    void release();
+
+  private:
+    void *display = nullptr;  // EGLDisplay
+    void *context = nullptr;  // EGLContext
+  };
+
+  /**
+   * Renders meshes into a framebuffer object with the viewer's
+   * shaders, camera and lighting.  The program, vertex array
+   * and buffers are created once and reused for every mesh, so
+   * a batch pays the startup cost only once.  Meshes with
+   * materials go through materialDraw and its own program,
+   * meshes with baked colours through the colour program.
+   */
+  class offscreenRenderer {
+  public:
+    bool init(int width, int height);
+    void upload(const meshView &m);
+    void upload(const mesh &m);
+    void bind();
+    void render(const glm::vec3 &angles);
+    void read(std::vector<uint8_t> &rgba);
+    void release();
+
+    int width = 0, height = 0;
+
+  private:
+    GLuint fbo = 0, color = 0, depth = 0;
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    Program program;
+    matrices mats;
+    GLsizei count = 0;
+    glm::vec3 center{0.0f};
+    float radius = 1.0f;
+    Program materialProgram;
+    GLuint materialVao = 0;
+    materialDraw *materials = nullptr;   // set while a mesh with materials is uploaded
+    Program colorProgram;
+    GLuint colorVao = 0, colorVbo = 0;
+    bool colored = false;                // uploaded mesh has baked colours
+
+    void frame(const meshView &m);
+  };
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,56 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __ISOSURFACE_HPP__
+#define __ISOSURFACE_HPP__
+
+#include <meshtool.hpp>
+#include <voxel.hpp>
+
+namespace twg {
+
+  enum class isoMethod { marchingCubes, dualContouring };
+
+  /**
+   * Dense scalar volume, x fastest.  Values follow the signed
+   * distance convention: negative inside, so density volumes
+   * are negated on load.
+   */
+  struct denseVolume {
+    glm::ivec3 dims{0};
+    glm::vec3 origin{0.0f};
+    float spacing = 1.0f;
+    float isoSign = 1.0f; // -1 once density values were negated
+    std::vector<float> values;
+
+    float at(int x, int y, int z) const
+    {
+      return values[(std::size_t(z) * dims.y + y) * dims.x + x];
+    }
+
+    /**
+     * Read a headerless raw volume of dims samples, type one
+     * of "u8", "u16" or "f32".  Unless sdf is set the samples
+     * are densities, inside above the iso value.
+     */
+    bool loadRaw(const std::string &filename, glm::ivec3 dims,
+		 const std::string &type, bool sdf);
+  };
+
+  /**
+   * Extract the iso surface as an indexed mesh with normals
+   * from the field gradient, ready for the usual VBO upload.
+   * Work is split into 32^3 cell blocks run on the thread pool.
+   * The iso value is given in the volume's own units.
+   */
+  mesh extractIsosurface(const denseVolume &v, float iso, isoMethod method);
+  mesh extractIsosurface(const sparseVoxelOctree &t, isoMethod method);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,70 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __MATERIALS_HPP__
+#define __MATERIALS_HPP__
+
+#include <meshtool.hpp>
+
+namespace twg {
+
+  /**
+   * Append the materials of a .mtl library (newmtl, Kd, Ks, Ns,
+   * d; everything else ignored), recording each name's index.
+   */
+  bool loadMaterialLibrary(const std::string &filename, std::vector<material> &materials,
+			   std::unordered_map<std::string, GLuint> &names);
+
+  /**
+   * Reorder m's triangles so that every material's faces form
+   * one contiguous element range, keeping file order within a
+   * material, and fill m.materialRanges.
+   */
+  void groupByMaterial(mesh &m, const std::vector<GLuint> &faceMaterial);
+
+  /**
+   * All material ranges of a mesh with one shader and almost no
+   * state changes: material parameters live in a uniform
+   * buffer, each vertex carries its material index, so a
+   * single glDrawElements covers up to blockMaterials
+   * materials.  Vertices shared by faces of different
+   * materials are duplicated on upload.  Larger palettes are
+   * drawn in blocks, rebinding the uniform range per block.
+   * Needs shaders/material.vs and .fs.
+   */
+  class materialDraw {
+  public:
+    static constexpr GLuint blockMaterials = 512;
+
+    void upload(const mesh &m, GLuint program);   // into the bound VAO
+    void draw();
+    void drawPerRange();                          // one draw per range, for comparison
+    void release();
+
+    std::size_t materialCount() const { return materials; }
+    std::size_t rangeCount() const { return ranges.size(); }
+    std::size_t draws = 0;          // last frame
+    std::size_t stateChanges = 0;   // uniform and buffer binds, last frame
+
+  private:
+    struct block {
+      GLuint firstMaterial;
+      GLuint first;
+      GLuint count;
+    };
+
+    GLuint vbo = 0, ids = 0, ebo = 0, ubo = 0;
+    GLint baseLoc = -1;
+    std::size_t materials = 0;
+    std::vector<block> blocks;
+    std::vector<materialRange> ranges;
+  };
+
+} /* End twg namespace */
+#endif
@@ -6,30 +6,210 @@
  *
  *
  */
- #pragma
- #ifndef __MATRICES_HPP
- #define __MATRICES_HPP
+#pragma once
+#ifndef __MATRICES_HPP
+#define __MATRICES_HPP
+
+// Aligned (SIMD) glm types must be enabled before the first glm include.
+#ifndef GLM_FORCE_INTRINSICS
+#define GLM_FORCE_INTRINSICS
+#endif
+#ifndef GLM_FORCE_ALIGNED_GENTYPES
+#define GLM_FORCE_ALIGNED_GENTYPES
+#endif
+#ifndef GLM_ENABLE_EXPERIMENTAL
+#define GLM_ENABLE_EXPERIMENTAL
+#endif
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/type_aligned.hpp>
+#include <glm/gtx/euler_angles.hpp>
 #include <vector>
 
+namespace twg {
+
+/**
+ * Model, view and projection matrix stacks in the style of the
+ * fixed function pipeline (matrixMode, push/pop, mult).  The
+ * composed model-view, model-view-projection and normal matrices
+ * are cached and only recomputed when one of their inputs was
+ * changed since the last request.
+ */
 class matrices
 {
+public:
+    enum matrixModes { MODEL_MATRIX = 0, VIEW_MATRIX, PROJECTION_MATRIX };
+    enum dirtyBits { MODEL_DIRTY = 1, VIEW_DIRTY = 2, PROJECTION_DIRTY = 4 };
+
 private:
-    std::vector<glm::mat4> modelMatrix;
-    std::vector<glm::mat4> viewMatrix;
-    std::vector<glm::mat4> projectionMatrix;
+    std::vector<glm::aligned_mat4> modelMatrix;
+    std::vector<glm::aligned_mat4> viewMatrix;
+    std::vector<glm::aligned_mat4> projectionMatrix;
     int currentMatrix;
+
+    // Cached compositions, valid when the matching bits are clear
+    glm::aligned_mat4 modelViewMatrix;
+    glm::aligned_mat4 mvpMatrix;
+    glm::mat3 normalMatrix;
+    int mvDirty;
+    int mvpDirty;
+    int normalDirty;
+
+    std::vector<glm::aligned_mat4>& stack()
+    {
+        switch(currentMatrix)
+        {
+        case VIEW_MATRIX:
+            return viewMatrix;
+        case PROJECTION_MATRIX:
+            return projectionMatrix;
+        default:
+            return modelMatrix;
+        }
+    }
+
+    void touch()
+    {
+        int bit = 1 << currentMatrix;
+        mvDirty |= bit;
+        mvpDirty |= bit;
+        normalDirty |= bit;
+    }
+
 public:
-    enum matrixModes { MODEL_MATRIX = 0, VIEW_MATRIX,PROJECTION_MATRIX };
     matrices()
+        : currentMatrix{MODEL_MATRIX},
+          modelViewMatrix{1.0f}, mvpMatrix{1.0f}, normalMatrix{1.0f},
+          mvDirty{0}, mvpDirty{0}, normalDirty{0}
     {
-        modelMatrix.push_back(mat4(1.0f));
-        viewMatrix.push_back(mat4(1.0f));
-        projectionMatrix.push_back(mat4(1.0f));
+        modelMatrix.push_back(glm::aligned_mat4(1.0f));
+        viewMatrix.push_back(glm::aligned_mat4(1.0f));
+        projectionMatrix.push_back(glm::aligned_mat4(1.0f));
     };
-}
 
- #endif /* end of include guard:  */
+    void matrixMode(matrixModes mode) { currentMatrix = mode; }
+    int getMatrixMode() const { return currentMatrix; }
+
+    /**
+     * Duplicate the top of the current stack.  The composed
+     * matrices stay valid since the top is unchanged.
+     */
+    void pushMatrix()
+    {
+        std::vector<glm::aligned_mat4>& s = stack();
+        s.push_back(s.back());
+    }
+
+    /**
+     * Restore the previous top of the current stack.  The bottom
+     * entry is never popped.
+     */
+    void popMatrix()
+    {
+        std::vector<glm::aligned_mat4>& s = stack();
+        if(s.size() > 1)
+        {
+            s.pop_back();
+            touch();
+        }
+    }
+
+    void loadIdentity() { loadMatrix(glm::aligned_mat4(1.0f)); }
+
+    void loadMatrix(const glm::aligned_mat4& m)
+    {
+        stack().back() = m;
+        touch();
+    }
+
+    void multMatrix(const glm::aligned_mat4& m)
+    {
+        glm::aligned_mat4& top = stack().back();
+        top = top * m;
+        touch();
+    }
+
+    void translate(const glm::vec3& v)
+    {
+        multMatrix(glm::aligned_mat4(glm::translate(glm::mat4(1.0f), v)));
+    }
+
+    void rotate(float angle, const glm::vec3& axis)
+    {
+        multMatrix(glm::aligned_mat4(glm::rotate(glm::mat4(1.0f), angle, axis)));
+    }
+
+    void scale(const glm::vec3& v)
+    {
+        multMatrix(glm::aligned_mat4(glm::scale(glm::mat4(1.0f), v)));
+    }
+
+    void perspective(float fovy, float aspect, float zNear, float zFar)
+    {
+        loadMatrix(glm::aligned_mat4(glm::perspective(fovy, aspect, zNear, zFar)));
+    }
+
+    void ortho(float left, float right, float bottom, float top,
+               float zNear, float zFar)
+    {
+        loadMatrix(glm::aligned_mat4(glm::ortho(left, right, bottom, top,
+                                                zNear, zFar)));
+    }
+
+    void lookAt(const glm::vec3& eye, const glm::vec3& center,
+                const glm::vec3& up)
+    {
+        loadMatrix(glm::aligned_mat4(glm::lookAt(eye, center, up)));
+    }
+
+    const glm::aligned_mat4& getModelMatrix() const { return modelMatrix.back(); }
+    const glm::aligned_mat4& getViewMatrix() const { return viewMatrix.back(); }
+    const glm::aligned_mat4& getProjectionMatrix() const { return projectionMatrix.back(); }
+
+    /**
+     * Dirty bits accumulated since the last call to
+     * getMVPMatrix.  A zero result means the uniforms uploaded
+     * from the previous composition are still current.
+     */
+    int dirty() const { return mvpDirty; }
+
+    const glm::aligned_mat4& getModelViewMatrix()
+    {
+        if(mvDirty)
+        {
+            modelViewMatrix = viewMatrix.back() * modelMatrix.back();
+            mvDirty = 0;
+        }
+        return modelViewMatrix;
+    }
+
+    const glm::aligned_mat4& getMVPMatrix()
+    {
+        if(mvpDirty)
+        {
+            mvpMatrix = projectionMatrix.back() * getModelViewMatrix();
+            mvpDirty = 0;
+        }
+        return mvpMatrix;
+    }
+
+    /**
+     * Inverse transpose of the upper 3x3 of the model-view
+     * matrix, used to carry normals into view space.
+     */
+    const glm::mat3& getNormalMatrix()
+    {
+        if(normalDirty & (MODEL_DIRTY | VIEW_DIRTY))
+        {
+            normalMatrix = glm::inverseTranspose(glm::mat3(getModelViewMatrix()));
+        }
+        normalDirty = 0;
+        return normalMatrix;
+    }
+};
+
+} /* End twg namespace */
+
+#endif /* end of include guard: __MATRICES_HPP */
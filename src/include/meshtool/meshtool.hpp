@@ -13,6 +13,8 @@
 #define _DEV_
 
 #include "SDL.h"
+#include <matrices.hpp>
+#include <triplebuffer.hpp>
 #include <GL/glew.h>
 #include <chrono>
 #include <cmath>
@@ -28,6 +30,7 @@
 #include <vector>
 #include <unordered_map>
 #include <map>
+#include <functional>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
@@ -36,7 +39,14 @@ using namespace std;
 namespace twg {
 
 #define M_PI 3.14159265358979323846 /* pi */
-#define LOG(a) std::cout << a
+  /**
+   * Where LOG writes on this thread: std::clog unless a task
+   * collects its lines here to print them in one piece, so
+   * concurrent tasks do not interleave mid line.
+   */
+  inline thread_local std::ostream *logSink = nullptr;
+
+#define LOG(a) (twg::logSink ? *twg::logSink : std::clog) << a // stdout is kept for tool output
 
   /**
    * Character object used in Freetype map of
@@ -49,11 +59,38 @@ namespace twg {
     GLuint advance;
   };
 
-  
+  /**
+   * Glyph rasterized by Freetype, waiting for the GL context to
+   * become a Character texture.
+   */
+  struct glyphBitmap {
+    GLchar c;
+    glm::ivec2 size;
+    glm::ivec2 bearing;
+    GLuint advance;
+    std::vector<unsigned char> pixels;  // size.x * size.y, tight rows
+  };
+
+  /**
+   * Wall time of the viewer's startup phases in milliseconds.
+   * load and glyphs run on the thread pool, overlapping window
+   * (SDL video, window and context); waited is how long the
+   * main thread then blocked on them.
+   */
+  struct startupTimes {
+    double load = 0.0;
+    double glyphs = 0.0;
+    double window = 0.0;
+    double waited = 0.0;
+    double upload = 0.0;
+    double total = 0.0;
+  };
+
   struct Vertex {
     glm::vec3 point;
     glm::vec3 normal;
-    // glm::vec3 color;  // uncomment me when required
+    // Colour lives in mesh::colors, keeping this the 24 byte
+    // layout the file formats and codecs map directly.
     // glm::vec2 texcoords;
   };
 
@@ -174,19 +211,81 @@ namespace twg {
     }
   };
   
+  /**
+   * Wavefront .mtl material, the parameters the viewer shades
+   * with.
+   */
+  struct material {
+    std::string name;
+    glm::vec3 diffuse{0.6f};    // Kd
+    glm::vec3 specular{0.5f};   // Ks
+    float shininess = 32.0f;    // Ns
+    float opacity = 1.0f;       // d
+  };
+
+  /**
+   * Contiguous run of elements drawn with one material.
+   */
+  struct materialRange {
+    GLuint material;
+    GLuint first;               // element offset
+    GLuint count;               // elements
+  };
+
   struct mesh {
     constexpr static int stride = 6;
     std::vector<Vertex> vertices;
-    std::vector<GLushort> elements;
+    std::vector<GLuint> elements;
+    std::vector<material> materials;            // empty: single grey material
+    std::vector<materialRange> materialRanges;  // sorted, cover elements
+    std::vector<glm::vec3> colors;              // per vertex, empty unless baked
+    mesh() {}; // Empty mesh, filled by generators
     mesh(std::vector<glm::vec3> points, std::vector<glm::vec3> normals,
-	 std::vector<GLushort> elements)
+	 std::vector<GLuint> elements)
       : elements{elements} {
       auto nit = normals.begin();
       for (auto pit = points.begin(); pit != points.end(); pit++, nit++) {
 	vertices.push_back(Vertex{*pit, *nit});
       }
     }
-    std::size_t size() { return 6 * vertices.size() * sizeof(GLfloat); }
+    std::size_t size() const { return 6 * vertices.size() * sizeof(GLfloat); }
+  };
+
+  /**
+   * Non-owning vertex and index arrays, either a mesh's own or
+   * memory the data was mapped in from (see gltfAsset).
+   */
+  struct meshView {
+    const Vertex *vertices = nullptr;
+    std::size_t vertexCount = 0;
+    const GLuint *elements = nullptr;
+    std::size_t elementCount = 0;
+    meshView() {};
+    meshView(const mesh &m)
+      : vertices{m.vertices.data()}, vertexCount{m.vertices.size()},
+	elements{m.elements.data()}, elementCount{m.elements.size()} {}
+  };
+
+  struct scene;
+  class pointCloud;
+  class sharedMesh;
+  class meshWatcher;
+  class meshSequence;
+  class frameCapture;
+  class materialDraw;
+
+  /**
+   * Everything render() needs from input and simulation for
+   * one frame, copied whole into the triple buffer.
+   */
+  struct frameState {
+    GLfloat angleX = 0.0f;
+    GLfloat angleY = 0.0f;
+    GLfloat angleZ = 0.0f;
+    GLfloat scale = 0.3f;
+    int screenshots = 0;         // requested so far
+    uint32_t inputSerial = 0;    // input events so far
+    uint32_t inputTicks = 0;     // SDL timestamp of the newest one
   };
 
   /**
@@ -198,7 +297,7 @@ namespace twg {
    */
   class meshtool {
   private:
-    bool _isRunning = false;
+    std::atomic<bool> _isRunning{false};
     SDL_Window *_window = 0;
     SDL_Renderer *_renderer = 0;
     SDL_Texture *_texture = 0;
@@ -207,29 +306,81 @@ namespace twg {
     Program modelProgram;
     GLuint vao = 0;
     GLuint vbo, vbn, vbe;
+    GLuint vbc = 0;             // baked colours, when the mesh has them
     GLuint triangle;
     GLfloat angleX = 0.0f;
     GLfloat angleY = 0.0f;
     GLfloat angleZ = 0.0f;
     GLfloat scale = 0.3f;
+    matrices mats;
+    GLint mvpLoc = -1, mvLoc = -1, nmLoc = -1;
     mesh *m_mesh;
+    scene *m_scene = nullptr;
+    pointCloud *m_points = nullptr;
+    sharedMesh *m_shared = nullptr;
+    meshWatcher *m_watch = nullptr;
+    meshSequence *m_sequence = nullptr;
+    double submitTime = 0.0;
+    int statFrames = 0;
+    frameCapture *capture = nullptr;
+    materialDraw *m_materials = nullptr;
+    std::string capturePrefix;  // continuous capture when set
+    int captureFrame = 0;
+    int screenshots = 0;
+    bool screenshotPending = false;
+    int screenshotRequests = 0;
+    // Input thread state, published to the renderer per update()
+    tripleBuffer<frameState> frames;
+    uint32_t inputSerial = 0;
+    uint32_t inputTicks = 0;
+    std::chrono::steady_clock::time_point lastUpdate;
+    // Render side: the last input shown and input to present latency
+    std::thread renderThread;
+    uint32_t shownSerial = 0;
+    double latencyMs = 0.0;
+    int latencySamples = 0;
+    bool threaded = false;
+    int subdivisionLevels = 0;
+    float subdivisionPixels = 0.0f;   // adaptive when positive
     GLint screen_width, screen_height;
-    FT_Library ft;
-    FT_Face face;
+    std::vector<glyphBitmap> glyphs;
     std::map<GLchar,Character> characters;
+    startupTimes startup;
+    bool verbose = false;
+
+    void present();
+    void noteInput(uint32_t ticks);
+    void renderLoop();
+    void rasterizeGlyphs();
+    int upload(int width, int height);
+    void applyUpdate();
     
   public:
     meshtool(mesh *m_mesh);
+    meshtool(scene *m_scene);
+    meshtool(pointCloud *m_points);
+    meshtool(sharedMesh *m_shared);
+    meshtool(meshSequence *m_sequence);
     ~meshtool();
 
     // Class functions
     void initCharacterMap();
     int init(std::string &&title, int xpos, int ypos, int width, int height,
-	     int flags);
+	     int flags, std::function<bool()> load = {});
     void render();
     void update();
     void handleEvents();
     void clean();
+    void startRenderThread();
+    void stopRenderThread();
+    void setCapture(const std::string &prefix) { capturePrefix = prefix; }
+    void setVerbose(bool on) { verbose = on; }
+    void setWatch(meshWatcher *watch) { m_watch = watch; }
+    void setSubdivision(int levels, float maxEdgePixels)
+    {
+      subdivisionLevels = levels;
+      subdivisionPixels = maxEdgePixels;
+    }
     
     // Get/Set functions
     bool isRunning() { return _isRunning; };
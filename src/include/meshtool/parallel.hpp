@@ -0,0 +1,118 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __PARALLEL_HPP__
+#define __PARALLEL_HPP__
+
+#include <threadpool.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace twg {
+
+  /**
+   * Number of ranges the parallel helpers split work into.
+   */
+  inline unsigned workerCount()
+  {
+    return threadPool::shared().size();
+  }
+
+  /**
+   * Split [begin,end) into one contiguous range per worker and
+   * call fn(lo, hi, worker) on each through the shared pool.
+   * The calling thread runs the first range itself.
+   */
+  template <typename F>
+  void parallelFor(std::size_t begin, std::size_t end, F fn)
+  {
+    std::size_t count = end > begin ? end - begin : 0;
+    unsigned workers = static_cast<unsigned>
+      (std::min<std::size_t>(workerCount(), std::max<std::size_t>(count, 1)));
+    std::size_t chunk = (count + workers - 1) / workers;
+    threadPool &pool = threadPool::shared();
+    taskGroup group;
+    for(unsigned w = 1; w < workers; ++w)
+      {
+	std::size_t lo = std::min(end, begin + w * chunk);
+	std::size_t hi = std::min(end, lo + chunk);
+	pool.run(group, [&fn, lo, hi, w] { fn(lo, hi, w); });
+      }
+    fn(begin, std::min(end, begin + chunk), 0u);
+    pool.wait(group);
+  }
+
+  /**
+   * Reduce [begin,end): every worker maps its range to a
+   * partial result with map(lo, hi), the partials are then
+   * folded in worker order with combine(a, b) so the result
+   * does not depend on thread timing.
+   */
+  template <typename T, typename Map, typename Combine>
+  T parallelReduce(std::size_t begin, std::size_t end, T init,
+		   Map map, Combine combine)
+  {
+    std::vector<T> partial(workerCount(), init);
+    parallelFor(begin, end,
+		[&](std::size_t lo, std::size_t hi, unsigned w) {
+		  partial[w] = map(lo, hi);
+		});
+    T result = init;
+    for(const T &p : partial)
+      {
+	result = combine(result, p);
+      }
+    return result;
+  }
+
+  /**
+   * Stable LSD radix sort of (key, value) pairs on the low
+   * keyBits of the key, 8 bits per pass.  Each pass counts
+   * digits per worker range and scatters in range order, so
+   * equal keys keep their input order on any thread count.
+   */
+  template <typename Key>
+  void radixSort(std::vector<std::pair<Key, uint32_t>> &items, unsigned keyBits)
+  {
+    const unsigned radix = 256;
+    unsigned workers = workerCount();
+    std::vector<std::pair<Key, uint32_t>> buffer(items.size());
+    std::vector<std::size_t> offsets(std::size_t(workers) * radix);
+    for(unsigned shift = 0; shift < keyBits; shift += 8)
+      {
+	std::fill(offsets.begin(), offsets.end(), 0);
+	parallelFor(0, items.size(), [&](std::size_t lo, std::size_t hi, unsigned w) {
+	    std::size_t *count = &offsets[std::size_t(w) * radix];
+	    for(std::size_t i = lo; i < hi; ++i)
+	      {
+		++count[(items[i].first >> shift) & (radix - 1)];
+	      }
+	  });
+	std::size_t sum = 0;
+	for(unsigned d = 0; d < radix; ++d)
+	  for(unsigned w = 0; w < workers; ++w)
+	    {
+	      std::size_t c = offsets[std::size_t(w) * radix + d];
+	      offsets[std::size_t(w) * radix + d] = sum;
+	      sum += c;
+	    }
+	parallelFor(0, items.size(), [&](std::size_t lo, std::size_t hi, unsigned w) {
+	    std::size_t *at = &offsets[std::size_t(w) * radix];
+	    for(std::size_t i = lo; i < hi; ++i)
+	      {
+		buffer[at[(items[i].first >> shift) & (radix - 1)]++] = items[i];
+	      }
+	  });
+	items.swap(buffer);
+      }
+  }
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,148 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __POINTCLOUD_HPP__
+#define __POINTCLOUD_HPP__
+
+#include <meshtool.hpp>
+#include <threadpool.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace twg {
+
+  /**
+   * One point as stored in the octree, its cache file and its
+   * GL buffers: position and RGBA8 colour in 16 bytes.
+   */
+  struct cloudPoint {
+    glm::vec3 point;
+    uint32_t color;
+  };
+
+  /**
+   * Octree node, 64 bytes and stored as is in the cache file.
+   * Its own points are the subsample [begin, begin + count);
+   * the points below it live in its children.
+   */
+  struct octreeNode {
+    uint64_t begin = 0;
+    uint32_t count = 0;
+    uint32_t depth = 0;
+    int32_t children[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+    glm::vec3 lo{0.0f};      // cube corner
+    float size = 0.0f;       // cube edge
+  };
+
+  /**
+   * True for a plain .obj with "v" lines and no faces, found
+   * by scanning the mapped file in parallel.  Compressed files
+   * are not probed; --points selects the mode for those.
+   */
+  bool isVertexOnly(const std::string &filename);
+
+  /**
+   * Positions, and the "v x y z r g b" colours when present,
+   * of every "v" line.  Plain files are parsed in parallel
+   * chunks of the mapping.
+   */
+  bool loadPoints(const std::string &filename, std::vector<cloudPoint> &points,
+		  bool &colored);
+
+  struct pointFrameStats {
+    std::size_t nodes = 0;        // selected this frame
+    std::size_t points = 0;       // drawn
+    std::size_t uploads = 0;      // nodes uploaded this frame
+    std::size_t residentPoints = 0;
+  };
+
+  /**
+   * Potree style LOD octree.  Each node keeps the first point
+   * of every occupied cell of a 64^3 grid over its cube, so a
+   * node's points are spaced about size/64 apart and every
+   * level doubles the density; points left over go to the
+   * children, and nodes with few enough points are leaves.
+   * Points are Morton sorted first, which makes every node a
+   * contiguous range and the per cell test a comparison with
+   * the previous point.
+   *
+   * Built trees are written to <input>.octree and mapped from
+   * there on later runs, paging in only the nodes that get
+   * drawn.  Each frame the visible nodes are taken largest on
+   * screen first until the point budget is spent or nodes get
+   * small; nodes are paged in by pool tasks and uploaded to
+   * their own buffers a bounded number per frame, and the
+   * least recently drawn are dropped past twice the budget.
+   */
+  class pointCloud {
+  public:
+    static constexpr uint32_t leafPoints = 20000;
+    static constexpr uint32_t maxDepth = 15;
+    static constexpr int gridLevels = 6;     // 64^3 sampling grid per node
+
+    using loader = std::function<bool(const std::string &, mesh &)>;
+
+    pointCloud() = default;
+    pointCloud(const pointCloud &) = delete;
+    pointCloud &operator=(const pointCloud &) = delete;
+    ~pointCloud();
+
+    // Formats other than .obj go through meshLoader and keep
+    // its vertices
+    bool load(const std::string &filename, const loader &meshLoader = {});
+    void build(std::vector<cloudPoint> &&input, bool colored);
+    bool save(const std::string &filename, uint64_t sourceSize, int64_t sourceMtime) const;
+    bool open(const std::string &filename, uint64_t sourceSize, int64_t sourceMtime);
+
+    std::size_t pointCount() const { return count; }
+    const std::vector<octreeNode> &nodes() const { return tree; }
+    float spacing(const octreeNode &n) const { return n.size / (1 << gridLevels); }
+
+    // Nodes to draw for this view, in priority order
+    void select(const glm::mat4 &modelView, const glm::mat4 &mvp, float pixelScale,
+		std::vector<uint32_t> &visible) const;
+
+    void upload(GLuint program);
+    pointFrameStats draw(const glm::mat4 &modelView, const glm::mat4 &mvp, float pixelScale);
+    void release();
+
+    glm::vec3 boundsMin{0.0f}, boundsMax{0.0f};
+    std::size_t pointBudget = 5000000;
+    std::size_t uploadPerFrame = 1000000;    // points
+    float minNodePixels = 80.0f;             // projected radius
+
+  private:
+    enum : uint8_t { paged = 0, fetching = 1, ready = 2 };
+    struct nodeBuffer {
+      GLuint vao = 0, vbo = 0;
+      uint64_t lastDrawn = 0;
+    };
+
+    std::vector<octreeNode> tree;
+    std::vector<cloudPoint> storage;         // built in memory
+    const cloudPoint *data = nullptr;        // storage or the mapping
+    std::size_t count = 0;
+    void *mapping = nullptr;
+    std::size_t mappingLength = 0;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> state;
+    std::vector<nodeBuffer> buffers;
+    std::vector<uint32_t> resident, visible;
+    std::size_t residentPoints = 0;
+    uint64_t frame = 0;
+    taskGroup paging;
+    GLint spacingLoc = -1, pixelScaleLoc = -1;
+
+    void unmap();
+  };
+
+} /* End twg namespace */
+#endif
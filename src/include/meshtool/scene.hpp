@@ -0,0 +1,71 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __SCENE_HPP__
+#define __SCENE_HPP__
+
+#include <meshtool.hpp>
+
+namespace twg {
+
+  /**
+   * One instanced draw: every placement of a single mesh
+   * rendered with a single program.  Batches are kept sorted
+   * by (program, mesh) so consecutive draws share state.
+   */
+  struct drawBatch {
+    GLuint program;
+    int meshIndex;
+    GLuint firstInstance; // offset into the instance buffer
+    GLsizei instanceCount;
+  };
+
+  /**
+   * Scene description: a list of unique mesh files and the
+   * transforms of every placed instance of each.
+   *
+   * Text format, one statement per line,
+   *
+   * # comment
+   * mesh <file.obj>
+   * inst <mesh index> tx ty tz [rx ry rz [s]]
+   *
+   * Mesh indices count mesh statements from 0, rotations are
+   * Euler angles in degrees applied Y, X then Z, the scale is
+   * uniform.  A mesh file listed twice is only loaded once.
+   */
+  struct scene {
+    std::vector<std::string> files;
+    std::vector<mesh> meshes;
+    std::vector<std::vector<glm::mat4>> instances; // per mesh
+    glm::vec3 boundsMin{0.0f};
+    glm::vec3 boundsMax{0.0f};
+
+    // GL resources, valid after upload()
+    std::vector<GLuint> vaos;
+    std::vector<GLuint> vbos;
+    std::vector<GLuint> ibos;
+    GLuint instanceBuffer = 0;
+    std::vector<drawBatch> batches;
+
+    int addMesh(const std::string &filename);   // -1 when it cannot be read
+    void addInstance(int meshIndex, const glm::mat4 &transform);
+    std::size_t instanceCount() const;
+    void computeBounds();
+
+    void upload(GLuint program);
+    int draw() const;
+    void release();
+  };
+
+  bool loadScene(const std::string &filename, scene &s);
+  bool stressScene(const std::string &filename, std::size_t count, scene &s);
+
+} /* End twg namespace */
+#endif
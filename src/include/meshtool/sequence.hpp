@@ -0,0 +1,114 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __SEQUENCE_HPP__
+#define __SEQUENCE_HPP__
+
+#include <meshtool.hpp>
+#include <threadpool.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace twg {
+
+  /**
+   * frame_0001.obj and the files numbered after it with the
+   * same digit count, up to the first one missing.  A name
+   * whose last digit run is over 18 digits is a sequence of
+   * one.
+   */
+  std::vector<std::string> expandSequence(const std::string &first);
+
+  struct sequenceStats {
+    std::size_t shown = 0;        // frames drawn when due
+    std::size_t dropped = 0;      // due frames not ready or skipped over
+    std::size_t decoded = 0;
+    std::size_t failed = 0;       // of decoded: unreadable, dropped when due
+    std::size_t cacheHits = 0;    // decoded from <frame>.mshz
+    double decodeMs = 0.0;        // total, for the mean
+    double decodeMaxMs = 0.0;
+    double uploadMs = 0.0;        // total, for the mean
+    double meanDecodeMs() const { return decoded ? decodeMs / decoded : 0.0; }
+    double meanUploadMs() const { return shown ? uploadMs / shown : 0.0; }
+  };
+
+  /**
+   * Mesh sequence playback at a fixed frame rate.  Pool tasks
+   * decode the frames after the playhead into a ring of slots,
+   * reading <frame>.mshz when it is newer than the frame and
+   * writing it otherwise, so later passes skip the text parse.
+   * Frames go up into two buffer pairs in turn: a frame is
+   * written to the pair the previous frame was not drawn from,
+   * so the copy does not wait for that draw.  A frame that is
+   * not decoded by the time it is due, or that cannot be read,
+   * is dropped and the last one stays on screen.
+   */
+  class meshSequence {
+  public:
+    using loader = std::function<bool(const std::string &, mesh &)>;
+    using preparer = std::function<void(mesh &)>;
+
+    meshSequence() = default;
+    meshSequence(const meshSequence &) = delete;
+    meshSequence &operator=(const meshSequence &) = delete;
+    ~meshSequence();
+
+    // Decodes the first frame for the bounds before returning
+    bool open(const std::vector<std::string> &frames, loader load, preparer prepare = {});
+
+    void upload();
+    // Draws the frame due at the current time
+    void draw();
+    void release();
+
+    std::size_t frameCount() const { return files.size(); }
+    std::size_t currentFrame() const { return shownFrame; }
+    sequenceStats stats();
+
+    glm::vec3 boundsMin{0.0f}, boundsMax{0.0f};
+    double fps = 24.0;
+    std::size_t prefetch = 8;     // frames decoded ahead
+
+  private:
+    enum : uint8_t { empty = 0, decoding = 1, ready = 2 };
+    struct slot {
+      std::atomic<uint8_t> state{empty};
+      std::size_t frame = 0;      // absolute: wraps through files
+      std::unique_ptr<mesh> m;    // null when decoding failed
+    };
+    struct bufferPair {
+      GLuint vao = 0, vbo = 0, vbe = 0;
+      std::size_t vertexBytes = 0, elementBytes = 0;   // allocated
+      GLsizei elements = 0;
+    };
+
+    std::vector<std::string> files;
+    loader load;
+    preparer prepare;
+    std::unique_ptr<slot[]> slots;
+    std::size_t slotCount = 0;
+    taskGroup decodes;
+    bufferPair pairs[2];
+    int front = 0;                // pair drawn last
+    bool started = false;
+    std::chrono::steady_clock::time_point startTime;
+    std::size_t playhead = 0;     // frames due so far, not wrapped
+    std::size_t shownFrame = 0;
+    std::mutex statsLock;         // decode tasks add to counters
+    sequenceStats counters;
+
+    bool decode(std::size_t frame, mesh &m, bool &cacheHit);
+    void schedule(std::size_t from);
+    void uploadFrame(const mesh &m);
+  };
+
+} /* End twg namespace */
+#endif
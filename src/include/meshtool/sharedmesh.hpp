@@ -0,0 +1,141 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __SHAREDMESH_HPP__
+#define __SHAREDMESH_HPP__
+
+#include <meshtool.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * Start of a POSIX shared memory segment holding a mesh for
+   * the viewer, magic "MTSHMESH" and version 1.  The vertex
+   * array (Vertex, 24 bytes: position then normal) and the
+   * element array (GLuint triangles) sit at the given offsets
+   * with room for the capacities; counts say how much of them
+   * is in use.
+   *
+   * generation works as a sequence lock: the producer makes it
+   * odd before touching the arrays, counts or dirty ranges and
+   * even again when done.  The dirty ranges are what that last
+   * commit changed, in elements of each array; a reader that
+   * missed a generation or saw one change under it uploads
+   * everything instead.  Zero means nothing committed yet.
+   */
+  struct sharedMeshHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;          // sizeof(sharedMeshHeader)
+    uint32_t vertexStride;        // sizeof(Vertex)
+    uint32_t elementSize;         // sizeof(GLuint)
+    uint64_t vertexCapacity;
+    uint64_t elementCapacity;
+    uint64_t vertexOffset;        // bytes from the segment start
+    uint64_t elementOffset;
+    std::atomic<uint64_t> generation;
+    uint64_t vertexCount;
+    uint64_t elementCount;
+    uint64_t vertexDirty[2];      // [first, end)
+    uint64_t elementDirty[2];
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+		"the generation counter is shared between processes");
+
+  /**
+   * Producer side: creates /<name> (see shm_open) sized for the
+   * capacities.  Write into vertices() and elements() between
+   * begin() and commit(), naming what changed so the viewer
+   * re-uploads only that.
+   */
+  class sharedMeshWriter {
+  public:
+    sharedMeshWriter() = default;
+    sharedMeshWriter(const sharedMeshWriter &) = delete;
+    sharedMeshWriter &operator=(const sharedMeshWriter &) = delete;
+    ~sharedMeshWriter() { release(); }
+
+    bool create(const std::string &name, std::size_t vertexCapacity,
+		std::size_t elementCapacity);
+    Vertex *vertices();
+    GLuint *elements();
+    void begin();
+    void commit(std::size_t vertexCount, std::size_t elementCount,
+		std::size_t vertexFirst, std::size_t vertexEnd,
+		std::size_t elementFirst, std::size_t elementEnd);
+    void commit(std::size_t vertexCount, std::size_t elementCount)
+    {
+      commit(vertexCount, elementCount, 0, vertexCount, 0, elementCount);
+    }
+    // Whole mesh, growing nothing: false when it does not fit
+    bool publish(const mesh &m);
+    // Unmaps, and removes the segment name unless keep is set
+    void release(bool keep = false);
+
+  private:
+    sharedMeshHeader *header = nullptr;
+    std::size_t length = 0;
+    std::string name;
+  };
+
+  /**
+   * --shm-publish: m in a new segment until SIGINT or SIGTERM,
+   * for viewing with --shm or trying the handoff from scripts.
+   */
+  int runSharedPublisher(const std::string &name, const mesh &m);
+
+  struct sharedFrameStats {
+    uint64_t generations = 0;     // committed generations uploaded
+    uint64_t partial = 0;         // of those, from the dirty ranges only
+    uint64_t torn = 0;            // changed while being uploaded
+    std::size_t bytes = 0;        // uploaded
+  };
+
+  /**
+   * Viewer side: maps a segment read only and keeps buffers
+   * sized for its capacities in step with it, uploading
+   * straight from the mapping with glBufferSubData.  Nothing
+   * is parsed or copied on the CPU.
+   */
+  class sharedMesh {
+  public:
+    sharedMesh() = default;
+    sharedMesh(const sharedMesh &) = delete;
+    sharedMesh &operator=(const sharedMesh &) = delete;
+    ~sharedMesh() { unmap(); }
+
+    bool open(const std::string &name);
+    // Until the first commit, false after timeout seconds
+    bool wait(double timeout);
+
+    void upload();
+    // Pull in the newest commit, if any
+    void refresh();
+    void draw();
+    void release();
+
+    const sharedFrameStats &stats() const { return counters; }
+    std::size_t elementCount() const { return elements; }
+
+  private:
+    const sharedMeshHeader *header = nullptr;
+    std::size_t length = 0;
+    GLuint vao = 0, vbo = 0, vbe = 0;
+    uint64_t shown = 0;           // generation in the buffers
+    bool stale = true;            // buffers not known to match shown
+    std::size_t elements = 0;
+    sharedFrameStats counters;
+
+    void unmap();
+  };
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,43 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __STATS_HPP__
+#define __STATS_HPP__
+
+#include <meshtool.hpp>
+
+namespace twg {
+
+  /**
+   * Geometry and topology summary of a mesh, as printed by
+   * the headless --stats mode.
+   */
+  struct meshStats {
+    std::size_t vertices = 0;
+    std::size_t triangles = 0;
+    glm::vec3 boundsMin{0.0f};
+    glm::vec3 boundsMax{0.0f};
+    double area = 0.0;
+    double volume = 0.0;       // signed, meaningful when closed
+    std::size_t degenerate = 0;
+    std::size_t edges = 0;
+    std::size_t boundaryEdges = 0;
+    std::size_t nonManifoldEdges = 0;
+    std::size_t boundaryLoops = 0;
+    std::size_t components = 0;
+    double seconds = 0.0;      // time spent in computeStats
+
+    bool closed() const { return boundaryEdges == 0 && nonManifoldEdges == 0; }
+  };
+
+  meshStats computeStats(const mesh &m);
+  std::string statsJson(const std::string &filename, const meshStats &s);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,76 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __STREAM_HPP__
+#define __STREAM_HPP__
+
+#include <meshtool.hpp>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+
+namespace twg {
+
+  /**
+   * Line reader over a plain, gzip or zstd file, the format
+   * detected from its magic bytes.  A reader thread fills
+   * fixed size blocks of decompressed text into two buffers
+   * while the caller parses the other one, so decompression
+   * and parsing overlap.  zstd needs a build with
+   * MESHTOOL_WITH_ZSTD.
+   */
+  class inputStream {
+  public:
+    enum class format { plain, gzip, zstd };
+    static constexpr std::size_t blockSize = 1 << 20;
+
+    explicit inputStream(const std::string &filename);
+    ~inputStream();
+    inputStream(const inputStream &) = delete;
+    inputStream &operator=(const inputStream &) = delete;
+
+    bool good() const { return file != nullptr; }
+    bool failed() const { return error; }
+    bool getline(std::string &line);
+
+    format kind() const { return type; }
+    const char *formatName() const;
+    std::size_t compressedBytes() const { return consumed; }
+    double seconds() const;
+
+  private:
+    struct block {
+      std::vector<char> data;
+      std::size_t size = 0;
+      bool ready = false;
+      bool last = false;
+    };
+
+    std::FILE *file = nullptr;
+    format type = format::plain;
+    std::chrono::steady_clock::time_point start;
+    std::size_t consumed = 0;   // file bytes, written by the reader only
+    block blocks[2];
+    std::mutex lock;
+    std::condition_variable changed;
+    bool stop = false;
+    bool error = false;
+    std::thread reader;
+    int current = 0;           // block the caller is parsing
+    bool holding = false;
+    bool finished = false;     // last block handed back
+    std::size_t offset = 0;
+
+    void produce();
+    void acquire();
+    void release();
+  };
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,100 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __SUBDIVISION_HPP__
+#define __SUBDIVISION_HPP__
+
+#include <meshtool.hpp>
+#include <adjacency.hpp>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * How far to refine.  Uniform by default; with maxEdgePixels
+   * set only faces whose longest edge projects to more than
+   * that many pixels under viewProjection are split, so each
+   * level refines less of the mesh and stops once every face
+   * is small enough on screen.
+   */
+  struct subdivisionOptions {
+    int levels = 1;
+    float maxEdgePixels = 0.0f;        // 0: uniform
+    glm::mat4 viewProjection{1.0f};    // model to clip space
+    glm::vec2 viewport{800.0f, 600.0f};
+  };
+
+  /**
+   * Outcome of a subdivide call, for the log line and
+   * --bench subdivision.
+   */
+  struct subdivisionStats {
+    int levels = 0;                    // levels that split anything
+    std::size_t trianglesBefore = 0;
+    std::size_t trianglesAfter = 0;
+    double seconds = 0.0;
+
+    double trianglesPerSecondPerCore() const;
+  };
+
+  /**
+   * One level of Loop subdivision over the flat adjacency
+   * arrays.  prepare() picks the faces to refine, numbers the
+   * edges that get a new vertex and sizes the output; write()
+   * then runs three data-parallel stencil passes (old
+   * vertices, edge vertices, faces) straight into caller
+   * memory, a mesh's vectors or GL buffers mapped for writing.
+   *
+   * A refined face splits 1:4.  Faces next to one split 1:2 or
+   * 1:3 along the edges that got a vertex, so adaptive levels
+   * leave no T-junctions.  Old vertices only move when all of
+   * their faces are refined.  Boundary edges use the crease
+   * rules; non-manifold edges are treated as boundaries.
+   */
+  class loopSubdivision {
+  public:
+    static constexpr uint32_t invalid = meshAdjacency::invalid;
+
+    // Faces split on this level, 0 when there is nothing to do
+    std::size_t prepare(const mesh &cage, const subdivisionOptions &options);
+    std::size_t vertexCount() const { return vertices; }
+    std::size_t elementCount() const { return 3 * std::size_t(firstTriangle.back()); }
+    // First output triangle of cage face f
+    uint32_t faceOffset(std::size_t f) const { return firstTriangle[f]; }
+    void write(Vertex *outVertices, GLuint *outElements) const;
+
+  private:
+    const mesh *cage = nullptr;
+    meshAdjacency adj;
+    std::vector<uint8_t> refine;          // per face
+    std::vector<uint32_t> edgeVertex;     // per half-edge, invalid if not split
+    std::vector<uint32_t> firstTriangle;  // per face, plus the total
+    std::size_t vertices = 0;
+
+    void writeVertex(uint32_t v, Vertex &out) const;
+    void writeEdge(uint32_t h, Vertex &out) const;
+    void writeFace(uint32_t f, GLuint *out) const;
+  };
+
+  /**
+   * Subdivide m in place, keeping its material ranges.
+   */
+  subdivisionStats subdivide(mesh &m, const subdivisionOptions &options);
+
+  /**
+   * Subdivide cage into the bound GL_ARRAY_BUFFER and
+   * GL_ELEMENT_ARRAY_BUFFER.  All but the last level go
+   * through scratch meshes; the last is written into the
+   * mapped buffers, so the finest level is never copied.
+   * Material ranges are dropped; use subdivide() for those.
+   */
+  subdivisionStats uploadSubdivided(const mesh &cage, const subdivisionOptions &options);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,206 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __THREADPOOL_HPP__
+#define __THREADPOOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace twg {
+
+  /**
+   * Counter of outstanding tasks submitted to a threadPool, so
+   * a caller can wait for its own work only.
+   */
+  class taskGroup {
+    std::atomic<std::size_t> pending{0};
+    friend class threadPool;
+  public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+  };
+
+  /**
+   * Work stealing thread pool.  Every worker owns a deque: it
+   * pushes and pops its own tasks at the back (LIFO, cache
+   * warm) and steals from the front of the others when empty.
+   * Threads waiting on a taskGroup run queued tasks meanwhile,
+   * so tasks may submit and wait on nested groups.
+   */
+  class threadPool {
+  private:
+    struct queue {
+      std::mutex lock;
+      std::deque<std::pair<std::function<void()>, taskGroup *>> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<unsigned> next{0};
+    bool stopping = false;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+
+    static int &workerIndex()
+    {
+      static thread_local int index = -1;
+      return index;
+    }
+
+    bool pop(unsigned q, bool back,
+	     std::pair<std::function<void()>, taskGroup *> &task)
+    {
+      std::lock_guard<std::mutex> guard{queues[q]->lock};
+      auto &tasks = queues[q]->tasks;
+      if(tasks.empty())
+	{
+	  return false;
+	}
+      if(back)
+	{
+	  task = std::move(tasks.back());
+	  tasks.pop_back();
+	}
+      else
+	{
+	  task = std::move(tasks.front());
+	  tasks.pop_front();
+	}
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    /**
+     * Run one task: own queue first, then steal round the
+     * other queues starting after our own.
+     */
+    bool runOne()
+    {
+      std::pair<std::function<void()>, taskGroup *> task;
+      int self = workerIndex();
+      unsigned n = static_cast<unsigned>(queues.size());
+      bool found = self >= 0 && pop(self, true, task);
+      for(unsigned i = 1; !found && i <= n; ++i)
+	{
+	  found = pop((self + i) % n, false, task);
+	}
+      if(!found)
+	{
+	  return false;
+	}
+      task.first();
+      task.second->pending.fetch_sub(1, std::memory_order_acq_rel);
+      return true;
+    }
+
+    void workerLoop(int index)
+    {
+      workerIndex() = index;
+      for(;;)
+	{
+	  if(runOne())
+	    {
+	      continue;
+	    }
+	  std::unique_lock<std::mutex> guard{sleepLock};
+	  wake.wait(guard, [this] {
+	      return stopping || queued.load(std::memory_order_relaxed) > 0;
+	    });
+	  if(stopping && queued.load(std::memory_order_relaxed) == 0)
+	    {
+	      return;
+	    }
+	}
+    }
+
+  public:
+    explicit threadPool(unsigned count)
+    {
+      count = count ? count : 1;
+      for(unsigned i = 0; i < count; ++i)
+	{
+	  queues.emplace_back(new queue);
+	}
+      for(unsigned i = 0; i < count; ++i)
+	{
+	  threads.emplace_back(&threadPool::workerLoop, this, static_cast<int>(i));
+	}
+    }
+
+    ~threadPool()
+    {
+      {
+	std::lock_guard<std::mutex> guard{sleepLock};
+	stopping = true;
+      }
+      wake.notify_all();
+      for(std::thread &t : threads)
+	{
+	  t.join();
+	}
+    }
+
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+    /**
+     * Queue fn as part of group.  Called from a worker the task
+     * goes on that worker's own deque, otherwise the queues are
+     * filled round robin.
+     */
+    void run(taskGroup &group, std::function<void()> fn)
+    {
+      group.pending.fetch_add(1, std::memory_order_relaxed);
+      int self = workerIndex();
+      unsigned q = self >= 0 ? static_cast<unsigned>(self)
+	: next.fetch_add(1, std::memory_order_relaxed) % queues.size();
+      {
+	std::lock_guard<std::mutex> guard{queues[q]->lock};
+	queues[q]->tasks.emplace_back(std::move(fn), &group);
+      }
+      queued.fetch_add(1, std::memory_order_relaxed);
+      {
+	std::lock_guard<std::mutex> guard{sleepLock};
+      }
+      wake.notify_one();
+    }
+
+    /**
+     * Block until every task of group has finished, running
+     * queued tasks (of any group) in the meantime.
+     */
+    void wait(taskGroup &group)
+    {
+      while(!group.done())
+	{
+	  if(!runOne())
+	    {
+	      std::this_thread::yield();
+	    }
+	}
+    }
+
+    /**
+     * Process wide pool sized to the hardware.
+     */
+    static threadPool &shared()
+    {
+      static threadPool pool{std::thread::hardware_concurrency()};
+      return pool;
+    }
+  };
+
+} /* End twg namespace */
+#endif
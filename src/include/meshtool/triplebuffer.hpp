@@ -0,0 +1,58 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __TRIPLEBUFFER_HPP__
+#define __TRIPLEBUFFER_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+namespace twg {
+
+  /**
+   * Lock-free triple buffer for one writer and one reader.
+   * The writer fills back() and publish() swaps it with the
+   * middle slot; the reader's update() swaps its front slot
+   * with the middle one only when that holds something newer.
+   * Neither side ever waits, and the reader always gets the
+   * latest complete value, skipping any it was too slow for.
+   */
+  template <typename T>
+  class tripleBuffer {
+  public:
+    // Writer side
+    T &back() { return slots[backIndex]; }
+    void publish()
+    {
+      backIndex = middle.exchange(backIndex | fresh, std::memory_order_acq_rel) & slotMask;
+    }
+
+    // Reader side
+    bool pending() const { return middle.load(std::memory_order_acquire) & fresh; }
+    bool update()
+    {
+      if(!pending())
+	{
+	  return false;
+	}
+      frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & slotMask;
+      return true;
+    }
+    const T &front() const { return slots[frontIndex]; }
+
+  private:
+    static constexpr uint8_t slotMask = 3, fresh = 4;
+    T slots[3]{};
+    std::atomic<uint8_t> middle{1};
+    uint8_t backIndex = 0;
+    uint8_t frontIndex = 2;
+  };
+
+} /* End twg namespace */
+#endif
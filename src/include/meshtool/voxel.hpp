@@ -0,0 +1,101 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __VOXEL_HPP__
+#define __VOXEL_HPP__
+
+#include <meshtool.hpp>
+#include <cstdint>
+#include <functional>
+
+namespace twg {
+
+  enum class voxelMode { surface, solid };
+
+  inline uint64_t spreadBits(uint64_t v)
+  {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+  }
+
+  /**
+   * 63 bit Morton key of 21 bit coordinates, x in the lowest
+   * bit of every triple.
+   */
+  inline uint64_t mortonKey(uint32_t x, uint32_t y, uint32_t z)
+  {
+    return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+  }
+
+  /**
+   * Sparse voxel octree with 32^3 bit bricks as leaves.
+   *
+   * Nodes are stored top-down level by level in one flat
+   * array.  childMask marks partially filled children,
+   * fullMask children that are entirely solid and carry no
+   * storage.  The partial children of a node are contiguous,
+   * starting at firstChild: in the next node level, or for the
+   * last node level in the brick array.
+   *
+   * A brick is brickWords 32 bit words, word (z * 32 + y)
+   * holding the row of voxels along x.
+   */
+  struct sparseVoxelOctree {
+    static constexpr uint32_t brickShift = 5;
+    static constexpr uint32_t brickSize = 1u << brickShift;
+    static constexpr uint32_t brickWords = brickSize * brickSize;
+
+    struct node {
+      uint32_t firstChild;
+      uint8_t childMask;
+      uint8_t fullMask;
+      uint16_t reserved;
+    };
+
+    enum rootStates : uint8_t { ROOT_EMPTY = 0, ROOT_PARTIAL, ROOT_FULL };
+
+    uint32_t resolution = 0;   // voxels per axis, power of two
+    uint32_t levels = 0;       // node levels above the bricks
+    glm::vec3 origin{0.0f};    // world position of voxel (0,0,0)
+    float voxelSize = 1.0f;
+    uint8_t rootState = ROOT_EMPTY;
+    std::vector<node> nodes;
+    std::vector<uint32_t> bricks;
+
+    bool get(uint32_t x, uint32_t y, uint32_t z) const;
+    uint8_t regionState(glm::ivec3 lo, glm::ivec3 hi) const;
+    std::size_t voxelCount() const;
+    std::size_t brickCount() const { return bricks.size() / brickWords; }
+    std::size_t memoryBytes() const
+    {
+      return nodes.size() * sizeof(node) + bricks.size() * sizeof(uint32_t);
+    }
+
+    /**
+     * Visit the filled regions: fn(brickMin, sideInBricks,
+     * words) with words the brick bits, or nullptr when the
+     * whole cube of side bricks is solid.
+     */
+    void forEachBrick(const std::function<void(glm::uvec3, uint32_t,
+					       const uint32_t *)> &fn) const;
+
+    bool save(const std::string &filename) const;
+    bool load(const std::string &filename);
+    bool saveVox(const std::string &filename) const;
+  };
+
+  sparseVoxelOctree voxelize(const mesh &m, uint32_t resolution, voxelMode mode);
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,89 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __WATCH_HPP__
+#define __WATCH_HPP__
+
+#include <meshtool.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace twg {
+
+  /**
+   * Element range [first, end) of one array.
+   */
+  struct dirtyRange {
+    std::size_t first;
+    std::size_t end;
+  };
+
+  /**
+   * One reload for the render thread: the new mesh, and per
+   * array either the ranges that changed or resize when its
+   * length did.  Reloads the render thread has not taken yet
+   * are merged into it.
+   */
+  struct meshUpdate {
+    std::shared_ptr<const mesh> m;
+    std::vector<dirtyRange> vertices, elements, colors;
+    bool resizeVertices = false;
+    bool resizeElements = false;
+    bool resizeColors = false;
+    double parseMs = 0.0;
+    double diffMs = 0.0;
+  };
+
+  /**
+   * Watches the viewer's input with inotify on its directory,
+   * so exporters that write a temporary file and rename it are
+   * seen too.  After the events settle the file is loaded again
+   * on the watcher's own thread, diffed against the resident
+   * copy and handed over as a meshUpdate for the render thread
+   * to apply with glBufferSubData.  A reload that fails, such
+   * as a compressed file caught half written, is logged and
+   * the resident mesh kept; the next write tries again.
+   */
+  class meshWatcher {
+  public:
+    using loader = std::function<bool(const std::string &, mesh &)>;
+
+    static constexpr std::size_t vertexBlock = 1024;    // 24 KB
+    static constexpr std::size_t elementBlock = 4096;   // 16 KB
+
+    meshWatcher() = default;
+    meshWatcher(const meshWatcher &) = delete;
+    meshWatcher &operator=(const meshWatcher &) = delete;
+    ~meshWatcher() { stop(); }
+
+    // resident is what the viewer uploaded from filename
+    bool start(const std::string &filename, const mesh &resident, loader load);
+    void stop();
+    // The pending update, if any
+    bool take(meshUpdate &update);
+
+  private:
+    std::string filename;
+    loader load;
+    std::shared_ptr<const mesh> resident;
+    std::mutex lock;
+    meshUpdate pending;
+    bool hasPending = false;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+    int notify = -1;
+
+    void run();
+    void reload();
+  };
+
+} /* End twg namespace */
+#endif
@@ -0,0 +1,48 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#pragma once
+#ifndef __WELD_HPP__
+#define __WELD_HPP__
+
+#include <meshtool.hpp>
+
+namespace twg {
+
+  /**
+   * Outcome of a weld pass, for the log line and --bench weld.
+   */
+  struct weldStats {
+    std::size_t verticesBefore = 0;
+    std::size_t verticesAfter = 0;
+    std::size_t trianglesRemoved = 0; // collapsed to a line or point
+    double seconds = 0.0;
+
+    double msPerMillion() const
+    {
+      return verticesBefore ? seconds * 1e9 / verticesBefore : 0.0;
+    }
+  };
+
+  /**
+   * Merge vertices closer than epsilon, using a uniform grid
+   * spatial hash.  Every vertex maps to the lowest indexed
+   * vertex within epsilon (chains follow to their first
+   * vertex), so the result does not depend on thread count.
+   * elements are remapped in place and collapsed triangles
+   * dropped; normals are rebuilt with smoothNormals.
+   */
+  weldStats weldVertices(mesh &m, float epsilon);
+
+  /**
+   * Area weighted vertex normals from the faces.
+   */
+  void smoothNormals(mesh &m);
+
+} /* End twg namespace */
+#endif
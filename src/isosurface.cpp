@@ -0,0 +1,640 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <isosurface.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace twg {
+
+  /**
+   * Read a raw volume and place it in [-1,1] along its longest
+   * axis, so the viewer's default camera frames it.
+   */
+  bool denseVolume::loadRaw(const std::string &filename, glm::ivec3 size,
+			    const std::string &type, bool sdf)
+  {
+    std::size_t count = std::size_t(size.x) * size.y * size.z;
+    std::size_t bytes = type == "u8" ? 1 : type == "u16" ? 2 : type == "f32" ? 4 : 0;
+    if(bytes == 0 || count == 0 || glm::any(glm::lessThan(size, glm::ivec3(2))))
+      {
+	LOG("[Error] Bad raw volume layout for: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    std::ifstream in{filename, ios::in | ios::binary};
+    if(!in)
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    std::vector<char> raw(count * bytes);
+    if(!in.read(raw.data(), raw.size()))
+      {
+	LOG("[Error] Short raw volume: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    dims = size;
+    values.resize(count);
+    float sign = sdf ? 1.0f : -1.0f;
+    parallelFor(0, count, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    float v;
+	    if(bytes == 1)
+	      {
+		v = static_cast<uint8_t>(raw[i]);
+	      }
+	    else if(bytes == 2)
+	      {
+		uint16_t u;
+		std::memcpy(&u, &raw[i * 2], 2);
+		v = u;
+	      }
+	    else
+	      {
+		std::memcpy(&v, &raw[i * 4], 4);
+	      }
+	    values[i] = sign * v;
+	  }
+      });
+    isoSign = sign;
+    spacing = 2.0f / (std::max(size.x, std::max(size.y, size.z)) - 1);
+    origin = -0.5f * spacing * glm::vec3(size - 1);
+    return true;
+  }
+
+  /**
+   * Cube topology.  Corner i sits at (i&1, i>>1&1, i>>2&1).
+   * Edge (axis * 4 + k) runs along axis from the corner whose
+   * other two coordinates are the bits of k.
+   */
+  static const int isoBlock = 32;
+
+  static inline glm::ivec3 cornerOffset(int c)
+  {
+    return glm::ivec3(c & 1, (c >> 1) & 1, (c >> 2) & 1);
+  }
+
+  static inline int edgeAxis(int e) { return e >> 2; }
+
+  static inline glm::ivec3 edgeOffset(int e)
+  {
+    int a = e >> 2;
+    glm::ivec3 o(0);
+    o[(a + 1) % 3] = e & 1;
+    o[(a + 2) % 3] = (e >> 1) & 1;
+    return o;
+  }
+
+  static int edgeBetween(int p, int q)
+  {
+    int a = __builtin_ctz(p ^ q);
+    int c = std::min(p, q);
+    return a * 4 + ((c >> ((a + 1) % 3)) & 1) + 2 * ((c >> ((a + 2) % 3)) & 1);
+  }
+
+  /**
+   * Marching cubes triangle table, built once from the cube
+   * topology instead of the usual 256 row literal.  On every
+   * face each run of inside corners is cut off by a segment
+   * from the edge where the run is left to the edge where it
+   * was entered; the segments chain into closed polygons that
+   * are fanned into triangles.  Because a face is cut the same
+   * way from both cubes sharing it, the surface is crack free.
+   * patch numbers the polygons of a cube and gives each sign
+   * changing edge the one it belongs to, -1 for the others.
+   */
+  struct mcTable {
+    std::array<std::vector<uint8_t>, 256> tris;
+    std::array<std::array<int8_t, 12>, 256> patch;
+    std::array<uint8_t, 256> patches;
+
+    mcTable()
+    {
+      static const int faceCorners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+      for(int index = 0; index < 256; ++index)
+	{
+	  int next[12];
+	  std::fill(next, next + 12, -1);
+	  for(int a = 0; a < 3; ++a)
+	    for(int s = 0; s < 2; ++s)
+	      {
+		// Corners counter clockwise seen from outside the face
+		int cycle[4];
+		for(int k = 0; k < 4; ++k)
+		  {
+		    int bu = faceCorners[s ? k : 3 - k][0];
+		    int bv = faceCorners[s ? k : 3 - k][1];
+		    cycle[k] = s << a | bu << ((a + 1) % 3) | bv << ((a + 2) % 3);
+		  }
+		for(int k = 0; k < 4; ++k)
+		  {
+		    int p = cycle[k], q = cycle[(k + 1) % 4];
+		    if((index >> p & 1) || !(index >> q & 1))
+		      {
+			continue;
+		      }
+		    // Entered the inside run at edge (p,q); find its exit
+		    for(int j = 1; j < 4; ++j)
+		      {
+			int r = cycle[(k + j) % 4], t = cycle[(k + j + 1) % 4];
+			if((index >> r & 1) && !(index >> t & 1))
+			  {
+			    next[edgeBetween(r, t)] = edgeBetween(p, q);
+			    break;
+			  }
+		      }
+		  }
+	      }
+	  bool used[12] = {};
+	  patch[index].fill(-1);
+	  patches[index] = 0;
+	  for(int start = 0; start < 12; ++start)
+	    {
+	      if(next[start] < 0 || used[start])
+		{
+		  continue;
+		}
+	      std::vector<int> loop;
+	      for(int e = start; !used[e]; e = next[e])
+		{
+		  used[e] = true;
+		  patch[index][e] = patches[index];
+		  loop.push_back(e);
+		}
+	      ++patches[index];
+	      for(std::size_t i = 1; i + 1 < loop.size(); ++i)
+		{
+		  tris[index].push_back(loop[0]);
+		  tris[index].push_back(loop[i]);
+		  tris[index].push_back(loop[i + 1]);
+		}
+	    }
+	}
+      // Orient so the triangles face away from the inside corners
+      auto mid = [](int e) {
+	glm::vec3 p = glm::vec3(edgeOffset(e));
+	p[edgeAxis(e)] = 0.5f;
+	return p;
+      };
+      const std::vector<uint8_t> &t = tris[1];
+      glm::vec3 n = glm::cross(mid(t[1]) - mid(t[0]), mid(t[2]) - mid(t[0]));
+      if(glm::dot(n, glm::vec3(1.0f)) < 0.0f)
+	{
+	  for(std::vector<uint8_t> &row : tris)
+	    for(std::size_t i = 0; i < row.size(); i += 3)
+	      std::swap(row[i + 1], row[i + 2]);
+	}
+    }
+  };
+
+  static const mcTable &marchingCubesTable()
+  {
+    static const mcTable table;
+    return table;
+  }
+
+  /**
+   * Field sources: a dense volume, or an occupancy octree
+   * sampled at voxel centres as -0.5 inside and 0.5 outside.
+   */
+  struct denseSource {
+    const denseVolume &v;
+
+    glm::ivec3 dims() const { return v.dims; }
+    bool uniform(glm::ivec3, glm::ivec3) const { return false; }
+    float sample(int x, int y, int z) const { return v.at(x, y, z); }
+    glm::vec3 position(glm::vec3 g) const { return v.origin + g * v.spacing; }
+  };
+
+  struct octreeSource {
+    const sparseVoxelOctree &t;
+
+    glm::ivec3 dims() const { return glm::ivec3(t.resolution); }
+    bool uniform(glm::ivec3 lo, glm::ivec3 hi) const
+    {
+      return t.regionState(lo, hi) != sparseVoxelOctree::ROOT_PARTIAL;
+    }
+    float sample(int x, int y, int z) const { return t.get(x, y, z) ? -0.5f : 0.5f; }
+    glm::vec3 position(glm::vec3 g) const
+    {
+      return t.origin + (g + 0.5f) * t.voxelSize;
+    }
+  };
+
+  /**
+   * Per block output.  Vertices a block owns are stored
+   * locally; references to vertices owned by a neighbouring
+   * block are kept as placeholders (top bit, neighbour
+   * direction, neighbour local key) until every block is done.
+   * boundary lists the owned keys neighbours may ask for.
+   */
+  struct isoBlockResult {
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> elements;
+    std::vector<std::pair<uint32_t, uint32_t>> boundary;
+  };
+
+  static const uint32_t placeholderBit = 0x80000000u;
+  static const uint32_t unusedSlot = 0xffffffffu;
+
+  /**
+   * Scratch for one block: samples with a one voxel apron on
+   * every side for central difference gradients, and the slot
+   * table from local key to local vertex index.
+   */
+  struct isoScratch {
+    static const int S = isoBlock + 3;
+    std::vector<float> samples;
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> touched;
+
+    float f(int x, int y, int z) const
+    {
+      return samples[((z + 1) * S + (y + 1)) * S + (x + 1)];
+    }
+
+    float f(glm::ivec3 c) const { return f(c.x, c.y, c.z); }
+
+    glm::vec3 gradient(glm::ivec3 c) const
+    {
+      return 0.5f * glm::vec3(f(c.x + 1, c.y, c.z) - f(c.x - 1, c.y, c.z),
+			      f(c.x, c.y + 1, c.z) - f(c.x, c.y - 1, c.z),
+			      f(c.x, c.y, c.z + 1) - f(c.x, c.y, c.z - 1));
+    }
+  };
+
+  template <typename Source>
+  class isoExtractor {
+  public:
+    isoExtractor(const Source &src, float iso, isoMethod method)
+      : src(src), iso(iso), method(method)
+    {
+      cells = src.dims() - 1;
+      blocks = (cells + isoBlock - 1) / isoBlock;
+    }
+
+    mesh run()
+    {
+      mesh out;
+      if(glm::any(glm::lessThan(cells, glm::ivec3(1))))
+	{
+	  return out;
+	}
+      std::size_t count = std::size_t(blocks.x) * blocks.y * blocks.z;
+      results.assign(count, isoBlockResult{});
+      threadPool &pool = threadPool::shared();
+      taskGroup group;
+      for(std::size_t b = 0; b < count; ++b)
+	{
+	  pool.run(group, [this, b] { extractBlock(b); });
+	}
+      pool.wait(group);
+
+      // Global vertex and element offsets per block
+      std::vector<std::size_t> vbase(count + 1, 0), ebase(count + 1, 0);
+      for(std::size_t b = 0; b < count; ++b)
+	{
+	  vbase[b + 1] = vbase[b] + results[b].vertices.size();
+	  ebase[b + 1] = ebase[b] + results[b].elements.size();
+	}
+      out.vertices.resize(vbase[count]);
+      out.elements.resize(ebase[count]);
+      for(std::size_t b = 0; b < count; ++b)
+	{
+	  pool.run(group, [&, b] {
+	      const isoBlockResult &r = results[b];
+	      std::copy(r.vertices.begin(), r.vertices.end(),
+			out.vertices.begin() + vbase[b]);
+	      glm::ivec3 bc = blockCoord(b);
+	      for(std::size_t i = 0; i < r.elements.size(); ++i)
+		{
+		  uint32_t e = r.elements[i];
+		  if(!(e & placeholderBit))
+		    {
+		      out.elements[ebase[b] + i] = vbase[b] + e;
+		      continue;
+		    }
+		  glm::ivec3 d = directionOf(e >> 24 & 0x7f);
+		  std::size_t nb = blockIndex(bc + d);
+		  out.elements[ebase[b] + i] = vbase[nb] + lookup(results[nb], e & 0xffffff);
+		}
+	    });
+	}
+      pool.wait(group);
+      results.clear();
+      return out;
+    }
+
+  private:
+    const Source &src;
+    float iso;
+    isoMethod method;
+    glm::ivec3 cells, blocks;
+    std::vector<isoBlockResult> results;
+
+    glm::ivec3 blockCoord(std::size_t b) const
+    {
+      return glm::ivec3(b % blocks.x, (b / blocks.x) % blocks.y,
+			b / (std::size_t(blocks.x) * blocks.y));
+    }
+
+    std::size_t blockIndex(glm::ivec3 c) const
+    {
+      return (std::size_t(c.z) * blocks.y + c.y) * blocks.x + c.x;
+    }
+
+    // Neighbour offsets are in {-1,0,1}, packed base 3
+    static uint32_t directionCode(glm::ivec3 d)
+    {
+      return (d.x + 1) + 3 * (d.y + 1) + 9 * (d.z + 1);
+    }
+
+    static glm::ivec3 directionOf(uint32_t code)
+    {
+      return glm::ivec3(code % 3, (code / 3) % 3, code / 9) - 1;
+    }
+
+    static uint32_t lookup(const isoBlockResult &r, uint32_t key)
+    {
+      auto it = std::lower_bound(r.boundary.begin(), r.boundary.end(),
+				 std::make_pair(key, 0u));
+      return it != r.boundary.end() && it->first == key ? it->second : 0;
+    }
+
+    void extractBlock(std::size_t b)
+    {
+      static thread_local isoScratch s;
+      const int B = isoBlock, S = isoScratch::S;
+      glm::ivec3 bc = blockCoord(b);
+      glm::ivec3 lo = bc * B;
+      glm::ivec3 n = glm::min(glm::ivec3(B), cells - lo);
+      glm::ivec3 maxSample = src.dims() - 1;
+      if(src.uniform(lo - 1, lo + n + 1))
+	{
+	  return;
+	}
+
+      // Sample the block plus apron, clamped at the volume border
+      s.samples.resize(std::size_t(S) * S * S);
+      bool below = false, above = false;
+      for(int z = -1; z <= B + 1; ++z)
+	for(int y = -1; y <= B + 1; ++y)
+	  for(int x = -1; x <= B + 1; ++x)
+	    {
+	      glm::ivec3 g = glm::clamp(lo + glm::ivec3(x, y, z), glm::ivec3(0), maxSample);
+	      float v = src.sample(g.x, g.y, g.z);
+	      s.samples[((z + 1) * S + (y + 1)) * S + (x + 1)] = v;
+	      if(x >= 0 && y >= 0 && z >= 0 && x <= n.x && y <= n.y && z <= n.z)
+		{
+		  (v < iso ? below : above) = true;
+		}
+	    }
+      if(!below || !above)
+	{
+	  return;
+	}
+
+      isoBlockResult &r = results[b];
+      if(method == isoMethod::marchingCubes)
+	{
+	  marchBlock(s, bc, lo, n, r);
+	}
+      else
+	{
+	  contourBlock(s, lo, n, r);
+	}
+      for(uint32_t key : s.touched)
+	{
+	  s.slots[key] = unusedSlot;
+	}
+      s.touched.clear();
+      std::sort(r.boundary.begin(), r.boundary.end());
+    }
+
+    static void prepareSlots(isoScratch &s, std::size_t size)
+    {
+      if(s.slots.size() != size)
+	{
+	  s.slots.assign(size, unusedSlot);
+	}
+    }
+
+    void marchBlock(isoScratch &s, glm::ivec3 bc, glm::ivec3 lo, glm::ivec3 n,
+		    isoBlockResult &r)
+    {
+      const int B = isoBlock, E = isoBlock + 1;
+      const mcTable &table = marchingCubesTable();
+      glm::ivec3 last = blocks - 1;
+
+      // Vertex on the edge along axis a from local corner c
+      auto edgeVertex = [&](glm::ivec3 c, int a) -> uint32_t {
+	glm::ivec3 g = lo + c;
+	glm::ivec3 owner = glm::min(g / B, last);
+	glm::ivec3 d = owner - bc;
+	glm::ivec3 l = g - owner * B;
+	uint32_t key = ((l.z * E + l.y) * E + l.x) * 3 + a;
+	if(d != glm::ivec3(0))
+	  {
+	    return placeholderBit | directionCode(d) << 24 | key;
+	  }
+	uint32_t &v = s.slots[key];
+	if(v == unusedSlot)
+	  {
+	    glm::ivec3 c1 = c;
+	    c1[a] += 1;
+	    float f0 = s.f(c), f1 = s.f(c1);
+	    float t = f1 != f0 ? glm::clamp((iso - f0) / (f1 - f0), 0.0f, 1.0f) : 0.5f;
+	    glm::vec3 p = glm::vec3(g);
+	    p[a] += t;
+	    glm::vec3 grad = glm::mix(s.gradient(c), s.gradient(c1), t);
+	    float len = glm::length(grad);
+	    v = r.vertices.size();
+	    r.vertices.push_back(Vertex{src.position(p),
+		  len > 0.0f ? grad / len : glm::vec3(0.0f, 1.0f, 0.0f)});
+	    s.touched.push_back(key);
+	    if(l.x == 0 || l.y == 0 || l.z == 0)
+	      {
+		r.boundary.emplace_back(key, v);
+	      }
+	  }
+	return v;
+      };
+
+      prepareSlots(s, std::size_t(E) * E * E * 3);
+      for(int z = 0; z < n.z; ++z)
+	for(int y = 0; y < n.y; ++y)
+	  for(int x = 0; x < n.x; ++x)
+	    {
+	      glm::ivec3 c(x, y, z);
+	      int index = 0;
+	      for(int i = 0; i < 8; ++i)
+		{
+		  index |= (s.f(c + cornerOffset(i)) < iso) << i;
+		}
+	      for(uint8_t e : table.tris[index])
+		{
+		  r.elements.push_back(edgeVertex(c + edgeOffset(e), edgeAxis(e)));
+		}
+	    }
+    }
+
+    /**
+     * Dual contouring: one vertex per surface patch of a sign
+     * changing cell, the patches being the marching cubes
+     * polygons of the cell, so a cell the surface passes
+     * through twice does not pinch both sheets to one point.
+     * Each vertex is placed by minimising the QEF of its edge
+     * crossing planes (biased toward their mass point and kept
+     * inside the cell), then a quad joins the vertices of the
+     * four cells around every sign changing edge, taking in
+     * each cell the patch that edge belongs to.
+     */
+    void contourBlock(isoScratch &s, glm::ivec3 lo, glm::ivec3 n, isoBlockResult &r)
+    {
+      const int B = isoBlock;
+      const mcTable &table = marchingCubesTable();
+      prepareSlots(s, std::size_t(B) * B * B);
+
+      auto cubeIndex = [&](glm::ivec3 c) {
+	int index = 0;
+	for(int i = 0; i < 8; ++i)
+	  {
+	    index |= (s.f(c + cornerOffset(i)) < iso) << i;
+	  }
+	return index;
+      };
+
+      // Every active cell gets its vertices first: neighbours
+      // may reference cells this block's own quads never touch.
+      for(int z = 0; z < n.z; ++z)
+	for(int y = 0; y < n.y; ++y)
+	  for(int x = 0; x < n.x; ++x)
+	    {
+	      glm::ivec3 c(x, y, z);
+	      int index = cubeIndex(c);
+	      int patches = table.patches[index];
+	      if(patches == 0)
+		{
+		  continue;
+		}
+	      uint32_t key = (z * B + y) * B + x;
+	      s.slots[key] = r.vertices.size();
+	      s.touched.push_back(key);
+	      for(int k = 0; k < patches; ++k)
+		{
+		  glm::vec3 mass(0.0f), normal(0.0f);
+		  glm::mat3 ata(0.0f);
+		  glm::vec3 atb(0.0f);
+		  std::array<glm::vec3, 12> points, normals;
+		  int crossings = 0;
+		  for(int e = 0; e < 12; ++e)
+		    {
+		      if(table.patch[index][e] != k)
+			{
+			  continue;
+			}
+		      int a = edgeAxis(e);
+		      glm::ivec3 c0 = c + edgeOffset(e), c1 = c0;
+		      c1[a] += 1;
+		      float f0 = s.f(c0), f1 = s.f(c1);
+		      float t = glm::clamp((iso - f0) / (f1 - f0), 0.0f, 1.0f);
+		      glm::vec3 p = glm::vec3(c0);
+		      p[a] += t;
+		      glm::vec3 grad = glm::mix(s.gradient(c0), s.gradient(c1), t);
+		      float len = glm::length(grad);
+		      points[crossings] = p;
+		      normals[crossings] = len > 0.0f ? grad / len : glm::vec3(0.0f);
+		      normal += normals[crossings];
+		      mass += p;
+		      ++crossings;
+		    }
+		  mass /= float(crossings);
+		  const float bias = 0.05f;
+		  for(int i = 0; i < crossings; ++i)
+		    {
+		      const glm::vec3 &nn = normals[i];
+		      ata += glm::outerProduct(nn, nn);
+		      atb += nn * glm::dot(nn, points[i] - mass);
+		    }
+		  ata += glm::mat3(bias);
+		  glm::vec3 p = mass + glm::inverse(ata) * atb;
+		  p = glm::clamp(p, glm::vec3(c), glm::vec3(c + 1));
+		  float len = glm::length(normal);
+		  uint32_t v = r.vertices.size();
+		  r.vertices.push_back(Vertex{src.position(glm::vec3(lo) + p),
+			len > 0.0f ? normal / len : glm::vec3(0.0f, 1.0f, 0.0f)});
+		  if(x == B - 1 || y == B - 1 || z == B - 1)
+		    {
+		      r.boundary.emplace_back(key | k << 15, v);
+		    }
+		}
+	    }
+
+      // Cells at -1 belong to the lower neighbour, always full
+      // size; e is the shared edge as seen from cell c.
+      auto cellVertex = [&](glm::ivec3 c, int e) -> uint32_t {
+	uint32_t k = table.patch[cubeIndex(c)][e];
+	glm::ivec3 d = glm::ivec3(glm::lessThan(c, glm::ivec3(0))) * -1;
+	glm::ivec3 l = c - d * B;
+	uint32_t key = (l.z * B + l.y) * B + l.x;
+	if(d != glm::ivec3(0))
+	  {
+	    return placeholderBit | directionCode(d) << 24 | key | k << 15;
+	  }
+	return s.slots[key] + k;
+      };
+
+      for(int z = 0; z < n.z; ++z)
+	for(int y = 0; y < n.y; ++y)
+	  for(int x = 0; x < n.x; ++x)
+	    {
+	      glm::ivec3 c(x, y, z), g = lo + c;
+	      float f0 = s.f(c);
+	      for(int a = 0; a < 3; ++a)
+		{
+		  int u = (a + 1) % 3, v = (a + 2) % 3;
+		  glm::ivec3 c1 = c;
+		  c1[a] += 1;
+		  if(g[u] == 0 || g[v] == 0 || (f0 < iso) == (s.f(c1) < iso))
+		    {
+		      continue;
+		    }
+		  glm::ivec3 du(0), dv(0);
+		  du[u] = 1;
+		  dv[v] = 1;
+		  uint32_t q[4] = {cellVertex(c, a * 4), cellVertex(c - du, a * 4 + 1),
+				   cellVertex(c - du - dv, a * 4 + 3), cellVertex(c - dv, a * 4 + 2)};
+		  if(!(f0 < iso))
+		    {
+		      std::swap(q[1], q[3]);
+		    }
+		  for(int i : {0, 1, 2, 0, 2, 3})
+		    {
+		      r.elements.push_back(q[i]);
+		    }
+		}
+	    }
+    }
+  };
+
+  mesh extractIsosurface(const denseVolume &v, float iso, isoMethod method)
+  {
+    denseSource src{v};
+    return isoExtractor<denseSource>(src, iso * v.isoSign, method).run();
+  }
+
+  mesh extractIsosurface(const sparseVoxelOctree &t, isoMethod method)
+  {
+    octreeSource src{t};
+    return isoExtractor<octreeSource>(src, 0.0f, method).run();
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,245 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <materials.hpp>
+#include <parallel.hpp>
+
+namespace twg {
+
+  bool loadMaterialLibrary(const std::string &filename, std::vector<material> &materials,
+			   std::unordered_map<std::string, GLuint> &names)
+  {
+    ifstream in{filename, ios::in};
+    if(!in)
+      {
+	LOG("[Error] Cannot open material library: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    std::string line;
+    material *current = nullptr;
+    std::size_t before = materials.size();
+    while(std::getline(in, line))
+      {
+	std::istringstream ss{line};
+	std::string word;
+	ss >> word;
+	if(word == "newmtl")
+	  {
+	    material m;
+	    ss >> m.name;
+	    names[m.name] = static_cast<GLuint>(materials.size());
+	    materials.push_back(m);
+	    current = &materials.back();
+	  }
+	else if(!current)
+	  {
+	    continue;
+	  }
+	else if(word == "Kd")
+	  {
+	    ss >> current->diffuse.r >> current->diffuse.g >> current->diffuse.b;
+	  }
+	else if(word == "Ks")
+	  {
+	    ss >> current->specular.r >> current->specular.g >> current->specular.b;
+	  }
+	else if(word == "Ns")
+	  {
+	    ss >> current->shininess;
+	  }
+	else if(word == "d")
+	  {
+	    ss >> current->opacity;
+	  }
+	else if(word == "Tr")
+	  {
+	    float transparency = 0.0f;
+	    ss >> transparency;
+	    current->opacity = 1.0f - transparency;
+	  }
+      }
+    LOG("[Ok] Read "); LOG(materials.size() - before); LOG(" materials from ");
+    LOG(filename); LOG("\n");
+    return true;
+  }
+
+  void groupByMaterial(mesh &m, const std::vector<GLuint> &faceMaterial)
+  {
+    std::size_t triangles = m.elements.size() / 3;
+    std::size_t count = m.materials.size();
+    std::vector<GLuint> start(count + 1, 0);
+    for(std::size_t t = 0; t < triangles; ++t)
+      {
+	++start[faceMaterial[t] + 1];
+      }
+    for(std::size_t i = 0; i < count; ++i)
+      {
+	start[i + 1] += start[i];
+      }
+    m.materialRanges.clear();
+    for(std::size_t i = 0; i < count; ++i)
+      {
+	if(start[i + 1] > start[i])
+	  {
+	    m.materialRanges.push_back({static_cast<GLuint>(i), 3 * start[i],
+					3 * (start[i + 1] - start[i])});
+	  }
+      }
+
+    // Stable counting sort of the triangles
+    std::vector<GLuint> sorted(3 * triangles);
+    for(std::size_t t = 0; t < triangles; ++t)
+      {
+	GLuint slot = start[faceMaterial[t]]++;
+	std::copy(&m.elements[3 * t], &m.elements[3 * t] + 3, &sorted[3 * slot]);
+      }
+    m.elements.swap(sorted);
+  }
+
+  void materialDraw::upload(const mesh &m, GLuint program)
+  {
+    ranges = m.materialRanges;
+    materials = m.materials.size();
+
+    // Give every vertex one material, duplicating it for each
+    // further material that uses it
+    const GLuint unset = ~0u;
+    std::vector<GLuint> owner(m.vertices.size(), unset);
+    std::vector<Vertex> vertices = m.vertices;
+    std::vector<GLuint> materialIds(m.vertices.size(), 0);
+    std::vector<GLuint> elements = m.elements;
+    std::unordered_map<GLuint, GLuint> copies;
+    for(const materialRange &r : ranges)
+      {
+	copies.clear();
+	for(GLuint i = r.first; i < r.first + r.count; ++i)
+	  {
+	    GLuint v = elements[i];
+	    if(owner[v] == unset)
+	      {
+		owner[v] = r.material;
+		materialIds[v] = r.material;
+	      }
+	    else if(owner[v] != r.material)
+	      {
+		auto found = copies.find(v);
+		if(found == copies.end())
+		  {
+		    found = copies.emplace(v, static_cast<GLuint>(vertices.size())).first;
+		    vertices.push_back(m.vertices[v]);
+		    materialIds.push_back(r.material);
+		  }
+		elements[i] = found->second;
+	      }
+	  }
+      }
+
+    // Ranges are sorted by material, so each block of
+    // blockMaterials materials is one contiguous element run
+    blocks.clear();
+    for(const materialRange &r : ranges)
+      {
+	GLuint firstMaterial = r.material / blockMaterials * blockMaterials;
+	if(blocks.empty() || blocks.back().firstMaterial != firstMaterial)
+	  {
+	    blocks.push_back({firstMaterial, r.first, 0});
+	  }
+	blocks.back().count = r.first + r.count - blocks.back().first;
+      }
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(),
+		 GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			  reinterpret_cast<void *>(offsetof(Vertex, point)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			  reinterpret_cast<void *>(offsetof(Vertex, normal)));
+    glEnableVertexAttribArray(1);
+    glGenBuffers(1, &ids);
+    glBindBuffer(GL_ARRAY_BUFFER, ids);
+    glBufferData(GL_ARRAY_BUFFER, materialIds.size() * sizeof(GLuint), materialIds.data(),
+		 GL_STATIC_DRAW);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, 0, nullptr);
+    glEnableVertexAttribArray(2);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * sizeof(GLuint), elements.data(),
+		 GL_STATIC_DRAW);
+
+    // std140: diffuse rgb + opacity, specular rgb + shininess;
+    // padded to whole blocks so every bound range is full size
+    std::size_t padded = (materials + blockMaterials - 1) / blockMaterials * blockMaterials;
+    std::vector<glm::vec4> params(2 * std::max<std::size_t>(padded, blockMaterials), glm::vec4(0.0f));
+    for(std::size_t i = 0; i < materials; ++i)
+      {
+	const material &mat = m.materials[i];
+	params[2 * i] = glm::vec4(mat.diffuse, mat.opacity);
+	params[2 * i + 1] = glm::vec4(mat.specular, std::max(mat.shininess, 1.0f));
+      }
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, params.size() * sizeof(glm::vec4), params.data(),
+		 GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glUniformBlockBinding(program, glGetUniformBlockIndex(program, "materials"), 0);
+    baseLoc = glGetUniformLocation(program, "materialBase");
+
+    LOG("[Ok] Materials: "); LOG(materials); LOG(" in "); LOG(ranges.size());
+    LOG(" ranges, "); LOG(blocks.size()); LOG(" draws, ");
+    LOG(vertices.size() - m.vertices.size()); LOG(" vertices duplicated\n");
+  }
+
+  void materialDraw::draw()
+  {
+    const GLsizeiptr blockBytes = blockMaterials * 2 * sizeof(glm::vec4);
+    draws = stateChanges = 0;
+    for(const block &b : blocks)
+      {
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, b.firstMaterial * 2 * sizeof(glm::vec4),
+			  blockBytes);
+	glUniform1i(baseLoc, static_cast<GLint>(b.firstMaterial));
+	glDrawElements(GL_TRIANGLES, b.count, GL_UNSIGNED_INT,
+		       reinterpret_cast<void *>(std::size_t(b.first) * sizeof(GLuint)));
+	stateChanges += 2;
+	++draws;
+      }
+  }
+
+  /**
+   * What a per material submission costs: a uniform update and
+   * a draw for every range.
+   */
+  void materialDraw::drawPerRange()
+  {
+    const GLsizeiptr blockBytes = blockMaterials * 2 * sizeof(glm::vec4);
+    draws = stateChanges = 0;
+    for(const materialRange &r : ranges)
+      {
+	GLuint firstMaterial = r.material / blockMaterials * blockMaterials;
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, firstMaterial * 2 * sizeof(glm::vec4),
+			  blockBytes);
+	glUniform1i(baseLoc, static_cast<GLint>(firstMaterial));
+	glDrawElements(GL_TRIANGLES, r.count, GL_UNSIGNED_INT,
+		       reinterpret_cast<void *>(std::size_t(r.first) * sizeof(GLuint)));
+	stateChanges += 2;
+	++draws;
+      }
+  }
+
+  void materialDraw::release()
+  {
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ids);
+    glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(1, &ubo);
+    vbo = ids = ebo = ubo = 0;
+  }
+
+} /* End twg namespace */
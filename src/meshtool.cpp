@@ -7,6 +7,31 @@
  *
  */
 #include <meshtool.hpp>
+#include <stream.hpp>
+#include <scene.hpp>
+#include <stats.hpp>
+#include <voxel.hpp>
+#include <isosurface.hpp>
+#include <weld.hpp>
+#include <codec.hpp>
+#include <bench.hpp>
+#include <capture.hpp>
+#include <headless.hpp>
+#include <formats.hpp>
+#include <gltf.hpp>
+#include <materials.hpp>
+#include <subdivision.hpp>
+#include <bake.hpp>
+#include <daemon.hpp>
+#include <batch.hpp>
+#include <pointcloud.hpp>
+#include <sharedmesh.hpp>
+#include <watch.hpp>
+#include <sequence.hpp>
+#include <parallel.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 
 namespace twg {
 
@@ -16,10 +41,10 @@ namespace twg {
     return glm::normalize(a * b);
   }
 
-  static bool isConnected(GLushort a,
-			  GLushort b,
-			  GLushort c,
-			  GLushort x)
+  static bool isConnected(GLuint a,
+			  GLuint b,
+			  GLuint c,
+			  GLuint x)
   {
     if(a == x ||
        b == x ||
@@ -70,7 +95,7 @@ namespace twg {
    */
   static std::vector<glm::vec3>
   avgNormals(const std::vector<glm::vec3>& vertices,
-	     const std::vector<GLushort>& elements)
+	     const std::vector<GLuint>& elements)
   {
     std::vector<glm::vec3> normals;
     normals.resize(vertices.size(), glm::vec3(0.0));
@@ -99,48 +124,114 @@ namespace twg {
   
 
   /** Static utility loadObject to load a .obj mesh description
-   * file and place in a mesh struct.
+   * file and place in a mesh struct.  The file may be gzip or
+   * zstd compressed (see inputStream).  Materials from mtllib
+   * and usemtl are kept, with the faces grouped by material.
+   * False, after logging why, when the file cannot be opened
+   * or its compressed stream is truncated or corrupt.
    */
-  static mesh loadObject(const std::string &filename) {
-    std::ifstream in{filename, ios::in};
-    if (!in) {
+  static bool loadObject(const std::string &filename, mesh &m) {
+    inputStream in{filename};
+    if (!in.good()) {
       LOG("[Error] Not able to open: ");
       LOG(filename); LOG("\n");
-      exit(1);
+      return false;
     }
 
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec3> normals;
-    std::vector<GLushort> elements;
+    std::vector<GLuint> elements;
+    std::vector<material> materials;
+    std::unordered_map<std::string, GLuint> materialNames;
+    std::vector<GLuint> faceMaterial;
+    const GLuint noMaterial = ~0u;
+    GLuint currentMaterial = noMaterial;
+    bool usesMaterials = false;
+    bool haveLibrary = false;     // usemtl means nothing without one
+    bool warnedLibrary = false;
+    std::vector<GLuint> polygon;
+    std::size_t skippedFaces = 0;
+    std::string dir = filename.substr(0, filename.find_last_of('/') + 1);
     std::string line;
 
-    while (std::getline(in, line)) {
+    while (in.getline(line)) {
       if (line.substr(0, 2) == "v ") {
 	std::istringstream ss{line.substr(2)};
-	glm::vec3 vv;
+	glm::vec3 vv{0.0f};
 	ss >> vv.x;
 	ss >> vv.y;
 	ss >> vv.z;
 	vertices.push_back(vv);
       } else if (line.substr(0, 2) == "f ") {
+	// v, v/vt, v//vn or v/vt/vn corners, negative indices
+	// count back from the last vertex; polygons are fanned.
+	// Faces naming a vertex not read yet are skipped whole.
 	std::istringstream ss{line.substr(2)};
-
-	GLushort a;
-	GLushort b;
-	GLushort c;
-	std::string nullStr;
-	ss >> a;
-	ss >> nullStr;
-	ss >> b;
-	ss >> nullStr;
-	ss >> c;
-	elements.push_back(--a);
-	elements.push_back(--b);
-	elements.push_back(--c);
+	std::string corner;
+	polygon.clear();
+	bool valid = true;
+	while (ss >> corner) {
+	  long index = std::strtol(corner.c_str(), nullptr, 10);
+	  long v = index < 0 ? static_cast<long>(vertices.size()) + index : index - 1;
+	  valid = valid && index != 0 && v >= 0 && v < static_cast<long>(vertices.size());
+	  polygon.push_back(static_cast<GLuint>(v));
+	}
+	if (!valid) {
+	  ++skippedFaces;
+	  continue;
+	}
+	for (std::size_t k = 2; k < polygon.size(); ++k) {
+	  GLuint face[3] = {polygon[0], polygon[k - 1], polygon[k]};
+	  elements.insert(elements.end(), face, face + 3);
+	  faceMaterial.push_back(currentMaterial);
+	}
+      } else if (line.substr(0, 7) == "mtllib ") {
+	std::istringstream ss{line.substr(7)};
+	std::string library;
+	while (ss >> library) {
+	  haveLibrary = loadMaterialLibrary(dir + library, materials, materialNames)
+	    || haveLibrary;
+	}
+      } else if (line.substr(0, 7) == "usemtl ") {
+	if (!haveLibrary) {
+	  // Exporters write usemtl without mtllib; keep the plain shading
+	  if (!warnedLibrary) {
+	    LOG("[Ok] usemtl without a material library in "); LOG(filename);
+	    LOG(", ignored\n");
+	    warnedLibrary = true;
+	  }
+	  continue;
+	}
+	std::istringstream ss{line.substr(7)};
+	std::string name;
+	ss >> name;
+	auto found = materialNames.find(name);
+	if (found == materialNames.end()) {
+	  LOG("[Error] Unknown material "); LOG(name); LOG(", using default colour\n");
+	  material m;
+	  m.name = name;
+	  found = materialNames.emplace(name, static_cast<GLuint>(materials.size())).first;
+	  materials.push_back(m);
+	}
+	currentMaterial = found->second;
+	usesMaterials = true;
       } else if (line[0] == '#') {
-	std::cout << "[Ok] OBJ FILE COMMENT: " << line.substr(1) << "\n";
+	LOG("[Ok] OBJ FILE COMMENT: "); LOG(line.substr(1)); LOG("\n");
       }
     }
+    if (in.failed()) {
+      LOG("[Error] Failed reading "); LOG(in.formatName());
+      LOG(" input: "); LOG(filename); LOG("\n");
+      return false;
+    }
+    if (skippedFaces > 0) {
+      LOG("[Error] Skipped "); LOG(skippedFaces); LOG(" faces with out of range indices in ");
+      LOG(filename); LOG("\n");
+    }
+    double mb = in.compressedBytes() / 1e6;
+    double seconds = in.seconds();
+    LOG("[Ok] Read "); LOG(filename); LOG(" ("); LOG(in.formatName()); LOG(") ");
+    LOG(mb); LOG(" MB in "); LOG(seconds * 1e3); LOG(" ms, "); LOG(mb / seconds); LOG(" MB/s\n");
 
     // Normal averaging method - TODO(Todd): get to work
     // if smoothing required.
@@ -149,50 +240,141 @@ namespace twg {
     // Workable normal calculations.
     normals.resize(vertices.size(), glm::vec3(0.0, 0.0, 0.0));
     for (int i = 0; i < elements.size(); i += 3) {
-      GLushort ia = elements[i];
-      GLushort ib = elements[i + 1];
-      GLushort ic = elements[i + 2];
+      GLuint ia = elements[i];
+      GLuint ib = elements[i + 1];
+      GLuint ic = elements[i + 2];
       glm::vec3 normal = glm::normalize(
 					glm::cross(vertices[ib] - vertices[ia], vertices[ic] -
 						   vertices[ia]));
       normals[ia] = normals[ib] = normals[ic] = normal;
     }
-    return mesh{vertices, normals, elements};
+    m = mesh{vertices, normals, elements};
+    if (usesMaterials) {
+      // Faces before the first usemtl get a default material
+      if (std::find(faceMaterial.begin(), faceMaterial.end(), noMaterial)
+	  != faceMaterial.end()) {
+	std::replace(faceMaterial.begin(), faceMaterial.end(), noMaterial,
+		     static_cast<GLuint>(materials.size()));
+	materials.push_back(material{"default"});
+      }
+      m.materials = std::move(materials);
+      groupByMaterial(m, faceMaterial);
+    }
+    return true;
+  }
+
+  // For the command line and the benchmarks: exits on failure
+  static mesh loadObject(const std::string &filename) {
+    mesh m;
+    if (!loadObject(filename, m)) {
+      exit(1);
+    }
+    return m;
+  }
+
+  /**
+   * Static utility saveObject writes a mesh as .obj with
+   * per vertex normals, faces as "f a//a b//b c//c" so that
+   * loadObject reads it back.
+   */
+  static bool saveObject(const mesh &m, const std::string &filename) {
+    std::ofstream out{filename, ios::out};
+    if (!out) {
+      LOG("[Error] Not able to write: ");
+      LOG(filename); LOG("\n");
+      return false;
+    }
+    out << "# meshtool\n";
+    bool colored = m.colors.size() == m.vertices.size();
+    for (std::size_t i = 0; i < m.vertices.size(); ++i) {
+      const glm::vec3 &p = m.vertices[i].point;
+      out << "v " << p.x << " " << p.y << " " << p.z;
+      if (colored) {
+	// Common "v x y z r g b" extension
+	out << " " << m.colors[i].r << " " << m.colors[i].g << " " << m.colors[i].b;
+      }
+      out << "\n";
+    }
+    for (const Vertex &v : m.vertices) {
+      out << "vn " << v.normal.x << " " << v.normal.y << " " << v.normal.z << "\n";
+    }
+    for (std::size_t i = 0; i + 2 < m.elements.size(); i += 3) {
+      out << "f";
+      for (std::size_t k = i; k < i + 3; ++k) {
+	out << " " << m.elements[k] + 1 << "//" << m.elements[k] + 1;
+      }
+      out << "\n";
+    }
+    return static_cast<bool>(out);
+  }
+
+  static void logSubdivision(const subdivisionStats &s) {
+    LOG("[Ok] Subdivided "); LOG(s.trianglesBefore); LOG(" -> ");
+    LOG(s.trianglesAfter); LOG(" triangles in "); LOG(s.levels);
+    LOG(" levels, "); LOG(s.seconds * 1e3); LOG(" ms, ");
+    LOG(s.trianglesPerSecondPerCore()); LOG(" triangles/s per core\n");
   }
   
 
   meshtool::meshtool(mesh *m_mesh)
-    : ft{}, face{}
   {
     this->m_mesh = m_mesh;
-    if(FT_Init_FreeType(&ft))
-      {
-	LOG("[ERROR] Freetype: could not initialize Freetype library!\n");
-      }
-    else
-      {
-	LOG("[Ok] Loaded Freetype.\n");
-      }
-    if(FT_New_Face(ft, "fonts/LiberationMono-Regular.ttf", 0, &face))
-      {
-	LOG("[ERROR] Freetype: failed to load fonst/terminess.ttf!\n");
-      }
-    else
-      {
-	LOG("[Ok] Loaded Hack-Regular.ttf\n");
-      }
-    FT_Set_Pixel_Sizes(face,0,48);
-    initCharacterMap();
   }
   
+  meshtool::meshtool(scene *m_scene)
+    : meshtool(static_cast<mesh *>(nullptr))
+  {
+    this->m_scene = m_scene;
+    scale = 1.0f;
+  }
+
+  meshtool::meshtool(pointCloud *m_points)
+    : meshtool(static_cast<mesh *>(nullptr))
+  {
+    this->m_points = m_points;
+    scale = 1.0f;
+  }
+
+  meshtool::meshtool(sharedMesh *m_shared)
+    : meshtool(static_cast<mesh *>(nullptr))
+  {
+    this->m_shared = m_shared;
+  }
+
+  meshtool::meshtool(meshSequence *m_sequence)
+    : meshtool(static_cast<mesh *>(nullptr))
+  {
+    this->m_sequence = m_sequence;
+    scale = 1.0f;
+  }
+
   meshtool::~meshtool() {}
 
   GLfloat meshtool::idMat[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
 				 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
 
-  void meshtool::initCharacterMap()
+  /**
+   * Freetype rasterization of the printable ASCII glyphs into
+   * CPU bitmaps.  No GL, so it runs on the pool while the
+   * window and context are created.
+   */
+  void meshtool::rasterizeGlyphs()
   {
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    FT_Library ft;
+    FT_Face face;
+    if(FT_Init_FreeType(&ft))
+      {
+	LOG("[ERROR] Freetype: could not initialize Freetype library!\n");
+	return;
+      }
+    if(FT_New_Face(ft, "fonts/LiberationMono-Regular.ttf", 0, &face))
+      {
+	LOG("[ERROR] Freetype: failed to load fonts/LiberationMono-Regular.ttf!\n");
+	FT_Done_FreeType(ft);
+	return;
+      }
+    FT_Set_Pixel_Sizes(face,0,48);
+    glyphs.clear();
     for(GLubyte c=32; c < 127; ++c)
       {
 	 if(FT_Error err = FT_Load_Char(face,c,FT_LOAD_RENDER))
@@ -204,6 +386,35 @@ namespace twg {
 	     LOG("\n");
 	     continue;
 	   }
+	 const FT_Bitmap &bitmap = face->glyph->bitmap;
+	 glyphBitmap glyph;
+	 glyph.c = c;
+	 glyph.size = glm::ivec2(bitmap.width, bitmap.rows);
+	 glyph.bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+	 glyph.advance = static_cast<GLuint>(face->glyph->advance.x);
+	 // Rows may be padded (pitch), keep them tight for upload
+	 glyph.pixels.resize(std::size_t(bitmap.width) * bitmap.rows);
+	 for(unsigned row = 0; row < bitmap.rows; ++row)
+	   {
+	     std::memcpy(&glyph.pixels[std::size_t(row) * bitmap.width],
+			 bitmap.buffer + std::ptrdiff_t(row) * bitmap.pitch, bitmap.width);
+	   }
+	 glyphs.push_back(std::move(glyph));
+      }
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    LOG("[Ok] Rasterized "); LOG(glyphs.size()); LOG(" glyphs\n");
+  }
+
+  /**
+   * Upload the rasterized glyphs as textures, once the context
+   * is current.
+   */
+  void meshtool::initCharacterMap()
+  {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(const glyphBitmap &glyph : glyphs)
+      {
 	GLuint texture;
 	glGenTextures(1, &texture);
 	glBindTexture(GL_TEXTURE_2D, texture);
@@ -211,12 +422,12 @@ namespace twg {
 	  (GL_TEXTURE_2D,
 	   0,
 	   GL_RED,
-	   face->glyph->bitmap.width,
-	   face->glyph->bitmap.rows,
+	   glyph.size.x,
+	   glyph.size.y,
 	   0,
 	   GL_RED,
 	   GL_UNSIGNED_BYTE,
-	   face->glyph->bitmap.buffer);
+	   glyph.pixels.data());
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
 			GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
@@ -227,45 +438,87 @@ namespace twg {
 			GL_LINEAR);
 	Character character = {
 	  texture,
-	  glm::ivec2(face->glyph->bitmap.width,
-		     face->glyph->bitmap.rows),
-	  glm::ivec2(face->glyph->bitmap_left,
-		     face->glyph->bitmap_top),
-	  static_cast<GLuint>(face->glyph->advance.x)
+	  glyph.size,
+	  glyph.bearing,
+	  glyph.advance
 	};
 	characters.insert(std::pair<GLchar,Character>
-			  (c, character));	     
+			  (glyph.c, character));	     
       }
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    std::vector<glyphBitmap>().swap(glyphs);
   }
 
+  /**
+   * Startup graph: glyph rasterization and load (the mesh or
+   * scene the constructor's pointer refers to) run on the
+   * thread pool while this thread brings up SDL video, the
+   * window and the GL context.  Once both are done the glyphs
+   * and geometry are uploaded.  -v prints the phase times.
+   * A load that returns false fails init here, on the calling
+   * thread, once the pool tasks are done: exiting from a pool
+   * worker would join that worker from itself.
+   */
   int meshtool::init(std::string &&title, int xpos, int ypos, int width,
-		     int height, int flags) {
+		     int height, int flags, std::function<bool()> load) {
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point from) {
+      return std::chrono::duration<double, std::milli>(clock::now() - from).count();
+    };
+    auto start = clock::now();
     screen_width = width;
     screen_height = height;
     _isRunning = true;
-    if (SDL_Init(SDL_INIT_EVERYTHING) == 0) {
+
+    threadPool &pool = threadPool::shared();
+    taskGroup loading;
+    pool.run(loading, [this, &ms] {
+	auto begin = clock::now();
+	rasterizeGlyphs();
+	startup.glyphs = ms(begin);
+      });
+    bool loaded = true;
+    if (load) {
+      pool.run(loading, [this, &ms, &load, &loaded] {
+	  auto begin = clock::now();
+	  loaded = load();
+	  startup.load = ms(begin);
+	});
+    }
+    auto fail = [&](int code) {
+      pool.wait(loading);
+      _isRunning = false;
+      return code;
+    };
+
+    // Video only: audio, joystick and haptics cost startup time
+    // and the viewer uses none of them
+    if (SDL_Init(SDL_INIT_VIDEO) == 0) {
       LOG("[Ok] SDL init a success...\n");
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
       _window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED,
 				 SDL_WINDOWPOS_CENTERED, width, height, flags);
       if (_window != 0) {
 	_renderer = SDL_CreateRenderer(_window, -1, 0);
       } else {
 	LOG("[Error] SDL_CreateRenderer failed!\n");
-	return 3;
+	return fail(3);
       }
 
     } else {
       LOG("SDL init failed!...\n");
-      return 3;
+      return fail(3);
+    }
+
+    _context = SDL_GL_CreateContext(_window);
+    if (!_context) {
+      LOG("[Error] SDL_GL_CreateContext failed!\n");
+      return fail(2);
     }
 
     // Initialize the OpenGL environment
     glewInit();
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-
     LOG("[Ok] GL_VERSION= ");
     LOG(glGetString(GL_VERSION)); LOG("\n");
     LOG("[Ok] GL_VENDOR= ");
@@ -273,34 +526,137 @@ namespace twg {
     LOG("[Ok] GL_SHADING_LANGUAGE_VERSION= ");
     LOG(glGetString(GL_SHADING_LANGUAGE_VERSION));
     LOG("\n");
-    GLuint vs, fs;
+    startup.window = ms(start);
 
-    _context = SDL_GL_CreateContext(_window);
-    if (&_context == 0) {
-      LOG("[Error] SDL_GL_CreateContext failed!\n");
-      return 2;
+    auto waiting = clock::now();
+    pool.wait(loading);
+    startup.waited = ms(waiting);
+    if (!loaded) {
+      return fail(4);
     }
 
+    auto uploading = clock::now();
+    initCharacterMap();
+    int result = upload(width, height);
+    glFinish();
+    startup.upload = ms(uploading);
+    startup.total = ms(start);
+    if (verbose) {
+      LOG("[Ok] Startup ms: total= "); LOG(startup.total);
+      LOG(" | pool: load= "); LOG(startup.load);
+      LOG(" glyphs= "); LOG(startup.glyphs);
+      LOG(" | main: sdl+window+context= "); LOG(startup.window);
+      LOG(" waited= "); LOG(startup.waited);
+      LOG(" upload= "); LOG(startup.upload); LOG("\n");
+    }
+    return result;
+  }
+
+  /**
+   * Shaders, camera and geometry, with the context current.
+   */
+  int meshtool::upload(int width, int height) {
     glViewport(0, 0, width, height);
     LOG("Set viewport = (0,0,");
     LOG(width); LOG(",");
     LOG(height); LOG(")\n");
-    modelProgram = Program{"shaders/basic.vs",
-                       "shaders/basic.fs"};
+    if (m_scene) {
+      modelProgram = Program{"shaders/instanced.vs",
+                         "shaders/basic.fs"};
+    } else if (m_points) {
+      modelProgram = Program{"shaders/points.vs",
+                         "shaders/points.fs"};
+    } else if (m_shared || m_sequence) {
+      modelProgram = Program{"shaders/basic.vs",
+                         "shaders/basic.fs"};
+    } else if (!m_mesh->colors.empty()) {
+      // A baked overlay replaces the materials
+      modelProgram = Program{"shaders/color.vs",
+                         "shaders/color.fs"};
+    } else if (!m_mesh->materials.empty()) {
+      modelProgram = Program{"shaders/material.vs",
+                         "shaders/material.fs"};
+    } else {
+      modelProgram = Program{"shaders/basic.vs",
+                         "shaders/basic.fs"};
+    }
     
     glUseProgram(modelProgram.ID);
+    mvpLoc = glGetUniformLocation(modelProgram.ID, "mvpM");
+    mvLoc = glGetUniformLocation(modelProgram.ID, "mvM");
+    nmLoc = glGetUniformLocation(modelProgram.ID, "nM");
+
+    // View and projection only change on resize or camera moves,
+    // the matrix stack keeps their product cached between frames.
+    mats.matrixMode(matrices::PROJECTION_MATRIX);
+    mats.perspective(glm::radians(45.0f),
+		     static_cast<float>(width) / static_cast<float>(height),
+		     0.1f, 100.0f);
+    mats.matrixMode(matrices::VIEW_MATRIX);
+    mats.lookAt(glm::vec3(0.0f, 0.0f, 2.5f), glm::vec3(0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+    mats.matrixMode(matrices::MODEL_MATRIX);
 
     glDisable(GL_DEPTH_TEST);
     glViewport(0, 0, width, height);
 
+    if (m_scene) {
+      m_scene->upload(modelProgram.ID);
+      return 0;
+    }
+    if (m_points) {
+      m_points->upload(modelProgram.ID);
+      return 0;
+    }
+    if (m_shared) {
+      m_shared->upload();
+      return 0;
+    }
+    if (m_sequence) {
+      m_sequence->upload();
+      return 0;
+    }
+
+    // Adaptive subdivision refines for the starting view
+    subdivisionOptions refine;
+    refine.levels = subdivisionLevels;
+    refine.maxEdgePixels = subdivisionPixels;
+    refine.viewport = glm::vec2(width, height);
+    refine.viewProjection =
+      glm::perspective(glm::radians(45.0f),
+		       static_cast<float>(width) / static_cast<float>(height),
+		       0.1f, 100.0f)
+      * glm::lookAt(glm::vec3(0.0f, 0.0f, 2.5f), glm::vec3(0.0f),
+		    glm::vec3(0.0f, 1.0f, 0.0f))
+      * glm::scale(glm::mat4(1.0f), glm::vec3(scale));
+
     glGenVertexArrays(1, &vao);
     glBindVertexArray(vao);
 
+    if (!m_mesh->materials.empty() && m_mesh->colors.empty()) {
+      if (subdivisionLevels > 0) {
+	logSubdivision(subdivide(*m_mesh, refine));
+      }
+      m_materials = new materialDraw;
+      m_materials->upload(*m_mesh, modelProgram.ID);
+      return 0;
+    }
+
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    // vbo format is vvvnnn, or xyzabc
-    glBufferData(GL_ARRAY_BUFFER, m_mesh->size(), &m_mesh->vertices[0],
-		 GL_STATIC_DRAW);
+    glGenBuffers(1, &vbe);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbe);
+    if (subdivisionLevels > 0) {
+      // The finest level is written straight into the buffers
+      logSubdivision(uploadSubdivided(*m_mesh, refine));
+    } else {
+      // vbo format is vvvnnn, or xyzabc
+      glBufferData(GL_ARRAY_BUFFER, m_mesh->size(), &m_mesh->vertices[0],
+		   GL_STATIC_DRAW);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		   m_mesh->elements.size() * sizeof(GLuint), &m_mesh->elements[0],
+		   GL_STATIC_DRAW);
+    }
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
 			  sizeof(Vertex),
@@ -311,11 +667,15 @@ namespace twg {
 			  reinterpret_cast<void *>(offsetof(Vertex, normal)));
     glEnableVertexAttribArray(1);
 
-    glGenBuffers(1, &vbe);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbe);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-		 m_mesh->elements.size() * sizeof(GLushort), &m_mesh->elements[0],
-		 GL_STATIC_DRAW);
+    if (!m_mesh->colors.empty()) {
+      // Baked overlay in its own buffer at location 2
+      glGenBuffers(1, &vbc);
+      glBindBuffer(GL_ARRAY_BUFFER, vbc);
+      glBufferData(GL_ARRAY_BUFFER, m_mesh->colors.size() * sizeof(glm::vec3),
+		   m_mesh->colors.data(), GL_STATIC_DRAW);
+      glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+      glEnableVertexAttribArray(2);
+    }
 
     glDisableVertexAttribArray(vao);
 
@@ -330,38 +690,321 @@ namespace twg {
 
     glUseProgram(modelProgram.ID);
     glBindVertexArray(vao);
-    GLint mM = glGetUniformLocation(modelProgram.ID, "mM");
-    angleY += 0.05;
-    angleY = std::fmod(angleY, 2 * M_PI);
-    angleX += 0.03233;
-    angleX = std::fmod(angleX, 2 * M_PI);
+    // Newest snapshot from update(), the previous one if none
+    frames.update();
+    const frameState &state = frames.front();
+    if (state.screenshots > screenshots) {
+      screenshotPending = true;
+    }
 
-    glm::mat4 modelMat = glm::scale(glm::mat4(1.0), glm::vec3(scale));
-    modelMat = glm::rotate(modelMat, angleY, glm::vec3(0.0f, 1.0f, 0.0f));
-    modelMat = glm::rotate(modelMat, angleX, glm::vec3(1.0f, 0.0f, 0.0f));
-    modelMat = glm::rotate(modelMat, angleZ, glm::vec3(0.0,0.0,1.0));
+    // Ry * Rx * Rz in one step, the uniform scale folds into the
+    // rotation columns.
+    glm::aligned_mat4 modelMat{glm::eulerAngleYXZ(state.angleY, state.angleX,
+						  state.angleZ)};
+    modelMat[0] *= state.scale;
+    modelMat[1] *= state.scale;
+    modelMat[2] *= state.scale;
+    mats.loadMatrix(modelMat);
+    if (m_scene) {
+      // Fit the scene bounds into the unit sphere the camera sees
+      glm::vec3 extent = m_scene->boundsMax - m_scene->boundsMin;
+      float radius = std::max(0.5f * glm::length(extent), 1e-6f);
+      mats.scale(glm::vec3(1.0f / radius));
+      mats.translate(-0.5f * (m_scene->boundsMin + m_scene->boundsMax));
+    } else if (m_points) {
+      glm::vec3 extent = m_points->boundsMax - m_points->boundsMin;
+      float radius = std::max(0.5f * glm::length(extent), 1e-6f);
+      mats.scale(glm::vec3(1.0f / radius));
+      mats.translate(-0.5f * (m_points->boundsMin + m_points->boundsMax));
+    } else if (m_sequence) {
+      // The first frame's bounds, so the motion stays visible
+      glm::vec3 extent = m_sequence->boundsMax - m_sequence->boundsMin;
+      float radius = std::max(0.5f * glm::length(extent), 1e-6f);
+      mats.scale(glm::vec3(1.0f / radius));
+      mats.translate(-0.5f * (m_sequence->boundsMin + m_sequence->boundsMax));
+    }
 
-    glUniformMatrix4fv(mM, 1, GL_FALSE, glm::value_ptr(modelMat));
+    if(mats.dirty())
+      {
+	glUniformMatrix4fv(mvLoc, 1, GL_FALSE,
+			   glm::value_ptr(mats.getModelViewMatrix()));
+	glUniformMatrix3fv(nmLoc, 1, GL_FALSE,
+			   glm::value_ptr(mats.getNormalMatrix()));
+	glUniformMatrix4fv(mvpLoc, 1, GL_FALSE,
+			   glm::value_ptr(mats.getMVPMatrix()));
+      }
 
     // Draw triangles from vertices
     // glDrawArrays(GL_TRIANGLES,0,m_mesh->vertices.size());
 
+    if (m_scene) {
+      auto start = std::chrono::high_resolution_clock::now();
+      int draws = m_scene->draw();
+      submitTime += std::chrono::duration<double, std::milli>
+	(std::chrono::high_resolution_clock::now() - start).count();
+      if (++statFrames == 120) {
+	LOG("[Ok] Scene: "); LOG(m_scene->instanceCount());
+	LOG(" instances in "); LOG(draws);
+	LOG(" draws, submit ms/frame= "); LOG(submitTime / statFrames);
+	LOG("\n");
+	submitTime = 0.0;
+	statFrames = 0;
+      }
+      present();
+      return;
+    }
+
+    if (m_points) {
+      // Pixels per unit at distance 1 for the 45 degree view
+      float pixelScale = 0.5f * screen_height / std::tan(glm::radians(22.5f));
+      auto start = std::chrono::high_resolution_clock::now();
+      pointFrameStats ps = m_points->draw(mats.getModelViewMatrix(), mats.getMVPMatrix(),
+					  pixelScale);
+      submitTime += std::chrono::duration<double, std::milli>
+	(std::chrono::high_resolution_clock::now() - start).count();
+      if (++statFrames == 120) {
+	LOG("[Ok] Points: "); LOG(ps.points); LOG(" of "); LOG(m_points->pointCount());
+	LOG(" in "); LOG(ps.nodes); LOG(" nodes, "); LOG(ps.residentPoints);
+	LOG(" resident, submit ms/frame= "); LOG(submitTime / statFrames); LOG("\n");
+	submitTime = 0.0;
+	statFrames = 0;
+      }
+      present();
+      return;
+    }
+
+    if (m_shared) {
+      // Producer commits since the last frame, then the buffers as they are
+      m_shared->refresh();
+      m_shared->draw();
+      if (++statFrames == 120) {
+	const sharedFrameStats &ss = m_shared->stats();
+	LOG("[Ok] Shared: "); LOG(m_shared->elementCount() / 3); LOG(" triangles, ");
+	LOG(ss.generations); LOG(" generations ("); LOG(ss.partial); LOG(" partial, ");
+	LOG(ss.torn); LOG(" torn), "); LOG(ss.bytes / 1048576.0); LOG(" MB uploaded\n");
+	statFrames = 0;
+      }
+      present();
+      return;
+    }
+
+    if (m_sequence) {
+      m_sequence->draw();
+      if (++statFrames == 120) {
+	sequenceStats ss = m_sequence->stats();
+	LOG("[Ok] Sequence: frame "); LOG(m_sequence->currentFrame() + 1); LOG("/");
+	LOG(m_sequence->frameCount()); LOG(", "); LOG(ss.shown); LOG(" shown, ");
+	LOG(ss.dropped); LOG(" dropped, decode ms mean= "); LOG(ss.meanDecodeMs());
+	LOG(" max= "); LOG(ss.decodeMaxMs); LOG(", upload ms mean= ");
+	LOG(ss.meanUploadMs()); LOG("\n");
+	statFrames = 0;
+      }
+      present();
+      return;
+    }
+
+    if (m_watch) {
+      applyUpdate();
+    }
+
+    if (m_materials) {
+      auto start = std::chrono::high_resolution_clock::now();
+      m_materials->draw();
+      submitTime += std::chrono::duration<double, std::milli>
+	(std::chrono::high_resolution_clock::now() - start).count();
+      if (++statFrames == 120) {
+	LOG("[Ok] Materials: "); LOG(m_materials->materialCount());
+	LOG(" in "); LOG(m_materials->draws); LOG(" draws, ");
+	LOG(m_materials->stateChanges); LOG(" state changes, submit ms/frame= ");
+	LOG(submitTime / statFrames); LOG("\n");
+	submitTime = 0.0;
+	statFrames = 0;
+      }
+      present();
+      return;
+    }
+
     glEnableVertexAttribArray(vao);
     int size;
     glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-    glDrawElements(GL_TRIANGLES, size / sizeof(GLushort), GL_UNSIGNED_SHORT, 0);
+    glDrawElements(GL_TRIANGLES, size / sizeof(GLuint), GL_UNSIGNED_INT, 0);
     /* Send to GPU */
+    present();
+  }
+
+  /**
+   * Upload the changed ranges of one array, or all of it into
+   * a new store when its length changed.  Bytes sent.
+   */
+  template <typename T>
+  static std::size_t uploadRanges(GLenum target, const std::vector<T> &data,
+				  const std::vector<dirtyRange> &ranges, bool resize) {
+    if (resize) {
+      glBufferData(target, data.size() * sizeof(T), data.data(), GL_STATIC_DRAW);
+      return data.size() * sizeof(T);
+    }
+    std::size_t bytes = 0;
+    for (const dirtyRange &r : ranges) {
+      glBufferSubData(target, r.first * sizeof(T), (r.end - r.first) * sizeof(T),
+		      data.data() + r.first);
+      bytes += (r.end - r.first) * sizeof(T);
+    }
+    return bytes;
+  }
+
+  /**
+   * Apply the watcher's reload, if one is waiting, to the
+   * buffers.  Parsing and diffing already happened on the
+   * watcher's thread; the material draw has its own layout
+   * and is rebuilt whole.
+   */
+  void meshtool::applyUpdate() {
+    meshUpdate u;
+    if (!m_watch->take(u)) {
+      return;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    std::size_t bytes = 0;
+    if (m_materials) {
+      m_materials->release();
+      m_materials->upload(*u.m, modelProgram.ID);
+      bytes = u.m->size() + u.m->elements.size() * sizeof(GLuint);
+    } else {
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      bytes += uploadRanges(GL_ARRAY_BUFFER, u.m->vertices, u.vertices, u.resizeVertices);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbe);
+      bytes += uploadRanges(GL_ELEMENT_ARRAY_BUFFER, u.m->elements, u.elements,
+			    u.resizeElements);
+      // Colours only when the viewer started with them, the
+      // program is chosen once
+      if (vbc && !u.m->colors.empty()) {
+	glBindBuffer(GL_ARRAY_BUFFER, vbc);
+	bytes += uploadRanges(GL_ARRAY_BUFFER, u.m->colors, u.colors, u.resizeColors);
+      }
+    }
+    double ms = std::chrono::duration<double, std::milli>
+      (std::chrono::high_resolution_clock::now() - start).count();
+    LOG("[Ok] Reloaded: "); LOG(u.m->vertices.size()); LOG(" vertices, ");
+    LOG(u.m->elements.size() / 3); LOG(" triangles, ");
+    LOG((u.resizeVertices ? std::string{"resized"} : std::to_string(u.vertices.size()) + " ranges"));
+    LOG(" / ");
+    LOG((u.resizeElements ? std::string{"resized"} : std::to_string(u.elements.size()) + " ranges"));
+    LOG(", "); LOG(bytes / 1024.0); LOG(" KB in "); LOG(ms); LOG(" ms after parse ");
+    LOG(u.parseMs); LOG(" ms, diff "); LOG(u.diffMs); LOG(" ms\n");
+  }
+
+  /**
+   * Swap, queueing a back buffer readback first when a
+   * screenshot or continuous capture wants this frame.  The
+   * pixel buffer ring is only created once something is
+   * captured.
+   */
+  void meshtool::present() {
+    if (screenshotPending || !capturePrefix.empty()) {
+      if (!capture) {
+	capture = new frameCapture;
+	capture->init(screen_width, screen_height);
+      }
+      char name[64];
+      if (screenshotPending) {
+	std::snprintf(name, sizeof(name), "screenshot_%04d.png", screenshots++);
+	LOG("[Ok] Screenshot: "); LOG(name); LOG("\n");
+	capture->request(name);
+	screenshotPending = false;
+      }
+      if (!capturePrefix.empty()) {
+	std::snprintf(name, sizeof(name), "_%05d.png", captureFrame++);
+	capture->request(capturePrefix + name);
+      }
+    }
+    if (capture) {
+      capture->poll();
+    }
     SDL_GL_SwapWindow(_window);
+    // Input to present latency: from the newest input event to
+    // the swap of the first frame that includes it
+    const frameState &state = frames.front();
+    if (state.inputSerial != shownSerial) {
+      shownSerial = state.inputSerial;
+      latencyMs += SDL_GetTicks() - state.inputTicks;
+      ++latencySamples;
+    }
   }
 
-  void meshtool::update() { /* Build vertex buffer once */
+  /**
+   * Simulation step on the input thread: advance the turntable
+   * by the time since the last step, then publish everything
+   * render() reads as one snapshot.
+   */
+  void meshtool::update() {
+    auto now = std::chrono::steady_clock::now();
+    float dt = lastUpdate.time_since_epoch().count() == 0 ? 0.0f
+      : std::chrono::duration<float>(now - lastUpdate).count();
+    lastUpdate = now;
+    angleY = std::fmod(angleY + 1.5f * dt, 2 * M_PI);
+    angleX = std::fmod(angleX + 0.97f * dt, 2 * M_PI);
+
+    frameState &state = frames.back();
+    state.angleX = angleX;
+    state.angleY = angleY;
+    state.angleZ = angleZ;
+    state.scale = scale;
+    state.screenshots = screenshotRequests;
+    state.inputSerial = inputSerial;
+    state.inputTicks = inputTicks;
+    frames.publish();
+  }
+
+  void meshtool::noteInput(uint32_t ticks) {
+    inputTicks = ticks;
+    ++inputSerial;
   }
 
+  /**
+   * GL work on its own thread: the context moves here, and a
+   * frame is drawn whenever update() has published a new
+   * snapshot, so a slow swap no longer holds up input.
+   */
+  void meshtool::renderLoop() {
+    SDL_GL_MakeCurrent(_window, _context);
+    while (_isRunning) {
+      if (!frames.pending()) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	continue;
+      }
+      render();
+    }
+    SDL_GL_MakeCurrent(_window, nullptr);
+  }
+
+  void meshtool::startRenderThread() {
+    threaded = true;
+    SDL_GL_MakeCurrent(_window, nullptr);
+    renderThread = std::thread(&meshtool::renderLoop, this);
+  }
+
+  void meshtool::stopRenderThread() {
+    _isRunning = false;
+    if (renderThread.joinable()) {
+      renderThread.join();
+    }
+    SDL_GL_MakeCurrent(_window, _context);
+  }
+
+  /**
+   * Drain the event queue.  With a render thread this waits a
+   * few milliseconds for the first event instead of spinning,
+   * which also paces update().
+   */
   void meshtool::handleEvents() {
     SDL_Event event;
     SDL_MouseButtonEvent *mev = 0;
     SDL_MouseMotionEvent *mmev = 0;
-    if (SDL_PollEvent(&event)) {
+    int got = threaded ? SDL_WaitEventTimeout(&event, 4) : SDL_PollEvent(&event);
+    for (; got; got = SDL_PollEvent(&event)) {
+      if (event.type == SDL_KEYDOWN) {
+	noteInput(event.key.timestamp);
+      }
       switch (event.type) {
       case SDL_QUIT:
 	_isRunning = false;
@@ -393,6 +1036,10 @@ namespace twg {
 	  scale -= 0.1f;
 	  if(scale < 0.1f) scale = 0.1f;
 	  break;
+	case 'p':
+	case SDLK_F12:
+	  ++screenshotRequests;
+	  break;
 	default:
 	  break;
 	}
@@ -405,7 +1052,36 @@ namespace twg {
 
   void meshtool::clean() {
     LOG("[Ok] Exiting and cleanup of utility...\n");
-    glDeleteBuffers(1, &vbo);
+    if (capture) {
+      capture->release();
+      LOG("[Ok] Captured "); LOG(capture->frames());
+      LOG(" frames, render thread ms/frame= "); LOG(capture->readbackMs()); LOG("\n");
+      delete capture;
+      capture = nullptr;
+    }
+    if (latencySamples > 0) {
+      LOG("[Ok] Input to present latency ms= "); LOG(latencyMs / latencySamples);
+      LOG(" over "); LOG(latencySamples); LOG(" inputs, ");
+      LOG((threaded ? "render thread\n" : "single thread\n"));
+    }
+    if (m_scene) {
+      m_scene->release();
+    } else if (m_points) {
+      m_points->release();
+    } else if (m_shared) {
+      m_shared->release();
+    } else if (m_sequence) {
+      m_sequence->release();
+    } else if (m_materials) {
+      m_materials->release();
+      delete m_materials;
+      m_materials = nullptr;
+    } else {
+      glDeleteBuffers(1, &vbo);
+      if (vbc) {
+	glDeleteBuffers(1, &vbc);
+      }
+    }
     glDeleteProgram(modelProgram.ID);
     SDL_GL_DeleteContext(_context);
     SDL_DestroyWindow(_window);
@@ -415,30 +1091,734 @@ namespace twg {
   }
 }
 
-int main(int argc, char **argv) {
-  std::string filename;
+static void usage()
+{
+  std::cout << "Usage: meshtool -f <mesh>.obj\n"
+	    << "       meshtool --scene <file>.scene\n"
+	    << "       meshtool --stress <count> [-f <mesh>.obj]\n"
+	    << "       meshtool --stats <mesh>.obj [<mesh>.obj ...]\n"
+	    << "       meshtool --voxelize <res> [--solid] -f <mesh>.obj -o <out>.svo|.vox\n"
+	    << "       meshtool --isosurface <vol>.raw --dims XxYxZ [--type u8|u16|f32]\n"
+	    << "                [--iso <value>] [--sdf] [--dc] [-o <out>.obj]\n"
+	    << "       meshtool --isosurface <tree>.svo [--dc] [-o <out>.obj]\n"
+	    << "       meshtool -f <mesh> [--weld <eps>] -o <out>.obj|.mshz|.stl|.ply|.glb\n"
+	    << "       meshtool --thumbnails <size> <mesh> [<mesh> ...] [-o <dir>]\n"
+	    << "       meshtool --turntable <frames> [--size WxH] -f <mesh> -o <prefix>\n"
+	    << "       meshtool --bench voxel|isosurface|weld|adjacency|codec|import|materials|\n"
+	    << "                subdivision|bake [<mesh>.obj ...]\n"
+	    << "       meshtool --batch mshz|stl|ply|glb|obj <mesh> [<mesh> ...] [--list <file>]\n"
+	    << "                -o <dir> [--manifest <file>]\n"
+	    << "       meshtool --daemon <socket> [--cache-mb <n>] [--max-clients <n>]\n"
+	    << "       meshtool --send <socket> convert <in> <out> | stats <in> |\n"
+	    << "                thumbnail <size> <in> <out>.png | status | ping | shutdown\n"
+	    << "Any mode that loads a mesh accepts --subdivide <levels> (Loop)\n"
+	    << "and --adaptive <pixels> to only split edges longer than that\n"
+	    << "on screen; weld split vertices first with --weld.\n"
+	    << "--bake mean|gaussian|ao [--rays <n>] colours the vertices by\n"
+	    << "curvature or ambient occlusion for the viewer, thumbnails and\n"
+	    << "as .obj vertex colours.\n"
+	    << "--batch writes <dir>/<name>.<ext> per input and records them in\n"
+	    << "a manifest (default <dir>/.meshtool-manifest): re-runs convert\n"
+	    << "only changed inputs and copy identical ones.\n"
+	    << "Files with vertices and no faces open as point clouds (--points\n"
+	    << "forces it for any format, using the mesh's vertices), drawing at\n"
+	    << "most --point-budget <n> points per frame from an octree cached\n"
+	    << "as <file>.octree.\n"
+	    << "--sequence <frame_0001.obj> plays it and the frames numbered\n"
+	    << "after it (or every file given) at --fps <n>, decoding --prefetch\n"
+	    << "<n> frames ahead and caching each as <frame>.mshz.\n"
+	    << "--watch reloads the viewer's -f file when it is rewritten,\n"
+	    << "uploading only the parts that changed.\n"
+	    << "--shm <name> views a mesh another process keeps in POSIX shared\n"
+	    << "memory (see sharedmesh.hpp), re-uploading what each commit\n"
+	    << "changed; --shm-publish <name> <mesh> serves one until interrupted.\n"
+	    << "Viewer modes accept --capture <prefix> to save every frame as\n"
+	    << "<prefix>_NNNNN.png; 'p' or F12 saves screenshot_NNNN.png.\n"
+	    << "They render on their own thread unless --single-thread is given,\n"
+	    << "-v prints the startup phase times.\n"
+	    << "Inputs may be .obj (plain, gzip or zstd compressed), .mshz,\n"
+	    << "binary .stl, binary .ply, .glb or .gltf;\n"
+	    << "viewer, --stats and --voxelize also accept --weld <eps>\n";
+  exit(1);
+}
+
+static std::string capturePrefix;
+static twg::subdivisionOptions subdivision{0}; // levels from --subdivide
+static twg::bakeKind bakeMode = twg::bakeKind::none;
+static int bakeRays = 64;
 
-  if (argc < 3) {
-    std::cout << "Usage: meshtool -f <mesh>.obj\n";
+static bool singleThread = false;
+static bool verbose = false;
+
+/**
+ * Input and simulation stay on this thread, GL moves to the
+ * render thread; --single-thread keeps the old lock step loop
+ * for comparing latency.
+ */
+static void runViewer(twg::meshtool &mt, std::function<bool()> load = {})
+{
+  mt.setCapture(capturePrefix);
+  mt.setSubdivision(subdivision.levels, subdivision.maxEdgePixels);
+  mt.setVerbose(verbose);
+  if (mt.init("meshtool converter and viewer", 25, 25, 800, 600,
+	      SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL, std::move(load)) != 0) {
+    SDL_Quit();
     exit(1);
+  }
+
+  if (singleThread) {
+    while (mt.isRunning()) {
+      mt.handleEvents();
+      mt.update();
+      mt.render();
+      std::this_thread::sleep_for(30ms);
+    }
   } else {
-    std::string token{argv[1]};
+    mt.startRenderThread();
+    while (mt.isRunning()) {
+      mt.handleEvents();
+      mt.update();
+    }
+    mt.stopRenderThread();
+  }
+  mt.clean();
+}
+
+static bool hasExtension(const std::string &filename, const std::string &ext)
+{
+  return filename.size() > ext.size()
+    && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+/**
+ * Decode filename by its format; false, after logging why,
+ * instead of exiting on a missing or malformed file, for the
+ * daemon, batch, thumbnails and the viewer's loaders.
+ */
+static bool readMesh(const std::string &filename, twg::mesh &m_mesh)
+{
+  switch (twg::detectFormat(filename)) {
+  case twg::meshFormat::mshz:
+    return twg::loadCompressed(filename, m_mesh);
+  case twg::meshFormat::stl:
+    return twg::loadStl(filename, m_mesh);
+  case twg::meshFormat::ply:
+    return twg::loadPly(filename, m_mesh);
+  case twg::meshFormat::gltf: {
+    twg::gltfAsset asset;
+    if (!asset.load(filename)) {
+      return false;
+    }
+    asset.toMesh(m_mesh);
+    return true;
+  }
+  default:
+    return twg::loadObject(filename, m_mesh);
+  }
+}
+
+/**
+ * Write m_mesh in the format output's extension names, .obj
+ * for anything else.
+ */
+static bool saveMesh(const twg::mesh &m_mesh, const std::string &output)
+{
+  if (hasExtension(output, ".mshz")) {
+    return twg::saveCompressed(m_mesh, output);
+  }
+  if (hasExtension(output, ".stl")) {
+    return twg::saveStl(m_mesh, output);
+  }
+  if (hasExtension(output, ".ply")) {
+    return twg::savePly(m_mesh, output);
+  }
+  if (hasExtension(output, ".glb")) {
+    return twg::saveGlb(m_mesh, output);
+  }
+  return twg::saveObject(m_mesh, output);
+}
+
+/**
+ * Weld vertices closer than weld when it is positive, then
+ * subdivide and bake.  Subdivision levels from --subdivide are
+ * applied here on the CPU, except for the viewer which streams
+ * the finest level into its buffers and passes no levels.
+ */
+static void prepareMesh(twg::mesh &m_mesh, float weld,
+			const twg::subdivisionOptions &refine = subdivision)
+{
+  if (weld > 0.0f) {
+    twg::weldStats ws = twg::weldVertices(m_mesh, weld);
+    twg::smoothNormals(m_mesh);
+    LOG("[Ok] Welded "); LOG(ws.verticesBefore); LOG(" -> ");
+    LOG(ws.verticesAfter); LOG(" vertices, "); LOG(ws.trianglesRemoved);
+    LOG(" triangles collapsed, "); LOG(ws.msPerMillion()); LOG(" ms per million\n");
+  }
+  if (refine.levels > 0) {
+    twg::subdivisionOptions options = refine;
+    if (options.maxEdgePixels > 0.0f && !m_mesh.vertices.empty()) {
+      // Fit the bounds to the view the way the offscreen renderer does
+      glm::vec3 lo{m_mesh.vertices[0].point}, hi{lo};
+      for (const twg::Vertex &v : m_mesh.vertices) {
+	lo = glm::min(lo, v.point);
+	hi = glm::max(hi, v.point);
+      }
+      float radius = std::max(0.5f * glm::length(hi - lo), 1e-6f);
+      options.viewProjection =
+	glm::perspective(glm::radians(45.0f), options.viewport.x / options.viewport.y,
+			 0.1f, 100.0f)
+	* glm::lookAt(glm::vec3(0.0f, 0.0f, 2.5f), glm::vec3(0.0f),
+		      glm::vec3(0.0f, 1.0f, 0.0f))
+	* glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / radius))
+	* glm::translate(glm::mat4(1.0f), -0.5f * (lo + hi));
+    }
+    twg::logSubdivision(twg::subdivide(m_mesh, options));
+  }
+  if (bakeMode != twg::bakeKind::none) {
+    twg::bakeStats bs = twg::bake(m_mesh, bakeMode, bakeRays);
+    LOG("[Ok] Baked "); LOG(m_mesh.vertices.size()); LOG(" vertices in ");
+    LOG(bs.bakeSeconds * 1e3); LOG(" ms after "); LOG(bs.buildSeconds * 1e3);
+    LOG(" ms build");
+    if (bs.rays > 0) {
+      LOG(", "); LOG(bs.raysPerSecond() * 1e-6); LOG(" Mrays/s");
+    }
+    LOG("\n");
+  }
+}
+
+/**
+ * Load an input mesh and prepare it, exiting when it cannot
+ * be read.
+ */
+static twg::mesh loadMesh(const std::string &filename, float weld,
+			  const twg::subdivisionOptions &refine = subdivision)
+{
+  twg::mesh m_mesh;
+  if (!readMesh(filename, m_mesh)) {
+    exit(1);
+  }
+  prepareMesh(m_mesh, weld, refine);
+  return m_mesh;
+}
+
+/**
+ * Headless batch: one size x size PNG per input from a single
+ * EGL context and program.  The next mesh loads on the thread
+ * pool while the current one renders, and PNG encoding runs
+ * there too.  Zero copy glTF files are uploaded straight from
+ * their mapping.
+ */
+struct thumbnailInput {
+  twg::gltfAsset asset;
+  twg::mesh m_mesh;
+  bool mapped = false;
+  bool ok = false;
+};
+
+static int runThumbnails(int size, const std::vector<std::string> &inputs,
+			 const std::string &dir, float weld)
+{
+  auto start = std::chrono::steady_clock::now();
+  twg::headlessContext context;
+  twg::offscreenRenderer renderer;
+  if (!context.init() || !renderer.init(size, size)) {
+    return 1;
+  }
+  double startupMs = std::chrono::duration<double, std::milli>
+    (std::chrono::steady_clock::now() - start).count();
+
+  // No two encode tasks may write one file: inputs that still
+  // share a name after outputNames are skipped
+  std::vector<std::string> names = twg::outputNames(dir, inputs, ".png");
+  std::vector<bool> skip(inputs.size(), false);
+  std::unordered_map<std::string, std::size_t> writers;
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    auto writer = writers.emplace(names[i], i);
+    if (!writer.second) {
+      LOG("[Error] "); LOG(inputs[i]); LOG(" and "); LOG(inputs[writer.first->second]);
+      LOG(" both map to "); LOG(names[i]); LOG(", skipped\n");
+      skip[i] = true;
+    }
+  }
+
+  twg::threadPool &pool = twg::threadPool::shared();
+  twg::taskGroup loading, encoding;
+  thumbnailInput current, next;
+  auto prefetch = [&](std::size_t i) {
+    if (i < inputs.size() && !skip[i]) {
+      pool.run(loading, [&, i] {
+	  next = thumbnailInput{};
+	  // Loaders log in pieces; keep this input's lines together
+	  std::ostringstream log;
+	  std::ostream *sink = twg::logSink;
+	  twg::logSink = &log;
+	  if (weld <= 0.0f && subdivision.levels == 0 && bakeMode == twg::bakeKind::none
+	      && twg::detectFormat(inputs[i]) == twg::meshFormat::gltf) {
+	    next.ok = next.mapped = next.asset.load(inputs[i]);
+	  } else if (readMesh(inputs[i], next.m_mesh)) {
+	    prepareMesh(next.m_mesh, weld);
+	    next.ok = true;
+	  }
+	  twg::logSink = sink;
+	  LOG(log.str());
+	});
+    }
+  };
+  std::size_t failed = 0;
+  std::atomic<std::size_t> unwritten{0};
+  prefetch(0);
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    pool.wait(loading);
+    std::swap(current, next);
+    prefetch(i + 1);
+    if (skip[i] || !current.ok) {
+      ++failed;
+      continue;
+    }
+    if (current.mapped) {
+      renderer.upload(current.asset.view());
+    } else {
+      renderer.upload(current.m_mesh);
+    }
+    renderer.render(glm::vec3(0.4f, 0.6f, 0.0f));
+    std::vector<uint8_t> pixels;
+    renderer.read(pixels);
+    pool.run(encoding, [&unwritten, name = names[i], size, pixels = std::move(pixels)] {
+	if (!twg::writePng(name, size, size, pixels)) {
+	  ++unwritten;
+	}
+      });
+  }
+  pool.wait(encoding);
+  failed += unwritten;
+  renderer.release();
+  context.release();
+
+  double seconds = std::chrono::duration<double>
+    (std::chrono::steady_clock::now() - start).count();
+  LOG("[Ok] "); LOG(inputs.size() - failed); LOG(" thumbnails in "); LOG(seconds);
+  LOG(" s, context and program startup "); LOG(startupMs); LOG(" ms");
+  if (failed > 0) {
+    LOG(", "); LOG(failed); LOG(" inputs failed");
+  }
+  LOG("\n");
+  return failed == 0 ? 0 : 1;
+}
+
+/**
+ * Offline turntable: frames evenly spaced turns about the
+ * vertical axis at a fixed size, independent of the clock.
+ * Readback goes through the capture ring and its bounded
+ * queue of pool encoders, so rendering overlaps compression.
+ */
+static int runTurntable(int frames, glm::ivec2 size, const std::string &filename,
+			const std::string &prefix, float weld)
+{
+  twg::mesh m_mesh = loadMesh(filename, weld);
+  twg::headlessContext context;
+  twg::offscreenRenderer renderer;
+  if (!context.init() || !renderer.init(size.x, size.y)) {
+    return 1;
+  }
+  renderer.upload(m_mesh);
+  twg::frameCapture capture;
+  capture.init(size.x, size.y);
+
+  auto start = std::chrono::steady_clock::now();
+  char name[32];
+  for (int i = 0; i < frames; ++i) {
+    float turn = 2.0f * static_cast<float>(M_PI) * i / frames;
+    renderer.render(glm::vec3(0.4f, turn, 0.0f));
+    std::snprintf(name, sizeof(name), "_%05d.png", i);
+    capture.request(prefix + name);
+    capture.poll();
+  }
+  capture.release();
+  double seconds = std::chrono::duration<double>
+    (std::chrono::steady_clock::now() - start).count();
+  renderer.release();
+  context.release();
+
+  LOG("[Ok] Turntable "); LOG(frames); LOG(" frames at "); LOG(size.x); LOG("x");
+  LOG(size.y); LOG(" in "); LOG(seconds); LOG(" s, "); LOG(frames / seconds);
+  LOG(" frames/s, render thread ms/frame= "); LOG(capture.readbackMs()); LOG("\n");
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> inputs;
+  std::string sceneFile;
+  std::size_t stress = 0;
+  bool stats = false;
+  std::string output;
+  std::string bench;
+  uint32_t voxelRes = 0;
+  bool solid = false;
+  std::string volume;
+  glm::ivec3 dims{0};
+  std::string type{"u8"};
+  float iso = 0.0f;
+  bool sdf = false;
+  bool dc = false;
+  float weld = 0.0f;
+  int thumbnails = 0;
+  int turntable = 0;
+  glm::ivec2 size{1920, 1080};
+  twg::daemonOptions daemon;
+  twg::batchOptions batch;
+  bool points = false;
+  std::size_t pointBudget = 5000000;
+  std::string sharedName;
+  bool sharedPublish = false;
+  bool watch = false;
+  bool sequence = false;
+  double fps = 24.0;
+  std::size_t prefetch = 8;
+
+  if (argc < 2) {
+    usage();
+  }
+  for (int i = 1; i < argc; ++i) {
+    std::string token{argv[i]};
+    auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+	usage();
+      }
+      return std::string{argv[++i]};
+    };
     if (token == "-f") {
-      filename = std::string{argv[2]};
-      LOG("[Ok] Opening file: ");
-      LOG(filename); LOG("\n");
-      twg::mesh m_mesh = twg::loadObject(filename);
-      twg::meshtool mt{&m_mesh};
-      mt.init("meshtool converter and viewer", 25, 25, 800, 600,
-              SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);
+      inputs.push_back(value());
+    } else if (token == "--scene") {
+      sceneFile = value();
+    } else if (token == "--stress") {
+      stress = std::stoul(value());
+    } else if (token == "--stats") {
+      stats = true;
+    } else if (token == "-o") {
+      output = value();
+    } else if (token == "--voxelize") {
+      voxelRes = std::stoul(value());
+    } else if (token == "--solid") {
+      solid = true;
+    } else if (token == "--bench") {
+      bench = value();
+    } else if (token == "--isosurface") {
+      volume = value();
+    } else if (token == "--dims") {
+      if (std::sscanf(value().c_str(), "%dx%dx%d", &dims.x, &dims.y, &dims.z) != 3) {
+	usage();
+      }
+    } else if (token == "--type") {
+      type = value();
+    } else if (token == "--iso") {
+      iso = std::stof(value());
+    } else if (token == "--sdf") {
+      sdf = true;
+    } else if (token == "--dc") {
+      dc = true;
+    } else if (token == "--weld") {
+      weld = std::stof(value());
+    } else if (token == "--thumbnails") {
+      thumbnails = std::stoi(value());
+    } else if (token == "--turntable") {
+      turntable = std::stoi(value());
+    } else if (token == "--size") {
+      if (std::sscanf(value().c_str(), "%dx%d", &size.x, &size.y) != 2
+	  || size.x <= 0 || size.y <= 0) {
+	usage();
+      }
+    } else if (token == "--capture") {
+      capturePrefix = value();
+    } else if (token == "--single-thread") {
+      singleThread = true;
+    } else if (token == "-v") {
+      verbose = true;
+    } else if (token == "--subdivide") {
+      subdivision.levels = std::stoi(value());
+    } else if (token == "--adaptive") {
+      subdivision.maxEdgePixels = std::stof(value());
+    } else if (token == "--bake") {
+      if (!twg::parseBakeKind(value(), bakeMode)) {
+	usage();
+      }
+    } else if (token == "--rays") {
+      bakeRays = std::stoi(value());
+    } else if (token == "--points") {
+      points = true;
+    } else if (token == "--point-budget") {
+      pointBudget = std::stoul(value());
+    } else if (token == "--sequence") {
+      sequence = true;
+    } else if (token == "--fps") {
+      fps = std::stod(value());
+      if (fps <= 0.0) {
+	usage();
+      }
+    } else if (token == "--prefetch") {
+      prefetch = std::max<std::size_t>(1, std::stoul(value()));
+    } else if (token == "--watch") {
+      watch = true;
+    } else if (token == "--shm") {
+      sharedName = value();
+    } else if (token == "--shm-publish") {
+      sharedName = value();
+      sharedPublish = true;
+    } else if (token == "--batch") {
+      batch.extension = value();
+      if (batch.extension[0] != '.') {
+	batch.extension = "." + batch.extension;
+      }
+    } else if (token == "--manifest") {
+      batch.manifest = value();
+    } else if (token == "--list") {
+      // One input path per line, for libraries too large for argv
+      std::ifstream list{value()};
+      for (std::string line; std::getline(list, line);) {
+	if (!line.empty()) {
+	  inputs.push_back(line);
+	}
+      }
+    } else if (token == "--daemon") {
+      daemon.socketPath = value();
+    } else if (token == "--cache-mb") {
+      daemon.cacheBytes = std::stoul(value()) << 20;
+    } else if (token == "--max-clients") {
+      daemon.maxClients = std::max(1ul, std::stoul(value()));
+    } else if (token == "--send") {
+      // Everything after the socket is the request line
+      std::string socket = value();
+      std::string request;
+      while (++i < argc) {
+	request += (request.empty() ? "" : " ") + std::string{argv[i]};
+      }
+      return twg::sendRequest(socket, request);
+    } else if (token[0] != '-') {
+      inputs.push_back(token);
+    } else {
+      usage();
+    }
+  }
+  std::string filename = inputs.empty() ? std::string{} : inputs.front();
+  subdivision.viewport = glm::vec2(thumbnails > 0 ? glm::ivec2(thumbnails) : size);
+
+  if (!bench.empty()) {
+    return twg::runBenchmark(bench, inputs);
+  }
+
+  if (!daemon.socketPath.empty()) {
+    daemon.load = readMesh;
+    daemon.save = saveMesh;
+    return twg::runDaemon(daemon);
+  }
 
-      while (mt.isRunning()) {
-        mt.handleEvents();
-        mt.update();
-        mt.render();
-        std::this_thread::sleep_for(30ms);
+  if (sharedPublish) {
+    if (inputs.size() != 1) {
+      usage();
+    }
+    return twg::runSharedPublisher(sharedName, loadMesh(filename, weld));
+  }
+
+  if (thumbnails > 0) {
+    if (inputs.empty()) {
+      usage();
+    }
+    return runThumbnails(thumbnails, inputs, output, weld);
+  }
+
+  if (turntable > 0) {
+    if (inputs.size() != 1 || output.empty()) {
+      usage();
+    }
+    return runTurntable(turntable, size, filename, output, weld);
+  }
+
+  if (voxelRes > 0) {
+    if (inputs.empty() || output.empty()) {
+      usage();
+    }
+    twg::mesh m_mesh = loadMesh(filename, weld);
+    auto start = std::chrono::steady_clock::now();
+    twg::sparseVoxelOctree tree = twg::voxelize(m_mesh, voxelRes,
+						solid ? twg::voxelMode::solid
+						: twg::voxelMode::surface);
+    double ms = std::chrono::duration<double, std::milli>
+      (std::chrono::steady_clock::now() - start).count();
+    LOG("[Ok] Voxelized "); LOG(filename); LOG(" at ");
+    LOG(tree.resolution); LOG("^3 in "); LOG(ms); LOG(" ms, "); LOG(tree.voxelCount()); LOG(" voxels\n");
+    bool vox = hasExtension(output, ".vox");
+    return (vox ? tree.saveVox(output) : tree.save(output)) ? 0 : 1;
+  }
+
+  if (!volume.empty()) {
+    twg::isoMethod method = dc ? twg::isoMethod::dualContouring
+      : twg::isoMethod::marchingCubes;
+    bool svo = hasExtension(volume, ".svo");
+    twg::mesh m_mesh;
+    auto start = std::chrono::steady_clock::now();
+    if (svo) {
+      twg::sparseVoxelOctree tree;
+      if (!tree.load(volume)) {
+	return 1;
+      }
+      start = std::chrono::steady_clock::now();
+      m_mesh = twg::extractIsosurface(tree, method);
+    } else {
+      twg::denseVolume v;
+      if (!v.loadRaw(volume, dims, type, sdf)) {
+	return 1;
       }
-      mt.clean();
+      start = std::chrono::steady_clock::now();
+      m_mesh = twg::extractIsosurface(v, iso, method);
+    }
+    double ms = std::chrono::duration<double, std::milli>
+      (std::chrono::steady_clock::now() - start).count();
+    LOG("[Ok] Extracted "); LOG(m_mesh.elements.size() / 3);
+    LOG(" triangles from "); LOG(volume); LOG(" in "); LOG(ms); LOG(" ms\n");
+    if (!output.empty()) {
+      return twg::saveObject(m_mesh, output) ? 0 : 1;
+    }
+    twg::meshtool mt{&m_mesh};
+    runViewer(mt);
+    return 0;
+  }
+
+  if (stats) {
+    // Headless: JSON on stdout, one object per input
+    if (inputs.empty()) {
+      usage();
+    }
+    if (inputs.size() > 1) {
+      std::cout << "[\n";
+    }
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+      twg::mesh m_mesh = loadMesh(inputs[i], weld);
+      std::cout << (inputs.size() > 1 ? "  " : "")
+		<< twg::statsJson(inputs[i], twg::computeStats(m_mesh))
+		<< (i + 1 < inputs.size() ? ",\n" : "\n");
     }
+    if (inputs.size() > 1) {
+      std::cout << "]\n";
+    }
+    return 0;
+  }
+
+  if (!batch.extension.empty()) {
+    if (inputs.empty() || output.empty()) {
+      usage();
+    }
+    std::ostringstream settings;
+    settings << batch.extension << " weld=" << weld << " subdivide=" << subdivision.levels
+	     << "/" << subdivision.maxEdgePixels << " bake=" << static_cast<int>(bakeMode)
+	     << "/" << bakeRays;
+    batch.dir = output;
+    batch.settings = settings.str();
+    batch.load = [weld](const std::string &filename, twg::mesh &m_mesh) {
+      if (!readMesh(filename, m_mesh)) {
+	return false;
+      }
+      prepareMesh(m_mesh, weld);
+      return true;
+    };
+    batch.save = saveMesh;
+    twg::batchStats bs = twg::convertBatch(inputs, batch);
+    LOG("[Ok] Batch of "); LOG(bs.inputs); LOG(": "); LOG(bs.converted); LOG(" converted, ");
+    LOG(bs.duplicates); LOG(" duplicates copied, "); LOG(bs.unchanged); LOG(" unchanged, ");
+    LOG(bs.touched); LOG(" touched, "); LOG(bs.failed); LOG(" failed (");
+    LOG(bs.unreadable); LOG(" unreadable); scan ");
+    LOG(bs.scanSeconds * 1e3); LOG(" ms hashing "); LOG(bs.hashedBytes / 1048576.0);
+    LOG(" MB, convert "); LOG(bs.convertSeconds * 1e3); LOG(" ms\n");
+    return bs.failed == 0 ? 0 : 1;
+  }
+
+  if (!output.empty()) {
+    // Converter: one input mesh to .obj, .mshz, .stl or .ply
+    if (inputs.size() != 1) {
+      usage();
+    }
+    twg::mesh m_mesh = loadMesh(filename, weld);
+    return saveMesh(m_mesh, output) ? 0 : 1;
+  }
+
+  // Viewer: the scene or mesh loads on the thread pool while
+  // init brings up the window and context
+  if (!sceneFile.empty() || stress > 0) {
+    twg::scene m_scene;
+    twg::meshtool mt{&m_scene};
+    runViewer(mt, [&] {
+	if (!sceneFile.empty()) {
+	  LOG("[Ok] Opening scene: ");
+	  LOG(sceneFile); LOG("\n");
+	  return twg::loadScene(sceneFile, m_scene);
+	}
+	return twg::stressScene(filename.empty() ? "meshes/suzanne.obj" : filename,
+				stress, m_scene);
+      });
+  } else if (sequence && !inputs.empty()) {
+    // One numbered frame names the rest; several are the sequence
+    std::vector<std::string> frames = inputs.size() == 1 ? twg::expandSequence(filename)
+      : inputs;
+    LOG("[Ok] Opening sequence: ");
+    LOG(frames.front()); LOG(" .. "); LOG(frames.back()); LOG("\n");
+    twg::meshSequence m_sequence;
+    m_sequence.fps = fps;
+    m_sequence.prefetch = prefetch;
+    twg::meshtool mt{&m_sequence};
+    runViewer(mt, [&] {
+	return m_sequence.open(frames, readMesh,
+			       [weld](twg::mesh &m) { prepareMesh(m, weld); });
+      });
+  } else if (!sharedName.empty()) {
+    // Another process's mesh, mapped rather than loaded
+    LOG("[Ok] Opening shared mesh: ");
+    LOG(sharedName); LOG("\n");
+    twg::sharedMesh m_shared;
+    twg::meshtool mt{&m_shared};
+    runViewer(mt, [&] {
+	return m_shared.open(sharedName) && m_shared.wait(10.0);
+      });
+  } else if (!filename.empty() && (points || twg::isVertexOnly(filename))) {
+    // Vertex only files: octree point cloud
+    LOG("[Ok] Opening point cloud: ");
+    LOG(filename); LOG("\n");
+    twg::pointCloud m_points;
+    m_points.pointBudget = pointBudget;
+    twg::meshtool mt{&m_points};
+    runViewer(mt, [&] {
+	return m_points.load(filename, readMesh);
+      });
+  } else if (!filename.empty()) {
+    LOG("[Ok] Opening file: ");
+    LOG(filename); LOG("\n");
+    // Baked colours are per vertex of the final mesh, and a
+    // watched file is diffed as drawn, so then the levels are
+    // applied on load instead of streamed
+    twg::subdivisionOptions onLoad = subdivision;
+    if (bakeMode == twg::bakeKind::none && !watch) {
+      onLoad.levels = 0;
+    } else {
+      subdivision.levels = 0;
+    }
+    twg::mesh m_mesh;
+    twg::meshtool mt{&m_mesh};
+    twg::meshWatcher watcher;
+    if (watch) {
+      mt.setWatch(&watcher);
+    }
+    runViewer(mt, [&, onLoad] {
+	if (!readMesh(filename, m_mesh)) {
+	  return false;
+	}
+	prepareMesh(m_mesh, weld, onLoad);
+	if (watch) {
+	  watcher.start(filename, m_mesh, [weld, onLoad](const std::string &name, twg::mesh &m) {
+	      if (!readMesh(name, m)) {
+		return false;
+	      }
+	      prepareMesh(m, weld, onLoad);
+	      return true;
+	    });
+	}
+	return true;
+      });
   }
 }
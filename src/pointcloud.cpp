@@ -0,0 +1,782 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <pointcloud.hpp>
+#include <formats.hpp>
+#include <stream.hpp>
+#include <voxel.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace twg {
+
+  static bool isCompressed(const mappedFile &file)
+  {
+    const uint8_t *p = file.data();
+    return file.size() >= 4
+      && ((p[0] == 0x1f && p[1] == 0x8b)
+	  || (p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd));
+  }
+
+  bool isVertexOnly(const std::string &filename)
+  {
+    if(detectFormat(filename) != meshFormat::obj)
+      {
+	return false;
+      }
+    mappedFile file{filename};
+    if(!file.good() || file.size() < 2 || isCompressed(file))
+      {
+	return false;
+      }
+    const char *text = reinterpret_cast<const char *>(file.data());
+    std::size_t size = file.size();
+    std::atomic<bool> faces{false}, vertices{false};
+    auto startsLine = [&](std::size_t at) {
+      if(at + 1 >= size)
+	{
+	  return;
+	}
+      bool space = text[at + 1] == ' ' || text[at + 1] == '\t';
+      if(space && text[at] == 'f')
+	{
+	  faces.store(true, std::memory_order_relaxed);
+	}
+      else if(space && text[at] == 'v')
+	{
+	  vertices.store(true, std::memory_order_relaxed);
+	}
+    };
+    startsLine(0);
+    parallelFor(0, size, [&](std::size_t lo, std::size_t hi, unsigned) {
+	const char *p = text + lo, *end = text + hi;
+	while(!faces.load(std::memory_order_relaxed)
+	      && (p = static_cast<const char *>(std::memchr(p, '\n', end - p))) != nullptr)
+	  {
+	    startsLine(static_cast<std::size_t>(++p - text));
+	  }
+      });
+    return vertices && !faces;
+  }
+
+  static uint32_t packColor(float r, float g, float b)
+  {
+    auto byte = [](float v) {
+      return static_cast<uint32_t>(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    return byte(r) | byte(g) << 8 | byte(b) << 16 | 0xff000000u;
+  }
+
+  /**
+   * "v x y z [r g b]" into out; colours above 1 are taken to
+   * be 0-255.  False for any other line.
+   */
+  static bool parseVertex(const char *p, const char *end, cloudPoint &out, bool &colored)
+  {
+    if(end - p < 2 || p[0] != 'v' || (p[1] != ' ' && p[1] != '\t'))
+      {
+	return false;
+      }
+    float v[6];
+    int n = 0;
+    for(++p; n < 6; ++n)
+      {
+	while(p < end && (*p == ' ' || *p == '\t'))
+	  {
+	    ++p;
+	  }
+	if(p >= end)
+	  {
+	    break;
+	  }
+	std::from_chars_result r = std::from_chars(p, end, v[n]);
+	if(r.ec != std::errc())
+	  {
+	    break;
+	  }
+	p = r.ptr;
+      }
+    if(n < 3)
+      {
+	return false;
+      }
+    out.point = glm::vec3(v[0], v[1], v[2]);
+    out.color = 0xffffffffu;
+    if(n == 6)
+      {
+	float k = v[3] > 1.0f || v[4] > 1.0f || v[5] > 1.0f ? 1.0f / 255.0f : 1.0f;
+	out.color = packColor(v[3] * k, v[4] * k, v[5] * k);
+	colored = true;
+      }
+    return true;
+  }
+
+  bool loadPoints(const std::string &filename, std::vector<cloudPoint> &points, bool &colored)
+  {
+    points.clear();
+    colored = false;
+    mappedFile file{filename};
+    if(!file.good())
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    cloudPoint pt;
+    if(isCompressed(file))
+      {
+	inputStream in{filename};
+	std::string line;
+	while(in.getline(line))
+	  {
+	    if(parseVertex(line.data(), line.data() + line.size(), pt, colored))
+	      {
+		points.push_back(pt);
+	      }
+	  }
+	return !in.failed();
+      }
+
+    // Chunks end on line breaks; several per worker so uneven
+    // line mixes still balance
+    const char *text = reinterpret_cast<const char *>(file.data());
+    std::size_t size = file.size();
+    std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(workerCount() * 4, size >> 16));
+    std::vector<std::size_t> bounds(chunks + 1, size);
+    bounds[0] = 0;
+    for(std::size_t c = 1; c < chunks; ++c)
+      {
+	std::size_t at = std::max(bounds[c - 1], c * (size / chunks));
+	const void *nl = std::memchr(text + at, '\n', size - at);
+	bounds[c] = nl ? static_cast<const char *>(nl) - text + 1 : size;
+      }
+    std::vector<std::vector<cloudPoint>> parts(chunks);
+    std::unique_ptr<bool[]> partColored(new bool[chunks]());
+    parallelFor(0, chunks, [&](std::size_t lo, std::size_t hi, unsigned) {
+	cloudPoint p;
+	for(std::size_t c = lo; c < hi; ++c)
+	  {
+	    const char *line = text + bounds[c], *end = text + bounds[c + 1];
+	    parts[c].reserve((end - line) / 24);
+	    while(line < end)
+	      {
+		const char *nl = static_cast<const char *>(std::memchr(line, '\n', end - line));
+		const char *stop = nl ? nl : end;
+		if(parseVertex(line, stop, p, partColored[c]))
+		  {
+		    parts[c].push_back(p);
+		  }
+		line = stop + 1;
+	      }
+	  }
+      });
+    std::vector<std::size_t> offsets(chunks + 1, 0);
+    for(std::size_t c = 0; c < chunks; ++c)
+      {
+	offsets[c + 1] = offsets[c] + parts[c].size();
+	colored = colored || partColored[c];
+      }
+    points.resize(offsets[chunks]);
+    parallelFor(0, chunks, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t c = lo; c < hi; ++c)
+	  {
+	    std::copy(parts[c].begin(), parts[c].end(), points.begin() + offsets[c]);
+	    std::vector<cloudPoint>().swap(parts[c]);
+	  }
+      });
+    return true;
+  }
+
+  static constexpr int mortonLevels = 21;
+
+  /**
+   * Splits nodes over Morton sorted (key, point) pairs.  Nodes
+   * live in a deque so their addresses stay put while tasks
+   * for other subtrees add nodes.
+   */
+  struct octreeBuilder {
+    std::vector<std::pair<uint64_t, uint32_t>> &keys;
+    std::deque<octreeNode> nodes;
+    std::mutex lock;
+    taskGroup group;
+
+    uint32_t add(const octreeNode &n, octreeNode *&at)
+    {
+      std::lock_guard<std::mutex> guard{lock};
+      nodes.push_back(n);
+      at = &nodes.back();
+      return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void split(octreeNode *node, std::size_t lo, std::size_t hi)
+    {
+      node->begin = lo;
+      node->count = static_cast<uint32_t>(hi - lo);
+      if(hi - lo <= pointCloud::leafPoints || node->depth >= pointCloud::maxDepth)
+	{
+	  return;
+	}
+      // Keep the first point of every grid cell; cells are key
+      // prefixes, so that is every change of prefix
+      int shift = 3 * (mortonLevels - static_cast<int>(node->depth) - pointCloud::gridLevels);
+      std::vector<std::pair<uint64_t, uint32_t>> rest;
+      rest.reserve(hi - lo);
+      std::size_t kept = lo;
+      uint64_t previous = ~0ull;
+      for(std::size_t i = lo; i < hi; ++i)
+	{
+	  uint64_t cell = keys[i].first >> shift;
+	  if(cell != previous)
+	    {
+	      keys[kept++] = keys[i];
+	      previous = cell;
+	    }
+	  else
+	    {
+	      rest.push_back(keys[i]);
+	    }
+	}
+      std::copy(rest.begin(), rest.end(), keys.begin() + kept);
+      std::vector<std::pair<uint64_t, uint32_t>>().swap(rest);
+      node->count = static_cast<uint32_t>(kept - lo);
+
+      // The rest is still sorted, so each octant is a run
+      int childShift = 3 * (mortonLevels - static_cast<int>(node->depth) - 1);
+      float half = 0.5f * node->size;
+      std::size_t start = kept;
+      for(unsigned octant = 0; octant < 8 && start < hi; ++octant)
+	{
+	  std::size_t end = std::partition_point(keys.begin() + start, keys.begin() + hi,
+						 [&](const std::pair<uint64_t, uint32_t> &k) {
+						   return ((k.first >> childShift) & 7) <= octant;
+						 }) - keys.begin();
+	  if(end == start)
+	    {
+	      continue;
+	    }
+	  octreeNode child;
+	  child.depth = node->depth + 1;
+	  child.size = half;
+	  child.lo = node->lo + half * glm::vec3(octant & 1, octant >> 1 & 1, octant >> 2 & 1);
+	  octreeNode *at;
+	  node->children[octant] = static_cast<int32_t>(add(child, at));
+	  if(end - start > 200000)
+	    {
+	      threadPool::shared().run(group, [this, at, start, end] { split(at, start, end); });
+	    }
+	  else
+	    {
+	      split(at, start, end);
+	    }
+	  start = end;
+	}
+    }
+  };
+
+  void pointCloud::build(std::vector<cloudPoint> &&input, bool colored)
+  {
+    unmap();
+    std::size_t n = input.size();
+    using bounds = std::pair<glm::vec3, glm::vec3>;
+    bounds box = parallelReduce(0, n, bounds{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)},
+				[&](std::size_t lo, std::size_t hi) {
+				  bounds b{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+				  for(std::size_t i = lo; i < hi; ++i)
+				    {
+				      b.first = glm::min(b.first, input[i].point);
+				      b.second = glm::max(b.second, input[i].point);
+				    }
+				  return b;
+				},
+				[](const bounds &a, const bounds &b) {
+				  return bounds{glm::min(a.first, b.first), glm::max(a.second, b.second)};
+				});
+    boundsMin = n ? box.first : glm::vec3(0.0f);
+    boundsMax = n ? box.second : glm::vec3(0.0f);
+    glm::vec3 extent = boundsMax - boundsMin;
+    float size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) * 1.0001f;
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(n);
+    float cells = static_cast<float>(1 << mortonLevels);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    glm::vec3 q = glm::min((input[i].point - boundsMin) / size * cells, glm::vec3(cells - 1.0f));
+	    keys[i].first = mortonKey(static_cast<uint32_t>(q.x), static_cast<uint32_t>(q.y),
+				      static_cast<uint32_t>(q.z));
+	    keys[i].second = static_cast<uint32_t>(i);
+	    if(!colored)
+	      {
+		// Height ramp, blue low to warm high
+		float t = extent.y > 0.0f ? (input[i].point.y - boundsMin.y) / extent.y : 0.5f;
+		input[i].color = packColor(0.2f + 0.75f * t, 0.35f + 0.4f * (1.0f - std::fabs(2.0f * t - 1.0f)),
+					   0.9f - 0.7f * t);
+	      }
+	  }
+      });
+    radixSort(keys, 3 * mortonLevels);
+
+    octreeBuilder builder{keys, {}, {}, {}};
+    octreeNode root;
+    root.lo = boundsMin;
+    root.size = size;
+    octreeNode *at;
+    builder.add(root, at);
+    if(n > 0)
+      {
+	builder.split(at, 0, n);
+      }
+    threadPool::shared().wait(builder.group);
+    tree.assign(builder.nodes.begin(), builder.nodes.end());
+
+    storage.resize(n);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    storage[i] = input[keys[i].second];
+	  }
+      });
+    std::vector<cloudPoint>().swap(input);
+    data = storage.data();
+    count = n;
+    state.reset(new std::atomic<uint8_t>[tree.size()]);
+    for(std::size_t i = 0; i < tree.size(); ++i)
+      {
+	state[i].store(ready, std::memory_order_relaxed);
+      }
+  }
+
+  struct octreeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint64_t pointCount;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t pointsOffset;     // page aligned
+  };
+
+  static const char octreeMagic[8] = {'M', 'T', 'O', 'C', 'T', 'R', 'E', 'E'};
+  static const uint32_t octreeVersion = 1;
+
+  bool pointCloud::save(const std::string &filename, uint64_t sourceSize, int64_t sourceMtime) const
+  {
+    octreeHeader header{};
+    std::memcpy(header.magic, octreeMagic, sizeof(octreeMagic));
+    header.version = octreeVersion;
+    header.nodeCount = static_cast<uint32_t>(tree.size());
+    header.pointCount = count;
+    header.sourceSize = sourceSize;
+    header.sourceMtime = sourceMtime;
+    std::memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+    std::memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+    std::size_t head = sizeof(header) + tree.size() * sizeof(octreeNode);
+    header.pointsOffset = (head + 4095) & ~std::size_t(4095);
+
+    std::string temporary = filename + ".tmp";
+    std::FILE *out = std::fopen(temporary.c_str(), "wb");
+    if(!out)
+      {
+	LOG("[Error] Cannot open: "); LOG(temporary); LOG("\n");
+	return false;
+      }
+    std::vector<char> padding(header.pointsOffset - head, 0);
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1
+      && std::fwrite(tree.data(), sizeof(octreeNode), tree.size(), out) == tree.size()
+      && std::fwrite(padding.data(), 1, padding.size(), out) == padding.size()
+      && std::fwrite(data, sizeof(cloudPoint), count, out) == count;
+    ok = std::fclose(out) == 0 && ok;
+    if(!ok || std::rename(temporary.c_str(), filename.c_str()) != 0)
+      {
+	LOG("[Error] Failed writing: "); LOG(filename); LOG("\n");
+	std::remove(temporary.c_str());
+	return false;
+      }
+    return true;
+  }
+
+  /**
+   * Map a cache file written by save() for the same source.
+   * Only the header and nodes are read here; point pages are
+   * left for the OS to bring in as nodes get drawn.
+   */
+  /**
+   * Nodes from a cache file: point runs inside the points, and
+   * every child after its parent and claimed by one parent, so
+   * walking the tree reads nothing outside it and ends.
+   */
+  static bool validTree(const octreeNode *nodes, std::size_t nodeCount, uint64_t pointCount)
+  {
+    std::vector<char> claimed(nodeCount, 0);
+    for(std::size_t i = 0; i < nodeCount; ++i)
+      {
+	const octreeNode &n = nodes[i];
+	if(n.begin > pointCount || n.count > pointCount - n.begin)
+	  {
+	    return false;
+	  }
+	for(int32_t child : n.children)
+	  {
+	    if(child < 0)
+	      {
+		continue;
+	      }
+	    if(std::size_t(child) <= i || std::size_t(child) >= nodeCount || claimed[child])
+	      {
+		return false;
+	      }
+	    claimed[child] = 1;
+	  }
+      }
+    return true;
+  }
+
+  bool pointCloud::open(const std::string &filename, uint64_t sourceSize, int64_t sourceMtime)
+  {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      {
+	return false;
+      }
+    struct stat info;
+    void *p = MAP_FAILED;
+    std::size_t length = 0;
+    if(::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(octreeHeader))
+      {
+	length = static_cast<std::size_t>(info.st_size);
+	p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+      }
+    ::close(fd);
+    if(p == MAP_FAILED)
+      {
+	return false;
+      }
+    ::madvise(p, length, MADV_RANDOM);
+    octreeHeader header;
+    std::memcpy(&header, p, sizeof(header));
+    const uint8_t *bytes = static_cast<const uint8_t *>(p);
+    const octreeNode *nodes = reinterpret_cast<const octreeNode *>(bytes + sizeof(header));
+    // A cache that does not hold together is rebuilt like a stale one
+    bool valid = std::memcmp(header.magic, octreeMagic, sizeof(octreeMagic)) == 0
+      && header.version == octreeVersion
+      && header.sourceSize == sourceSize && header.sourceMtime == sourceMtime
+      && header.pointsOffset >= sizeof(header) + std::size_t(header.nodeCount) * sizeof(octreeNode)
+      && header.pointsOffset <= length
+      && header.pointCount <= (length - header.pointsOffset) / sizeof(cloudPoint)
+      && validTree(nodes, header.nodeCount, header.pointCount);
+    if(!valid)
+      {
+	::munmap(p, length);
+	return false;
+      }
+    unmap();
+    storage.clear();
+    mapping = p;
+    mappingLength = length;
+    tree.assign(nodes, nodes + header.nodeCount);
+    data = reinterpret_cast<const cloudPoint *>(bytes + header.pointsOffset);
+    count = header.pointCount;
+    std::memcpy(&boundsMin, header.boundsMin, sizeof(header.boundsMin));
+    std::memcpy(&boundsMax, header.boundsMax, sizeof(header.boundsMax));
+    state.reset(new std::atomic<uint8_t>[tree.size()]);
+    for(std::size_t i = 0; i < tree.size(); ++i)
+      {
+	state[i].store(paged, std::memory_order_relaxed);
+      }
+    return true;
+  }
+
+  void pointCloud::unmap()
+  {
+    threadPool::shared().wait(paging);
+    if(mapping)
+      {
+	::munmap(mapping, mappingLength);
+	mapping = nullptr;
+	mappingLength = 0;
+      }
+  }
+
+  pointCloud::~pointCloud()
+  {
+    unmap();
+  }
+
+  // Vertices of a decoded mesh, with its baked colours if any
+  static void meshPoints(const mesh &m, std::vector<cloudPoint> &points, bool &colored)
+  {
+    colored = !m.colors.empty() && m.colors.size() == m.vertices.size();
+    points.resize(m.vertices.size());
+    parallelFor(0, points.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    points[i].point = m.vertices[i].point;
+	    points[i].color = colored ? packColor(m.colors[i].r, m.colors[i].g, m.colors[i].b)
+	      : 0xffffffffu;
+	  }
+      });
+  }
+
+  bool pointCloud::load(const std::string &filename, const loader &meshLoader)
+  {
+    struct stat info;
+    if(::stat(filename.c_str(), &info) != 0)
+      {
+	LOG("[Error] Not able to open: "); LOG(filename); LOG("\n");
+	return false;
+      }
+    uint64_t size = static_cast<uint64_t>(info.st_size);
+    int64_t mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    std::string cache = filename + ".octree";
+    auto start = std::chrono::steady_clock::now();
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+      return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+    if(open(cache, size, mtime))
+      {
+	LOG("[Ok] Mapped "); LOG(count); LOG(" points in "); LOG(tree.size());
+	LOG(" octree nodes from "); LOG(cache); LOG(" in "); LOG(ms(start)); LOG(" ms\n");
+	return true;
+      }
+
+    std::vector<cloudPoint> input;
+    bool colored;
+    if(meshLoader && detectFormat(filename) != meshFormat::obj)
+      {
+	mesh m;
+	if(!meshLoader(filename, m))
+	  {
+	    return false;
+	  }
+	meshPoints(m, input, colored);
+      }
+    else if(!loadPoints(filename, input, colored))
+      {
+	return false;
+      }
+    if(input.empty())
+      {
+	LOG("[Error] No points in "); LOG(filename); LOG("\n");
+	return false;
+      }
+    if(input.size() > UINT32_MAX)
+      {
+	LOG("[Error] More than 2^32 points in "); LOG(filename); LOG("\n");
+	return false;
+      }
+    double readMs = ms(start);
+    auto building = std::chrono::steady_clock::now();
+    build(std::move(input), colored);
+    uint32_t depth = 0;
+    for(const octreeNode &n : tree)
+      {
+	depth = std::max(depth, n.depth);
+      }
+    LOG("[Ok] Read "); LOG(count); LOG(" points in "); LOG(readMs); LOG(" ms, octree of ");
+    LOG(tree.size()); LOG(" nodes, depth "); LOG(depth); LOG(" in "); LOG(ms(building)); LOG(" ms\n");
+    if(save(cache, size, mtime))
+      {
+	LOG("[Ok] Wrote "); LOG(cache); LOG("\n");
+      }
+    return true;
+  }
+
+  void pointCloud::select(const glm::mat4 &modelView, const glm::mat4 &mvp, float pixelScale,
+			  std::vector<uint32_t> &out) const
+  {
+    out.clear();
+    if(tree.empty())
+      {
+	return;
+      }
+    // Frustum planes in model space (Gribb and Hartmann)
+    glm::vec4 planes[6];
+    glm::vec4 row[4];
+    for(int i = 0; i < 4; ++i)
+      {
+	row[i] = glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+      }
+    for(int i = 0; i < 3; ++i)
+      {
+	planes[2 * i] = row[3] + row[i];
+	planes[2 * i + 1] = row[3] - row[i];
+      }
+    float viewScale = glm::length(glm::vec3(modelView[0]));
+
+    // Projected radius in pixels, FLT_MAX around the camera;
+    // false when outside the frustum
+    auto weigh = [&](const octreeNode &n, float &weight) {
+      glm::vec3 center = n.lo + 0.5f * n.size;
+      float radius = 0.8660254f * n.size;
+      for(const glm::vec4 &p : planes)
+	{
+	  if(glm::dot(glm::vec3(p), center) + p.w < -radius * glm::length(glm::vec3(p)))
+	    {
+	      return false;
+	    }
+	}
+      float depth = -(modelView * glm::vec4(center, 1.0f)).z;
+      float r = radius * viewScale;
+      weight = depth > r ? r * pixelScale / depth : FLT_MAX;
+      return true;
+    };
+
+    // Largest on screen first; children only once their parent
+    // is in, and only while their spacing still shows on screen
+    std::priority_queue<std::pair<float, uint32_t>> queue;
+    float weight;
+    if(weigh(tree[0], weight))
+      {
+	queue.emplace(weight, 0);
+      }
+    std::size_t points = 0;
+    while(!queue.empty())
+      {
+	uint32_t index = queue.top().second;
+	queue.pop();
+	const octreeNode &n = tree[index];
+	if(points + n.count > pointBudget)
+	  {
+	    break;
+	  }
+	points += n.count;
+	out.push_back(index);
+	for(int32_t child : n.children)
+	  {
+	    if(child >= 0 && weigh(tree[child], weight) && weight >= minNodePixels)
+	      {
+		queue.emplace(weight, static_cast<uint32_t>(child));
+	      }
+	  }
+      }
+  }
+
+  void pointCloud::upload(GLuint program)
+  {
+    spacingLoc = glGetUniformLocation(program, "spacing");
+    pixelScaleLoc = glGetUniformLocation(program, "pixelScale");
+    buffers.assign(tree.size(), nodeBuffer{});
+    glEnable(GL_PROGRAM_POINT_SIZE);
+  }
+
+  pointFrameStats pointCloud::draw(const glm::mat4 &modelView, const glm::mat4 &mvp, float pixelScale)
+  {
+    pointFrameStats stats;
+    ++frame;
+    select(modelView, mvp, pixelScale, visible);
+    glUniform1f(pixelScaleLoc, pixelScale);
+    threadPool &pool = threadPool::shared();
+    std::size_t uploaded = 0;
+    for(uint32_t index : visible)
+      {
+	const octreeNode &n = tree[index];
+	nodeBuffer &b = buffers[index];
+	if(!b.vbo)
+	  {
+	    uint8_t s = state[index].load(std::memory_order_acquire);
+	    if(s == paged)
+	      {
+		// Fault the node's pages in off the render thread
+		state[index].store(fetching, std::memory_order_relaxed);
+		pool.run(paging, [this, index] {
+		    const octreeNode &node = tree[index];
+		    const uint8_t *first = reinterpret_cast<const uint8_t *>(data + node.begin);
+		    std::size_t bytes = node.count * sizeof(cloudPoint);
+		    uintptr_t page = reinterpret_cast<uintptr_t>(first) & ~uintptr_t(4095);
+		    ::madvise(reinterpret_cast<void *>(page),
+			      reinterpret_cast<uintptr_t>(first) + bytes - page, MADV_WILLNEED);
+		    uint8_t sum = 0;
+		    for(std::size_t at = 0; at < bytes; at += 4096)
+		      {
+			sum += reinterpret_cast<const volatile uint8_t *>(first)[at];
+		      }
+		    (void)sum;
+		    state[index].store(ready, std::memory_order_release);
+		  });
+	      }
+	    if(s != ready || uploaded >= uploadPerFrame)
+	      {
+		continue;
+	      }
+	    glGenVertexArrays(1, &b.vao);
+	    glBindVertexArray(b.vao);
+	    glGenBuffers(1, &b.vbo);
+	    glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+	    glBufferData(GL_ARRAY_BUFFER, n.count * sizeof(cloudPoint), data + n.begin,
+			 GL_STATIC_DRAW);
+	    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(cloudPoint),
+				  reinterpret_cast<void *>(offsetof(cloudPoint, point)));
+	    glEnableVertexAttribArray(0);
+	    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(cloudPoint),
+				  reinterpret_cast<void *>(offsetof(cloudPoint, color)));
+	    glEnableVertexAttribArray(1);
+	    resident.push_back(index);
+	    residentPoints += n.count;
+	    uploaded += n.count;
+	    ++stats.uploads;
+	  }
+	b.lastDrawn = frame;
+	glBindVertexArray(b.vao);
+	glUniform1f(spacingLoc, spacing(n));
+	glDrawArrays(GL_POINTS, 0, n.count);
+	++stats.nodes;
+	stats.points += n.count;
+      }
+
+    // Drop the least recently drawn past twice the budget
+    if(residentPoints > 2 * pointBudget)
+      {
+	std::sort(resident.begin(), resident.end(), [this](uint32_t a, uint32_t b) {
+	    return buffers[a].lastDrawn < buffers[b].lastDrawn;
+	  });
+	std::size_t dropped = 0;
+	for(; dropped < resident.size() && residentPoints > 2 * pointBudget
+	      && buffers[resident[dropped]].lastDrawn < frame; ++dropped)
+	  {
+	    uint32_t index = resident[dropped];
+	    glDeleteBuffers(1, &buffers[index].vbo);
+	    glDeleteVertexArrays(1, &buffers[index].vao);
+	    buffers[index] = nodeBuffer{};
+	    residentPoints -= tree[index].count;
+	    if(mapping)
+	      {
+		state[index].store(paged, std::memory_order_relaxed);
+	      }
+	  }
+	resident.erase(resident.begin(), resident.begin() + dropped);
+      }
+    stats.residentPoints = residentPoints;
+    return stats;
+  }
+
+  void pointCloud::release()
+  {
+    threadPool::shared().wait(paging);
+    for(uint32_t index : resident)
+      {
+	glDeleteBuffers(1, &buffers[index].vbo);
+	glDeleteVertexArrays(1, &buffers[index].vao);
+      }
+    resident.clear();
+    buffers.clear();
+    residentPoints = 0;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,308 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <scene.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+
+namespace twg {
+
+  /**
+   * Load a mesh file unless the same path was already added,
+   * returns the index of the mesh in the scene.
+   */
+  int scene::addMesh(const std::string &filename)
+  {
+    auto it = std::find(files.begin(), files.end(), filename);
+    if(it != files.end())
+      {
+	return static_cast<int>(it - files.begin());
+      }
+    mesh m;
+    if(!loadObject(filename, m))
+      {
+	return -1;
+      }
+    files.push_back(filename);
+    meshes.push_back(std::move(m));
+    instances.emplace_back();
+    return static_cast<int>(files.size() - 1);
+  }
+
+  void scene::addInstance(int meshIndex, const glm::mat4 &transform)
+  {
+    instances[meshIndex].push_back(transform);
+  }
+
+  std::size_t scene::instanceCount() const
+  {
+    std::size_t count = 0;
+    for(const auto &list : instances)
+      {
+	count += list.size();
+      }
+    return count;
+  }
+
+  /**
+   * World space bounds of all instances, from the eight
+   * transformed corners of each mesh's local bounding box.
+   */
+  void scene::computeBounds()
+  {
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for(std::size_t m = 0; m < meshes.size(); ++m)
+      {
+	if(meshes[m].vertices.empty())
+	  {
+	    continue;
+	  }
+	glm::vec3 lo{meshes[m].vertices[0].point};
+	glm::vec3 hi{lo};
+	for(const Vertex &v : meshes[m].vertices)
+	  {
+	    lo = glm::min(lo, v.point);
+	    hi = glm::max(hi, v.point);
+	  }
+	for(const glm::mat4 &t : instances[m])
+	  {
+	    for(int c = 0; c < 8; ++c)
+	      {
+		glm::vec4 corner{(c & 1) ? hi.x : lo.x,
+				 (c & 2) ? hi.y : lo.y,
+				 (c & 4) ? hi.z : lo.z, 1.0f};
+		glm::vec3 p{t * corner};
+		boundsMin = glm::min(boundsMin, p);
+		boundsMax = glm::max(boundsMax, p);
+	      }
+	  }
+      }
+    if(boundsMin.x > boundsMax.x)
+      {
+	boundsMin = boundsMax = glm::vec3(0.0f);
+      }
+  }
+
+  /**
+   * Create one VAO per unique mesh and a single instance buffer
+   * holding every transform, grouped per batch.  The instance
+   * transform is a mat4 attribute spread over four consecutive
+   * locations with a divisor of one.
+   */
+  void scene::upload(GLuint program)
+  {
+    GLint posLoc = glGetAttribLocation(program, "vPos");
+    GLint normalLoc = glGetAttribLocation(program, "vNormal");
+    GLint instLoc = glGetAttribLocation(program, "iM");
+
+    batches.clear();
+    for(std::size_t m = 0; m < meshes.size(); ++m)
+      {
+	if(!instances[m].empty() && !meshes[m].elements.empty())
+	  {
+	    batches.push_back(drawBatch{program, static_cast<int>(m), 0,
+		  static_cast<GLsizei>(instances[m].size())});
+	  }
+      }
+    std::sort(batches.begin(), batches.end(),
+	      [](const drawBatch &a, const drawBatch &b) {
+		return a.program != b.program ? a.program < b.program
+		  : a.meshIndex < b.meshIndex;
+	      });
+
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(instanceCount());
+    for(drawBatch &batch : batches)
+      {
+	batch.firstInstance = static_cast<GLuint>(transforms.size());
+	const auto &list = instances[batch.meshIndex];
+	transforms.insert(transforms.end(), list.begin(), list.end());
+      }
+
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(glm::mat4),
+		 transforms.data(), GL_STATIC_DRAW);
+
+    vaos.assign(meshes.size(), 0);
+    vbos.assign(meshes.size(), 0);
+    ibos.assign(meshes.size(), 0);
+    for(const drawBatch &batch : batches)
+      {
+	int m = batch.meshIndex;
+	glGenVertexArrays(1, &vaos[m]);
+	glBindVertexArray(vaos[m]);
+
+	glGenBuffers(1, &vbos[m]);
+	glBindBuffer(GL_ARRAY_BUFFER, vbos[m]);
+	glBufferData(GL_ARRAY_BUFFER, meshes[m].size(),
+		     &meshes[m].vertices[0], GL_STATIC_DRAW);
+	glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			      reinterpret_cast<void *>(offsetof(Vertex, point)));
+	glEnableVertexAttribArray(posLoc);
+	glVertexAttribPointer(normalLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			      reinterpret_cast<void *>(offsetof(Vertex, normal)));
+	glEnableVertexAttribArray(normalLoc);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	std::size_t base = batch.firstInstance * sizeof(glm::mat4);
+	for(int col = 0; col < 4; ++col)
+	  {
+	    glVertexAttribPointer(instLoc + col, 4, GL_FLOAT, GL_FALSE,
+				  sizeof(glm::mat4),
+				  reinterpret_cast<void *>
+				  (base + col * sizeof(glm::vec4)));
+	    glEnableVertexAttribArray(instLoc + col);
+	    glVertexAttribDivisor(instLoc + col, 1);
+	  }
+
+	glGenBuffers(1, &ibos[m]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibos[m]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		     meshes[m].elements.size() * sizeof(GLuint),
+		     &meshes[m].elements[0], GL_STATIC_DRAW);
+      }
+    glBindVertexArray(0);
+
+    LOG("[Ok] Scene uploaded: "); LOG(meshes.size()); LOG(" meshes, ");
+    LOG(transforms.size()); LOG(" instances, ");
+    LOG(batches.size()); LOG(" draws\n");
+  }
+
+  /**
+   * Submit every batch, switching program only between
+   * batches of different programs.  Returns the draw count.
+   */
+  int scene::draw() const
+  {
+    GLuint current = 0;
+    for(const drawBatch &batch : batches)
+      {
+	if(batch.program != current)
+	  {
+	    glUseProgram(batch.program);
+	    current = batch.program;
+	  }
+	glBindVertexArray(vaos[batch.meshIndex]);
+	glDrawElementsInstanced(GL_TRIANGLES,
+				meshes[batch.meshIndex].elements.size(),
+				GL_UNSIGNED_INT, 0, batch.instanceCount);
+      }
+    return static_cast<int>(batches.size());
+  }
+
+  void scene::release()
+  {
+    glDeleteBuffers(vbos.size(), vbos.data());
+    glDeleteBuffers(ibos.size(), ibos.data());
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteVertexArrays(vaos.size(), vaos.data());
+    vaos.clear(); vbos.clear(); ibos.clear();
+    instanceBuffer = 0;
+  }
+
+  static glm::mat4 instanceTransform(glm::vec3 t, glm::vec3 r, float s)
+  {
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), t)
+      * glm::eulerAngleYXZ(glm::radians(r.y), glm::radians(r.x),
+			   glm::radians(r.z));
+    return glm::scale(m, glm::vec3(s));
+  }
+
+  /**
+   * Static utility loadScene to read a scene description.
+   * Relative mesh paths resolve against the scene file.
+   * False, after logging why, on the first statement or mesh
+   * that cannot be read.
+   */
+  bool loadScene(const std::string &filename, scene &s)
+  {
+    std::ifstream in{filename, ios::in};
+    if (!in) {
+      LOG("[Error] Not able to open: ");
+      LOG(filename); LOG("\n");
+      return false;
+    }
+    std::filesystem::path dir = std::filesystem::path(filename).parent_path();
+
+    std::vector<int> meshIndex; // statement order -> unique mesh
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+      ++lineNo;
+      std::istringstream ss{line};
+      std::string keyword;
+      if (!(ss >> keyword) || keyword[0] == '#') {
+	continue;
+      }
+      if (keyword == "mesh") {
+	std::string path;
+	ss >> path;
+	std::filesystem::path p{path};
+	if (p.is_relative()) {
+	  p = dir / p;
+	}
+	int index = s.addMesh(p.string());
+	if (index < 0) {
+	  return false;
+	}
+	meshIndex.push_back(index);
+      } else if (keyword == "inst") {
+	int index = -1;
+	glm::vec3 t{0.0f}, r{0.0f};
+	float scale = 1.0f;
+	ss >> index >> t.x >> t.y >> t.z;
+	if (index < 0 || index >= static_cast<int>(meshIndex.size()) || ss.fail()) {
+	  LOG("[Error] "); LOG(filename); LOG(":"); LOG(lineNo);
+	  LOG(" bad instance statement\n");
+	  return false;
+	}
+	if (ss >> r.x >> r.y >> r.z) {
+	  ss >> scale;
+	}
+	s.addInstance(meshIndex[index], instanceTransform(t, r, scale));
+      } else {
+	LOG("[Error] "); LOG(filename); LOG(":"); LOG(lineNo);
+	LOG(" unknown statement: "); LOG(keyword); LOG("\n");
+	return false;
+      }
+    }
+    s.computeBounds();
+    return true;
+  }
+
+  /**
+   * Stress scene of count instances of one mesh on a square
+   * grid, each with its own rotation, to measure draw
+   * submission as the instance count grows.
+   */
+  bool stressScene(const std::string &filename, std::size_t count, scene &s)
+  {
+    int m = s.addMesh(filename);
+    if(m < 0)
+      {
+	return false;
+      }
+    std::size_t side = static_cast<std::size_t>
+      (std::ceil(std::sqrt(static_cast<double>(count))));
+    const float spacing = 3.0f;
+    float offset = 0.5f * spacing * (side - 1);
+    for(std::size_t i = 0; i < count; ++i)
+      {
+	glm::vec3 t{spacing * (i % side) - offset, 0.0f,
+		    spacing * (i / side) - offset};
+	glm::vec3 r{0.0f, static_cast<float>((i * 37) % 360), 0.0f};
+	s.addInstance(m, instanceTransform(t, r, 1.0f));
+      }
+    s.computeBounds();
+    return true;
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,323 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <sequence.hpp>
+#include <codec.hpp>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace twg {
+
+  std::vector<std::string> expandSequence(const std::string &first)
+  {
+    std::vector<std::string> frames{first};
+    // Last run of digits in the file name, not the directories
+    std::size_t base = first.find_last_of('/');
+    base = base == std::string::npos ? 0 : base + 1;
+    std::size_t end = first.find_last_of("0123456789");
+    if(end == std::string::npos || end < base)
+      {
+	return frames;
+      }
+    std::size_t begin = end;
+    while(begin > base && std::isdigit(static_cast<unsigned char>(first[begin - 1])))
+      {
+	--begin;
+      }
+    // Longer runs are hashes or dates, not frame numbers
+    int width = static_cast<int>(end + 1 - begin);
+    if(width > 18)
+      {
+	return frames;
+      }
+    unsigned long long number = std::strtoull(first.c_str() + begin, nullptr, 10);
+    struct stat info;
+    for(;;)
+      {
+	char digits[32];
+	std::snprintf(digits, sizeof(digits), "%0*llu", width, ++number);
+	std::string next = first.substr(0, begin) + digits + first.substr(end + 1);
+	if(::stat(next.c_str(), &info) != 0)
+	  {
+	    break;
+	  }
+	frames.push_back(next);
+      }
+    return frames;
+  }
+
+  meshSequence::~meshSequence()
+  {
+    threadPool::shared().wait(decodes);
+  }
+
+  /**
+   * One frame from its .mshz cache when that is at least as new
+   * as the frame, otherwise from the frame itself, writing the
+   * cache for next time.  The cache holds the mesh as decoded;
+   * weld, subdivision and bake settings are applied after.
+   */
+  bool meshSequence::decode(std::size_t frame, mesh &m, bool &cacheHit)
+  {
+    const std::string &file = files[frame % files.size()];
+    std::string cache = file + ".mshz";
+    struct stat source, cached;
+    cacheHit = ::stat(file.c_str(), &source) == 0 && ::stat(cache.c_str(), &cached) == 0
+      && (cached.st_mtim.tv_sec > source.st_mtim.tv_sec
+	  || (cached.st_mtim.tv_sec == source.st_mtim.tv_sec
+	      && cached.st_mtim.tv_nsec >= source.st_mtim.tv_nsec));
+    if(!cacheHit || !loadCompressed(cache, m))
+      {
+	cacheHit = false;
+	if(!load(file, m))
+	  {
+	    return false;
+	  }
+	// Written aside and renamed, a pass that wraps may read it
+	std::string temporary = cache + ".tmp" + std::to_string(frame);
+	if(saveCompressed(m, temporary))
+	  {
+	    std::rename(temporary.c_str(), cache.c_str());
+	  }
+	else
+	  {
+	    std::remove(temporary.c_str());
+	  }
+      }
+    if(prepare)
+      {
+	prepare(m);
+      }
+    return true;
+  }
+
+  bool meshSequence::open(const std::vector<std::string> &frames, loader load, preparer prepare)
+  {
+    files = frames;
+    this->load = std::move(load);
+    this->prepare = std::move(prepare);
+    slotCount = prefetch + 1;
+    slots.reset(new slot[slotCount]);
+
+    slot &s = slots[0];
+    std::unique_ptr<mesh> first{new mesh};
+    bool hit = false;
+    if(files.empty() || !decode(0, *first, hit) || first->vertices.empty())
+      {
+	LOG("[Error] Not able to read the first frame of the sequence\n");
+	return false;
+      }
+    boundsMin = boundsMax = first->vertices[0].point;
+    for(const Vertex &v : first->vertices)
+      {
+	boundsMin = glm::min(boundsMin, v.point);
+	boundsMax = glm::max(boundsMax, v.point);
+      }
+    s.frame = 0;
+    s.m = std::move(first);
+    s.state.store(ready, std::memory_order_release);
+    LOG("[Ok] Sequence of "); LOG(files.size()); LOG(" frames at "); LOG(fps);
+    LOG(" fps, decoding "); LOG(prefetch); LOG(" ahead\n");
+    return true;
+  }
+
+  /**
+   * Decode tasks for the frames after from that are neither
+   * ready nor on their way.  A slot still decoding a frame the
+   * playhead skipped is left until its task is done.
+   */
+  void meshSequence::schedule(std::size_t from)
+  {
+    std::size_t window = std::min(prefetch, files.size() - 1);
+    threadPool &pool = threadPool::shared();
+    for(std::size_t frame = from; frame < from + window; ++frame)
+      {
+	slot &s = slots[frame % slotCount];
+	uint8_t state = s.state.load(std::memory_order_acquire);
+	if(state == decoding || (state == ready && s.frame == frame))
+	  {
+	    continue;
+	  }
+	s.frame = frame;
+	s.m.reset();
+	s.state.store(decoding, std::memory_order_relaxed);
+	pool.run(decodes, [this, &s, frame] {
+	    auto start = std::chrono::steady_clock::now();
+	    std::unique_ptr<mesh> m{new mesh};
+	    bool hit = false;
+	    // Decodes run side by side; print each frame's lines whole
+	    std::ostringstream log;
+	    std::ostream *sink = logSink;
+	    logSink = &log;
+	    if(!decode(frame, *m, hit))
+	      {
+		LOG("[Error] Frame "); LOG(files[frame]); LOG(" is unreadable, dropping it\n");
+		m.reset();
+	      }
+	    logSink = sink;
+	    LOG(log.str());
+	    double ms = std::chrono::duration<double, std::milli>
+	      (std::chrono::steady_clock::now() - start).count();
+	    {
+	      std::lock_guard<std::mutex> guard{statsLock};
+	      ++counters.decoded;
+	      counters.failed += m ? 0 : 1;
+	      counters.cacheHits += hit ? 1 : 0;
+	      counters.decodeMs += ms;
+	      counters.decodeMaxMs = std::max(counters.decodeMaxMs, ms);
+	    }
+	    s.m = std::move(m);
+	    s.state.store(ready, std::memory_order_release);
+	  });
+      }
+  }
+
+  void meshSequence::upload()
+  {
+    for(bufferPair &p : pairs)
+      {
+	glGenVertexArrays(1, &p.vao);
+	glBindVertexArray(p.vao);
+	glGenBuffers(1, &p.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, p.vbo);
+	glGenBuffers(1, &p.vbe);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.vbe);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			      reinterpret_cast<void *>(offsetof(Vertex, point)));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			      reinterpret_cast<void *>(offsetof(Vertex, normal)));
+	glEnableVertexAttribArray(1);
+      }
+    slot &s = slots[0];
+    auto start = std::chrono::steady_clock::now();
+    uploadFrame(*s.m);
+    double ms = std::chrono::duration<double, std::milli>
+      (std::chrono::steady_clock::now() - start).count();
+    {
+      std::lock_guard<std::mutex> guard{statsLock};
+      ++counters.shown;
+      counters.uploadMs += ms;
+    }
+    s.m.reset();
+    s.state.store(empty, std::memory_order_relaxed);
+    schedule(1);
+  }
+
+  /**
+   * Into the pair not drawn last, growing its stores when the
+   * frame is larger than any before and writing in place
+   * otherwise, then make it the one drawn.
+   */
+  void meshSequence::uploadFrame(const mesh &m)
+  {
+    bufferPair &p = pairs[front ^ 1];
+    glBindVertexArray(p.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, p.vbo);
+    std::size_t bytes = m.vertices.size() * sizeof(Vertex);
+    if(bytes > p.vertexBytes)
+      {
+	glBufferData(GL_ARRAY_BUFFER, bytes, m.vertices.data(), GL_STREAM_DRAW);
+	p.vertexBytes = bytes;
+      }
+    else
+      {
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m.vertices.data());
+      }
+    bytes = m.elements.size() * sizeof(GLuint);
+    if(bytes > p.elementBytes)
+      {
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes, m.elements.data(), GL_STREAM_DRAW);
+	p.elementBytes = bytes;
+      }
+    else
+      {
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes, m.elements.data());
+      }
+    p.elements = static_cast<GLsizei>(m.elements.size());
+    front ^= 1;
+  }
+
+  /**
+   * The playhead runs on wall time from the first draw.  When
+   * it reaches a new frame that frame is uploaded if its slot
+   * is ready, otherwise it and any frames passed over since the
+   * last one count as dropped.
+   */
+  void meshSequence::draw()
+  {
+    auto now = std::chrono::steady_clock::now();
+    if(!started)
+      {
+	started = true;
+	startTime = now;
+      }
+    std::size_t due = static_cast<std::size_t>
+      (std::chrono::duration<double>(now - startTime).count() * fps);
+    if(due > playhead && files.size() > 1)
+      {
+	std::size_t skipped = due - playhead - 1;
+	slot &s = slots[due % slotCount];
+	bool shown = false;
+	if(s.frame == due && s.state.load(std::memory_order_acquire) == ready)
+	  {
+	    if(s.m)
+	      {
+		auto start = std::chrono::steady_clock::now();
+		uploadFrame(*s.m);
+		double ms = std::chrono::duration<double, std::milli>
+		  (std::chrono::steady_clock::now() - start).count();
+		std::lock_guard<std::mutex> guard{statsLock};
+		counters.uploadMs += ms;
+		shownFrame = due % files.size();
+		shown = true;
+	      }
+	    s.m.reset();
+	    s.state.store(empty, std::memory_order_relaxed);
+	  }
+	{
+	  std::lock_guard<std::mutex> guard{statsLock};
+	  counters.shown += shown ? 1 : 0;
+	  counters.dropped += skipped + (shown ? 0 : 1);
+	}
+	playhead = due;
+	schedule(due + 1);
+      }
+    const bufferPair &p = pairs[front];
+    glBindVertexArray(p.vao);
+    glDrawElements(GL_TRIANGLES, p.elements, GL_UNSIGNED_INT, 0);
+  }
+
+  sequenceStats meshSequence::stats()
+  {
+    std::lock_guard<std::mutex> guard{statsLock};
+    return counters;
+  }
+
+  void meshSequence::release()
+  {
+    threadPool::shared().wait(decodes);
+    for(bufferPair &p : pairs)
+      {
+	glDeleteBuffers(1, &p.vbo);
+	glDeleteBuffers(1, &p.vbe);
+	glDeleteVertexArrays(1, &p.vao);
+	p = bufferPair{};
+      }
+    sequenceStats s = stats();
+    LOG("[Ok] Sequence played "); LOG(s.shown); LOG(" frames, dropped "); LOG(s.dropped);
+    LOG("; decoded "); LOG(s.decoded); LOG(" ("); LOG(s.cacheHits); LOG(" from cache, ");
+    LOG(s.failed); LOG(" failed) in ");
+    LOG(s.meanDecodeMs()); LOG(" ms mean, "); LOG(s.decodeMaxMs); LOG(" ms max; upload ");
+    LOG(s.meanUploadMs()); LOG(" ms mean\n");
+  }
+
+} /* End twg namespace */
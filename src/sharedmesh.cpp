@@ -0,0 +1,324 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <sharedmesh.hpp>
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace twg {
+
+  static constexpr char sharedMeshMagic[8] = {'M', 'T', 'S', 'H', 'M', 'E', 'S', 'H'};
+  static constexpr uint32_t sharedMeshVersion = 1;
+
+  // shm_open wants one leading slash and no others
+  static std::string segmentName(const std::string &name)
+  {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+  }
+
+  static std::size_t alignUp(std::size_t v, std::size_t to)
+  {
+    return (v + to - 1) / to * to;
+  }
+
+  bool sharedMeshWriter::create(const std::string &name, std::size_t vertexCapacity,
+				std::size_t elementCapacity)
+  {
+    release();
+    std::string path = segmentName(name);
+    int fd = ::shm_open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if(fd < 0)
+      {
+	LOG("[Error] Not able to create shared memory "); LOG(path); LOG(": ");
+	LOG(std::strerror(errno)); LOG("\n");
+	return false;
+      }
+    std::size_t vertexOffset = alignUp(sizeof(sharedMeshHeader), 64);
+    std::size_t elementOffset = alignUp(vertexOffset + vertexCapacity * sizeof(Vertex), 64);
+    std::size_t size = elementOffset + elementCapacity * sizeof(GLuint);
+    void *p = MAP_FAILED;
+    if(::ftruncate(fd, static_cast<off_t>(size)) == 0)
+      {
+	p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      }
+    ::close(fd);
+    if(p == MAP_FAILED)
+      {
+	LOG("[Error] Not able to size shared memory "); LOG(path); LOG(": ");
+	LOG(std::strerror(errno)); LOG("\n");
+	::shm_unlink(path.c_str());
+	return false;
+      }
+    // Readers only trust the header once generation is nonzero
+    header = new (p) sharedMeshHeader{};
+    std::memcpy(header->magic, sharedMeshMagic, sizeof(sharedMeshMagic));
+    header->version = sharedMeshVersion;
+    header->headerSize = sizeof(sharedMeshHeader);
+    header->vertexStride = sizeof(Vertex);
+    header->elementSize = sizeof(GLuint);
+    header->vertexCapacity = vertexCapacity;
+    header->elementCapacity = elementCapacity;
+    header->vertexOffset = vertexOffset;
+    header->elementOffset = elementOffset;
+    header->generation.store(0, std::memory_order_relaxed);
+    length = size;
+    this->name = path;
+    return true;
+  }
+
+  Vertex *sharedMeshWriter::vertices()
+  {
+    return reinterpret_cast<Vertex *>(reinterpret_cast<uint8_t *>(header) + header->vertexOffset);
+  }
+
+  GLuint *sharedMeshWriter::elements()
+  {
+    return reinterpret_cast<GLuint *>(reinterpret_cast<uint8_t *>(header) + header->elementOffset);
+  }
+
+  void sharedMeshWriter::begin()
+  {
+    uint64_t g = header->generation.load(std::memory_order_relaxed);
+    header->generation.store(g | 1, std::memory_order_relaxed);
+    // The odd value is visible before any of the writes after it
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void sharedMeshWriter::commit(std::size_t vertexCount, std::size_t elementCount,
+				std::size_t vertexFirst, std::size_t vertexEnd,
+				std::size_t elementFirst, std::size_t elementEnd)
+  {
+    begin();
+    header->vertexCount = std::min<uint64_t>(vertexCount, header->vertexCapacity);
+    header->elementCount = std::min<uint64_t>(elementCount, header->elementCapacity);
+    header->vertexDirty[0] = vertexFirst;
+    header->vertexDirty[1] = vertexEnd;
+    header->elementDirty[0] = elementFirst;
+    header->elementDirty[1] = elementEnd;
+    uint64_t g = header->generation.load(std::memory_order_relaxed);
+    header->generation.store(g + 1, std::memory_order_release);
+  }
+
+  bool sharedMeshWriter::publish(const mesh &m)
+  {
+    if(!header || m.vertices.size() > header->vertexCapacity
+       || m.elements.size() > header->elementCapacity)
+      {
+	return false;
+      }
+    begin();
+    std::copy(m.vertices.begin(), m.vertices.end(), vertices());
+    std::copy(m.elements.begin(), m.elements.end(), elements());
+    commit(m.vertices.size(), m.elements.size());
+    return true;
+  }
+
+  void sharedMeshWriter::release(bool keep)
+  {
+    if(header)
+      {
+	::munmap(header, length);
+	header = nullptr;
+	length = 0;
+	if(!keep)
+	  {
+	    ::shm_unlink(name.c_str());
+	  }
+      }
+  }
+
+  static std::atomic<bool> publisherStop{false};
+
+  static void stopPublisher(int)
+  {
+    publisherStop = true;
+  }
+
+  int runSharedPublisher(const std::string &name, const mesh &m)
+  {
+    sharedMeshWriter writer;
+    if(!writer.create(name, m.vertices.size(), m.elements.size()) || !writer.publish(m))
+      {
+	return 1;
+      }
+    LOG("[Ok] Published "); LOG(m.vertices.size()); LOG(" vertices and ");
+    LOG(m.elements.size() / 3); LOG(" triangles as "); LOG(segmentName(name));
+    LOG(", until interrupted\n");
+    publisherStop = false;
+    std::signal(SIGINT, stopPublisher);
+    std::signal(SIGTERM, stopPublisher);
+    while(!publisherStop)
+      {
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+    writer.release();
+    LOG("[Ok] Removed "); LOG(segmentName(name)); LOG("\n");
+    return 0;
+  }
+
+  bool sharedMesh::open(const std::string &name)
+  {
+    std::string path = segmentName(name);
+    int fd = ::shm_open(path.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+      {
+	LOG("[Error] Not able to open shared memory "); LOG(path); LOG(": ");
+	LOG(std::strerror(errno)); LOG("\n");
+	return false;
+      }
+    struct stat info;
+    void *p = MAP_FAILED;
+    std::size_t size = 0;
+    if(::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(sharedMeshHeader))
+      {
+	size = static_cast<std::size_t>(info.st_size);
+	p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      }
+    ::close(fd);
+    if(p == MAP_FAILED)
+      {
+	LOG("[Error] Not able to map shared memory "); LOG(path); LOG("\n");
+	return false;
+      }
+    unmap();
+    header = static_cast<const sharedMeshHeader *>(p);
+    length = size;
+    return true;
+  }
+
+  bool sharedMesh::wait(double timeout)
+  {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t g = header->generation.load(std::memory_order_acquire);
+    while(g == 0 || (g & 1))
+      {
+	if(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout)
+	  {
+	    LOG("[Error] Nothing published to the shared mesh in time\n");
+	    return false;
+	  }
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	g = header->generation.load(std::memory_order_acquire);
+      }
+    bool valid = std::memcmp(header->magic, sharedMeshMagic, sizeof(sharedMeshMagic)) == 0
+      && header->version == sharedMeshVersion
+      && header->headerSize == sizeof(sharedMeshHeader)
+      && header->vertexStride == sizeof(Vertex)
+      && header->elementSize == sizeof(GLuint)
+      && header->vertexOffset + header->vertexCapacity * sizeof(Vertex) <= length
+      && header->elementOffset + header->elementCapacity * sizeof(GLuint) <= length;
+    if(!valid)
+      {
+	LOG("[Error] Shared memory does not hold a version ");
+	LOG(sharedMeshVersion); LOG(" mesh\n");
+	return false;
+      }
+    return true;
+  }
+
+  void sharedMesh::upload()
+  {
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    // Sized once for the capacities so every commit fits
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, header->vertexCapacity * sizeof(Vertex), nullptr,
+		 GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &vbe);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbe);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, header->elementCapacity * sizeof(GLuint), nullptr,
+		 GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			  reinterpret_cast<void *>(offsetof(Vertex, point)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			  reinterpret_cast<void *>(offsetof(Vertex, normal)));
+    glEnableVertexAttribArray(1);
+    stale = true;
+    refresh();
+  }
+
+  /**
+   * Sequence lock read: the arrays are uploaded straight from
+   * the mapping between two reads of generation, and if it
+   * moved in between the buffers are marked stale so the next
+   * stable generation goes up whole.
+   */
+  void sharedMesh::refresh()
+  {
+    uint64_t g = header->generation.load(std::memory_order_acquire);
+    if(g == 0 || (g & 1) || (g == shown && !stale))
+      {
+	return;
+      }
+    bool partial = !stale && g == shown + 2;
+    std::size_t vertexCount = std::min(header->vertexCount, header->vertexCapacity);
+    std::size_t elementCount = std::min(header->elementCount, header->elementCapacity);
+    elementCount -= elementCount % 3;
+    std::size_t v0 = 0, v1 = vertexCount, e0 = 0, e1 = elementCount;
+    if(partial)
+      {
+	v1 = std::min<std::size_t>(header->vertexDirty[1], vertexCount);
+	v0 = std::min<std::size_t>(header->vertexDirty[0], v1);
+	e1 = std::min<std::size_t>(header->elementDirty[1], elementCount);
+	e0 = std::min<std::size_t>(header->elementDirty[0], e1);
+      }
+    const uint8_t *base = reinterpret_cast<const uint8_t *>(header);
+    glBindVertexArray(vao);
+    if(v1 > v0)
+      {
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, v0 * sizeof(Vertex), (v1 - v0) * sizeof(Vertex),
+			base + header->vertexOffset + v0 * sizeof(Vertex));
+      }
+    if(e1 > e0)
+      {
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, e0 * sizeof(GLuint), (e1 - e0) * sizeof(GLuint),
+			base + header->elementOffset + e0 * sizeof(GLuint));
+      }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    stale = header->generation.load(std::memory_order_relaxed) != g;
+    shown = g;
+    elements = elementCount;
+    ++counters.generations;
+    counters.partial += partial ? 1 : 0;
+    counters.torn += stale ? 1 : 0;
+    counters.bytes += (v1 - v0) * sizeof(Vertex) + (e1 - e0) * sizeof(GLuint);
+  }
+
+  void sharedMesh::draw()
+  {
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(elements), GL_UNSIGNED_INT, 0);
+  }
+
+  void sharedMesh::release()
+  {
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &vbe);
+    glDeleteVertexArrays(1, &vao);
+    vbo = vbe = vao = 0;
+  }
+
+  void sharedMesh::unmap()
+  {
+    if(header)
+      {
+	::munmap(const_cast<sharedMeshHeader *>(header), length);
+	header = nullptr;
+	length = 0;
+      }
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,430 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <stats.hpp>
+#include <parallel.hpp>
+#include <atomic>
+#include <cfloat>
+#include <cstdint>
+#include <iomanip>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace twg {
+
+  /**
+   * Disjoint set over vertex indices.  unite and find are
+   * lock free so faces can be merged from several threads,
+   * roots always link towards the smaller index.
+   */
+  struct unionFind {
+    std::vector<std::atomic<uint32_t>> parent;
+
+    explicit unionFind(std::size_t n)
+      : parent(n)
+    {
+      parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	  for(std::size_t i = lo; i < hi; ++i)
+	    {
+	      parent[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+	    }
+	});
+    }
+
+    uint32_t find(uint32_t x)
+    {
+      for(;;)
+	{
+	  uint32_t p = parent[x].load(std::memory_order_relaxed);
+	  if(p == x)
+	    {
+	      return x;
+	    }
+	  // Path halving, a failed exchange only skips the shortcut
+	  uint32_t gp = parent[p].load(std::memory_order_relaxed);
+	  if(p != gp)
+	    {
+	      parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+	    }
+	  x = gp;
+	}
+    }
+
+    void unite(uint32_t a, uint32_t b)
+    {
+      for(;;)
+	{
+	  a = find(a);
+	  b = find(b);
+	  if(a == b)
+	    {
+	      return;
+	    }
+	  if(a < b)
+	    {
+	      std::swap(a, b);
+	    }
+	  uint32_t expected = a;
+	  if(parent[a].compare_exchange_strong(expected, b))
+	    {
+	      return;
+	    }
+	}
+    }
+  };
+
+  struct boundsResult {
+    glm::vec3 lo{FLT_MAX};
+    glm::vec3 hi{-FLT_MAX};
+  };
+
+  /**
+   * Bounds of a run of vertices.  The SSE path loads the point
+   * plus the following normal.x and ignores the fourth lane.
+   */
+  static boundsResult boundsKernel(const Vertex *v, std::size_t n)
+  {
+    boundsResult r;
+#ifdef __SSE__
+    __m128 lo = _mm_set1_ps(FLT_MAX);
+    __m128 hi = _mm_set1_ps(-FLT_MAX);
+    for(std::size_t i = 0; i < n; ++i)
+      {
+	__m128 p = _mm_loadu_ps(&v[i].point.x);
+	lo = _mm_min_ps(lo, p);
+	hi = _mm_max_ps(hi, p);
+      }
+    alignas(16) float l[4], h[4];
+    _mm_store_ps(l, lo);
+    _mm_store_ps(h, hi);
+    r.lo = glm::vec3(l[0], l[1], l[2]);
+    r.hi = glm::vec3(h[0], h[1], h[2]);
+#else
+    for(std::size_t i = 0; i < n; ++i)
+      {
+	r.lo = glm::min(r.lo, v[i].point);
+	r.hi = glm::max(r.hi, v[i].point);
+      }
+#endif
+    return r;
+  }
+
+  struct faceResult {
+    double area = 0.0;
+    double volume = 0.0;
+    std::size_t degenerate = 0;
+  };
+
+  /**
+   * Area, signed volume (divergence theorem, tetrahedra to the
+   * origin) and degenerate count for triangles [lo,hi).
+   */
+  static faceResult faceKernel(const mesh &m, std::size_t lo, std::size_t hi)
+  {
+    faceResult r;
+    const GLuint *e = m.elements.data();
+    const Vertex *v = m.vertices.data();
+    for(std::size_t t = lo; t < hi; ++t)
+      {
+	GLuint ia = e[3 * t], ib = e[3 * t + 1], ic = e[3 * t + 2];
+	const glm::vec3 &a = v[ia].point;
+	const glm::vec3 &b = v[ib].point;
+	const glm::vec3 &c = v[ic].point;
+	glm::vec3 n = glm::cross(b - a, c - a);
+	float len2 = glm::dot(n, n);
+	float scale = std::max(glm::dot(b - a, b - a), glm::dot(c - a, c - a));
+	if(ia == ib || ib == ic || ia == ic || len2 <= FLT_EPSILON * scale * scale)
+	  {
+	    ++r.degenerate;
+	  }
+	r.area += 0.5 * std::sqrt(static_cast<double>(len2));
+	r.volume += glm::dot(a, glm::cross(b, c)) / 6.0;
+      }
+    return r;
+  }
+
+  static inline uint64_t mixKey(uint64_t k)
+  {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+  }
+
+  /**
+   * Count how many faces use each undirected edge.  Every
+   * worker scatters its edge keys into hash partitions, each
+   * partition is then counted by one worker in a private open
+   * addressing table, so no table is shared between threads.
+   */
+  static void edgeKernel(const mesh &m, meshStats &s,
+			 std::vector<uint64_t> &boundary)
+  {
+    const uint64_t empty = ~0ull;
+    std::size_t triangles = m.elements.size() / 3;
+    unsigned workers = workerCount();
+    unsigned bits = 0;
+    while((1u << bits) < workers * 4)
+      {
+	++bits;
+      }
+    std::size_t partitions = std::size_t(1) << bits;
+
+    std::vector<std::vector<std::vector<uint64_t>>> scattered
+      (workers, std::vector<std::vector<uint64_t>>(partitions));
+    parallelFor(0, triangles, [&](std::size_t lo, std::size_t hi, unsigned w) {
+	auto &out = scattered[w];
+	for(std::size_t t = lo; t < hi; ++t)
+	  {
+	    for(int k = 0; k < 3; ++k)
+	      {
+		uint64_t a = m.elements[3 * t + k];
+		uint64_t b = m.elements[3 * t + (k + 1) % 3];
+		if(a == b)
+		  {
+		    continue;
+		  }
+		uint64_t key = a < b ? (a << 32) | b : (b << 32) | a;
+		out[bits ? mixKey(key) >> (64 - bits) : 0].push_back(key);
+	      }
+	  }
+      });
+
+    std::vector<meshStats> counts(partitions);
+    std::vector<std::vector<uint64_t>> open(partitions);
+    parallelFor(0, partitions, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t p = lo; p < hi; ++p)
+	  {
+	    std::size_t n = 0;
+	    for(unsigned w = 0; w < workers; ++w)
+	      {
+		n += scattered[w][p].size();
+	      }
+	    std::size_t capacity = 16;
+	    while(capacity < 2 * n)
+	      {
+		capacity <<= 1;
+	      }
+	    std::vector<uint64_t> keys(capacity, empty);
+	    std::vector<uint32_t> uses(capacity, 0);
+	    for(unsigned w = 0; w < workers; ++w)
+	      {
+		for(uint64_t key : scattered[w][p])
+		  {
+		    std::size_t slot = mixKey(key) & (capacity - 1);
+		    while(keys[slot] != empty && keys[slot] != key)
+		      {
+			slot = (slot + 1) & (capacity - 1);
+		      }
+		    keys[slot] = key;
+		    ++uses[slot];
+		  }
+	      }
+	    for(std::size_t i = 0; i < capacity; ++i)
+	      {
+		if(keys[i] == empty)
+		  {
+		    continue;
+		  }
+		++counts[p].edges;
+		if(uses[i] == 1)
+		  {
+		    ++counts[p].boundaryEdges;
+		    open[p].push_back(keys[i]);
+		  }
+		else if(uses[i] > 2)
+		  {
+		    ++counts[p].nonManifoldEdges;
+		  }
+	      }
+	  }
+      });
+
+    for(std::size_t p = 0; p < partitions; ++p)
+      {
+	s.edges += counts[p].edges;
+	s.boundaryEdges += counts[p].boundaryEdges;
+	s.nonManifoldEdges += counts[p].nonManifoldEdges;
+	boundary.insert(boundary.end(), open[p].begin(), open[p].end());
+      }
+  }
+
+  /**
+   * Static utility computeStats for the headless --stats mode.
+   * Every pass is a parallel reduction over the vertex or
+   * element arrays.
+   */
+  meshStats computeStats(const mesh &m)
+  {
+    auto start = std::chrono::steady_clock::now();
+    meshStats s;
+    s.vertices = m.vertices.size();
+    s.triangles = m.elements.size() / 3;
+
+    boundsResult b = parallelReduce
+      (0, m.vertices.size(), boundsResult{},
+       [&](std::size_t lo, std::size_t hi) {
+	return boundsKernel(m.vertices.data() + lo, hi - lo);
+      },
+       [](boundsResult a, const boundsResult &c) {
+	 a.lo = glm::min(a.lo, c.lo);
+	 a.hi = glm::max(a.hi, c.hi);
+	 return a;
+       });
+    if(!m.vertices.empty())
+      {
+	s.boundsMin = b.lo;
+	s.boundsMax = b.hi;
+      }
+
+    faceResult f = parallelReduce
+      (0, s.triangles, faceResult{},
+       [&](std::size_t lo, std::size_t hi) { return faceKernel(m, lo, hi); },
+       [](faceResult a, const faceResult &c) {
+	 a.area += c.area;
+	 a.volume += c.volume;
+	 a.degenerate += c.degenerate;
+	 return a;
+       });
+    s.area = f.area;
+    s.volume = f.volume;
+    s.degenerate = f.degenerate;
+
+    std::vector<uint64_t> boundary;
+    edgeKernel(m, s, boundary);
+
+    // Connected components over face-referenced vertices
+    unionFind faces{m.vertices.size()};
+    std::vector<std::atomic<unsigned char>> used(m.vertices.size());
+    parallelFor(0, m.vertices.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    used[i].store(0, std::memory_order_relaxed);
+	  }
+      });
+    parallelFor(0, s.triangles, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t t = lo; t < hi; ++t)
+	  {
+	    GLuint a = m.elements[3 * t];
+	    GLuint b = m.elements[3 * t + 1];
+	    GLuint c = m.elements[3 * t + 2];
+	    used[a].store(1, std::memory_order_relaxed);
+	    used[b].store(1, std::memory_order_relaxed);
+	    used[c].store(1, std::memory_order_relaxed);
+	    faces.unite(a, b);
+	    faces.unite(a, c);
+	  }
+      });
+    s.components = parallelReduce
+      (0, m.vertices.size(), std::size_t(0),
+       [&](std::size_t lo, std::size_t hi) {
+	std::size_t n = 0;
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    if(used[i].load(std::memory_order_relaxed) &&
+	       faces.find(static_cast<uint32_t>(i)) == i)
+	      {
+		++n;
+	      }
+	  }
+	return n;
+      },
+       [](std::size_t a, std::size_t c) { return a + c; });
+
+    // Boundary loops are the components of the open edge graph
+    if(!boundary.empty())
+      {
+	unionFind loops{m.vertices.size()};
+	std::vector<unsigned char> onBoundary(m.vertices.size(), 0);
+	for(uint64_t key : boundary)
+	  {
+	    uint32_t a = static_cast<uint32_t>(key >> 32);
+	    uint32_t c = static_cast<uint32_t>(key & 0xffffffffu);
+	    onBoundary[a] = onBoundary[c] = 1;
+	    loops.unite(a, c);
+	  }
+	for(std::size_t i = 0; i < m.vertices.size(); ++i)
+	  {
+	    if(onBoundary[i] && loops.find(static_cast<uint32_t>(i)) == i)
+	      {
+		++s.boundaryLoops;
+	      }
+	  }
+      }
+
+    s.seconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+    return s;
+  }
+
+  /**
+   * Quoted and escaped; file names may hold any byte but the
+   * control characters must not reach the JSON raw.
+   */
+  static std::string jsonString(const std::string &str)
+  {
+    static const char hex[] = "0123456789abcdef";
+    std::string out{"\""};
+    for(char c : str)
+      {
+	unsigned char u = static_cast<unsigned char>(c);
+	if(c == '"' || c == '\\')
+	  {
+	    out += '\\';
+	    out += c;
+	  }
+	else if(c == '\n')
+	  {
+	    out += "\\n";
+	  }
+	else if(c == '\t')
+	  {
+	    out += "\\t";
+	  }
+	else if(u < 0x20)
+	  {
+	    out += "\\u00";
+	    out += hex[u >> 4];
+	    out += hex[u & 15];
+	  }
+	else
+	  {
+	    out += c;
+	  }
+      }
+    return out + "\"";
+  }
+
+  std::string statsJson(const std::string &filename, const meshStats &s)
+  {
+    std::ostringstream os;
+    os << std::setprecision(9);
+    os << "{\"file\": " << jsonString(filename)
+       << ", \"vertices\": " << s.vertices
+       << ", \"triangles\": " << s.triangles
+       << ", \"bounds\": {\"min\": [" << s.boundsMin.x << ", "
+       << s.boundsMin.y << ", " << s.boundsMin.z << "], \"max\": ["
+       << s.boundsMax.x << ", " << s.boundsMax.y << ", " << s.boundsMax.z
+       << "]}"
+       << ", \"area\": " << s.area
+       << ", \"volume\": " << s.volume
+       << ", \"degenerate_faces\": " << s.degenerate
+       << ", \"edges\": " << s.edges
+       << ", \"boundary_edges\": " << s.boundaryEdges
+       << ", \"non_manifold_edges\": " << s.nonManifoldEdges
+       << ", \"boundary_loops\": " << s.boundaryLoops
+       << ", \"components\": " << s.components
+       << ", \"closed\": " << (s.closed() ? "true" : "false")
+       << ", \"seconds\": " << s.seconds << "}";
+    return os.str();
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,270 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <stream.hpp>
+#include <cstring>
+#include <functional>
+#include <zlib.h>
+#ifdef MESHTOOL_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace twg {
+
+  inputStream::inputStream(const std::string &filename)
+    : start{std::chrono::steady_clock::now()}
+  {
+    file = std::fopen(filename.c_str(), "rb");
+    if(!file)
+      {
+	return;
+      }
+    unsigned char magic[4] = {};
+    std::size_t n = std::fread(magic, 1, sizeof(magic), file);
+    std::rewind(file);
+    if(n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+      {
+	type = format::gzip;
+      }
+    else if(n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f
+	    && magic[3] == 0xfd)
+      {
+	type = format::zstd;
+      }
+    blocks[0].data.resize(blockSize);
+    blocks[1].data.resize(blockSize);
+    reader = std::thread(&inputStream::produce, this);
+  }
+
+  inputStream::~inputStream()
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
+    }
+    changed.notify_all();
+    if(reader.joinable())
+      {
+	reader.join();
+      }
+    if(file)
+      {
+	std::fclose(file);
+      }
+  }
+
+  const char *inputStream::formatName() const
+  {
+    return type == format::gzip ? "gzip" : type == format::zstd ? "zstd" : "plain";
+  }
+
+  double inputStream::seconds() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  /**
+   * Reader thread: fill the free block with up to blockSize
+   * bytes of output, hand it over, switch to the other one.
+   * fill returns true once the stream has ended (or failed),
+   * which marks that block as the last.
+   */
+  void inputStream::produce()
+  {
+    std::vector<unsigned char> in(256 << 10);
+    std::function<bool(block &)> fill;
+    std::function<void()> finish = [] {};
+
+    // Next piece of compressed input, false at end of file
+    auto refill = [&](std::size_t &got) {
+      got = std::fread(in.data(), 1, in.size(), file);
+      consumed += got;
+      if(std::ferror(file))
+	{
+	  error = true;
+	}
+      return got > 0;
+    };
+
+    z_stream z{};
+    int zresult = Z_OK;
+    if(type == format::plain)
+      {
+	fill = [&](block &b) {
+	  b.size = std::fread(b.data.data(), 1, blockSize, file);
+	  consumed += b.size;
+	  error = std::ferror(file) != 0;
+	  return b.size < blockSize;
+	};
+      }
+    else if(type == format::gzip)
+      {
+	// 15 + 32: gzip or zlib header, concatenated members allowed
+	inflateInit2(&z, 15 + 32);
+	finish = [&] { inflateEnd(&z); };
+	fill = [&](block &b) {
+	  z.next_out = reinterpret_cast<Bytef *>(b.data.data());
+	  z.avail_out = blockSize;
+	  while(z.avail_out > 0)
+	    {
+	      if(z.avail_in == 0)
+		{
+		  std::size_t got;
+		  if(!refill(got))
+		    {
+		      error = error || zresult != Z_STREAM_END;
+		      b.size = blockSize - z.avail_out;
+		      return true;
+		    }
+		  z.next_in = in.data();
+		  z.avail_in = got;
+		}
+	      zresult = inflate(&z, Z_NO_FLUSH);
+	      if(zresult == Z_STREAM_END)
+		{
+		  inflateReset(&z);
+		}
+	      else if(zresult != Z_OK)
+		{
+		  error = true;
+		  b.size = blockSize - z.avail_out;
+		  return true;
+		}
+	    }
+	  b.size = blockSize;
+	  return false;
+	};
+      }
+    else
+      {
+#ifdef MESHTOOL_WITH_ZSTD
+	ZSTD_DStream *zs = ZSTD_createDStream();
+	ZSTD_initDStream(zs);
+	ZSTD_inBuffer zin{in.data(), 0, 0};
+	std::size_t zsresult = 0;
+	finish = [zs] { ZSTD_freeDStream(zs); };
+	fill = [&, zs](block &b) {
+	  ZSTD_outBuffer out{b.data.data(), blockSize, 0};
+	  while(out.pos < out.size)
+	    {
+	      if(zin.pos == zin.size)
+		{
+		  std::size_t got;
+		  if(!refill(got))
+		    {
+		      // zsresult is 0 once a frame is complete
+		      error = error || zsresult != 0;
+		      b.size = out.pos;
+		      return true;
+		    }
+		  zin.size = got;
+		  zin.pos = 0;
+		}
+	      zsresult = ZSTD_decompressStream(zs, &out, &zin);
+	      if(ZSTD_isError(zsresult))
+		{
+		  error = true;
+		  b.size = out.pos;
+		  return true;
+		}
+	    }
+	  b.size = out.pos;
+	  return false;
+	};
+#else
+	fill = [&](block &b) {
+	  LOG("[Error] zstd input needs a build with MESHTOOL_WITH_ZSTD\n");
+	  error = true;
+	  b.size = 0;
+	  return true;
+	};
+#endif
+      }
+
+    for(int i = 0;; i ^= 1)
+      {
+	block &b = blocks[i];
+	{
+	  std::unique_lock<std::mutex> guard(lock);
+	  changed.wait(guard, [&] { return stop || !b.ready; });
+	  if(stop)
+	    {
+	      break;
+	    }
+	}
+	bool done = fill(b);
+	{
+	  std::lock_guard<std::mutex> guard(lock);
+	  b.ready = true;
+	  b.last = done;
+	}
+	changed.notify_all();
+	if(done)
+	  {
+	    break;
+	  }
+      }
+    finish();
+  }
+
+  void inputStream::acquire()
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [&] { return blocks[current].ready; });
+    holding = true;
+    offset = 0;
+  }
+
+  void inputStream::release()
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      blocks[current].ready = false;
+    }
+    changed.notify_all();
+    holding = false;
+    current ^= 1;
+  }
+
+  /**
+   * Same contract as std::getline: false once no characters
+   * are left, the final line may lack its newline.
+   */
+  bool inputStream::getline(std::string &line)
+  {
+    line.clear();
+    if(!file)
+      {
+	return false;
+      }
+    for(;;)
+      {
+	if(!holding)
+	  {
+	    if(finished)
+	      {
+		return !line.empty();
+	      }
+	    acquire();
+	  }
+	block &b = blocks[current];
+	const char *begin = b.data.data() + offset, *end = b.data.data() + b.size;
+	const char *nl = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+	if(nl)
+	  {
+	    line.append(begin, nl);
+	    offset = nl + 1 - b.data.data();
+	    return true;
+	  }
+	line.append(begin, end);
+	finished = b.last;
+	release();
+      }
+  }
+
+} /* End twg namespace */
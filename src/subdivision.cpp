@@ -0,0 +1,425 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <subdivision.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+
+namespace twg {
+
+  using adjacency = meshAdjacency;
+
+  double subdivisionStats::trianglesPerSecondPerCore() const
+  {
+    return seconds > 0.0 ? trianglesAfter / seconds / workerCount() : 0.0;
+  }
+
+  /**
+   * Exclusive scan of count(i) over [0, n): every worker sums
+   * its range, the sums are scanned in worker order, then each
+   * range is walked again calling assign(i, offset).  Returns
+   * the total.
+   */
+  template <typename Count, typename Assign>
+  static std::size_t parallelScan(std::size_t n, Count count, Assign assign)
+  {
+    std::vector<std::size_t> partial(workerCount() + 1, 0);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned w) {
+	std::size_t sum = 0;
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    sum += count(i);
+	  }
+	partial[w + 1] = sum;
+      });
+    for(std::size_t w = 1; w < partial.size(); ++w)
+      {
+	partial[w] += partial[w - 1];
+      }
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned w) {
+	std::size_t offset = partial[w];
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    assign(i, offset);
+	    offset += count(i);
+	  }
+      });
+    return partial.back();
+  }
+
+  /**
+   * Loop's weight for each neighbour of an interior vertex of
+   * valence n.
+   */
+  static float loopBeta(std::size_t n)
+  {
+    double c = 0.375 + 0.25 * std::cos(2.0 * M_PI / n);
+    return static_cast<float>((0.625 - c * c) / n);
+  }
+
+  static glm::vec3 normalized(const glm::vec3 &n, const glm::vec3 &fallback)
+  {
+    float len = glm::length(n);
+    return len > 0.0f ? n / len : fallback;
+  }
+
+  std::size_t loopSubdivision::prepare(const mesh &m, const subdivisionOptions &options)
+  {
+    cage = &m;
+    adj = buildAdjacency(m);
+    std::size_t faces = m.elements.size() / 3;
+    vertices = m.vertices.size();
+
+    std::size_t refined = faces;
+    refine.assign(faces, 1);
+    if(options.maxEdgePixels > 0.0f)
+      {
+	// Pixel position of every vertex, z = 0 behind the eye
+	std::vector<glm::vec3> screen(vertices);
+	parallelFor(0, vertices, [&](std::size_t lo, std::size_t hi, unsigned) {
+	    for(std::size_t v = lo; v < hi; ++v)
+	      {
+		glm::vec4 clip = options.viewProjection * glm::vec4(m.vertices[v].point, 1.0f);
+		if(clip.w <= 1e-6f)
+		  {
+		    screen[v] = glm::vec3(0.0f);
+		    continue;
+		  }
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		screen[v] = glm::vec3((ndc * 0.5f + 0.5f) * options.viewport, 1.0f);
+	      }
+	  });
+	float limit = options.maxEdgePixels * options.maxEdgePixels;
+	refined = parallelReduce
+	  (0, faces, std::size_t(0),
+	   [&](std::size_t lo, std::size_t hi) {
+	    std::size_t count = 0;
+	    for(std::size_t f = lo; f < hi; ++f)
+	      {
+		const glm::vec3 &a = screen[m.elements[3 * f]];
+		const glm::vec3 &b = screen[m.elements[3 * f + 1]];
+		const glm::vec3 &c = screen[m.elements[3 * f + 2]];
+		float longest = std::max({glm::dot(glm::vec2(b - a), glm::vec2(b - a)),
+					  glm::dot(glm::vec2(c - b), glm::vec2(c - b)),
+					  glm::dot(glm::vec2(a - c), glm::vec2(a - c))});
+		refine[f] = a.z > 0.0f && b.z > 0.0f && c.z > 0.0f && longest > limit;
+		count += refine[f];
+	      }
+	    return count;
+	  },
+	   [](std::size_t a, std::size_t b) { return a + b; });
+      }
+
+    // One new vertex per edge touching a refined face, numbered
+    // on the edge's lower half-edge and copied to its twin
+    edgeVertex.assign(3 * faces, invalid);
+    auto splits = [&](std::size_t h) -> std::size_t {
+      uint32_t t = adj.twin[h];
+      if(t != invalid && t < h)
+	{
+	  return 0;
+	}
+      return refine[h / 3] || (t != invalid && refine[t / 3]);
+    };
+    vertices += parallelScan(3 * faces, splits, [&](std::size_t h, std::size_t offset) {
+	if(splits(h))
+	  {
+	    edgeVertex[h] = static_cast<uint32_t>(m.vertices.size() + offset);
+	  }
+      });
+    parallelFor(0, 3 * faces, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t h = lo; h < hi; ++h)
+	  {
+	    uint32_t t = adj.twin[h];
+	    if(t != invalid && t < h)
+	      {
+		edgeVertex[h] = edgeVertex[t];
+	      }
+	  }
+      });
+
+    // 1 + split edges output triangles per face
+    firstTriangle.resize(faces + 1);
+    auto triangles = [&](std::size_t f) -> std::size_t {
+      return 1 + (edgeVertex[3 * f] != invalid) + (edgeVertex[3 * f + 1] != invalid)
+	+ (edgeVertex[3 * f + 2] != invalid);
+    };
+    firstTriangle[faces] = static_cast<uint32_t>
+      (parallelScan(faces, triangles, [&](std::size_t f, std::size_t offset) {
+	  firstTriangle[f] = static_cast<uint32_t>(offset);
+	}));
+    return refined;
+  }
+
+  /**
+   * Even stencil: (1 - n beta) v + beta * one ring inside,
+   * 3/4 v + 1/8 of the two boundary neighbours on a boundary.
+   * Corners, non-manifold vertices and vertices with an
+   * unrefined face keep their position.
+   */
+  void loopSubdivision::writeVertex(uint32_t v, Vertex &out) const
+  {
+    const std::vector<GLuint> &e = cage->elements;
+    const Vertex &self = cage->vertices[v];
+    out = self;
+    uint32_t begin = adj.cornerOffsets[v], end = adj.cornerOffsets[v + 1];
+    if(begin == end)
+      {
+	return;
+      }
+    Vertex ring{glm::vec3(0.0f), glm::vec3(0.0f)}, border = ring;
+    int borders = 0;
+    for(uint32_t i = begin; i < end; ++i)
+      {
+	uint32_t h = adj.corners[i];
+	if(!refine[adjacency::face(h)])
+	  {
+	    return;
+	  }
+	const Vertex &n = cage->vertices[e[adjacency::next(h)]];
+	ring.point += n.point;
+	ring.normal += n.normal;
+	if(adj.twin[h] == invalid)
+	  {
+	    border.point += n.point;
+	    border.normal += n.normal;
+	    ++borders;
+	  }
+	uint32_t p = adjacency::prev(h);
+	if(adj.twin[p] == invalid)
+	  {
+	    const Vertex &b = cage->vertices[e[p]];
+	    border.point += b.point;
+	    border.normal += b.normal;
+	    ++borders;
+	  }
+      }
+    if(borders == 0)
+      {
+	std::size_t n = end - begin;
+	float beta = loopBeta(n), keep = 1.0f - n * beta;
+	out.point = keep * self.point + beta * ring.point;
+	out.normal = normalized(keep * self.normal + beta * ring.normal, self.normal);
+      }
+    else if(borders == 2)
+      {
+	out.point = 0.75f * self.point + 0.125f * border.point;
+	out.normal = normalized(0.75f * self.normal + 0.125f * border.normal, self.normal);
+      }
+  }
+
+  /**
+   * Odd stencil: 3/8 of the edge's ends plus 1/8 of the two
+   * opposite corners, the midpoint on a boundary.
+   */
+  void loopSubdivision::writeEdge(uint32_t h, Vertex &out) const
+  {
+    const std::vector<GLuint> &e = cage->elements;
+    const Vertex &a = cage->vertices[e[h]];
+    const Vertex &b = cage->vertices[e[adjacency::next(h)]];
+    uint32_t t = adj.twin[h];
+    if(t == invalid)
+      {
+	out.point = 0.5f * (a.point + b.point);
+	out.normal = normalized(a.normal + b.normal, a.normal);
+	return;
+      }
+    const Vertex &c = cage->vertices[e[adjacency::prev(h)]];
+    const Vertex &d = cage->vertices[e[adjacency::prev(t)]];
+    out.point = 0.375f * (a.point + b.point) + 0.125f * (c.point + d.point);
+    out.normal = normalized(0.375f * (a.normal + b.normal) + 0.125f * (c.normal + d.normal),
+			    a.normal);
+  }
+
+  /**
+   * Split face f along its new edge vertices, keeping the
+   * winding: 1:4 with all three, otherwise rotated so the
+   * split edges come first.
+   */
+  void loopSubdivision::writeFace(uint32_t f, GLuint *out) const
+  {
+    const GLuint *v = &cage->elements[3 * f];
+    const uint32_t *m = &edgeVertex[3 * f];
+    int split = (m[0] != invalid) + (m[1] != invalid) + (m[2] != invalid);
+    auto emit = [&out](GLuint a, GLuint b, GLuint c) {
+      out[0] = a;
+      out[1] = b;
+      out[2] = c;
+      out += 3;
+    };
+    if(split == 0)
+      {
+	emit(v[0], v[1], v[2]);
+      }
+    else if(split == 3)
+      {
+	emit(v[0], m[0], m[2]);
+	emit(m[0], v[1], m[1]);
+	emit(m[2], m[1], v[2]);
+	emit(m[0], m[1], m[2]);
+      }
+    else if(split == 1)
+      {
+	int r = m[0] != invalid ? 0 : m[1] != invalid ? 1 : 2;
+	GLuint a = v[r], b = v[(r + 1) % 3], c = v[(r + 2) % 3];
+	emit(a, m[r], c);
+	emit(m[r], b, c);
+      }
+    else
+      {
+	// The unsplit edge becomes c-a
+	int s = (m[0] == invalid ? 1 : m[1] == invalid ? 2 : 0);
+	GLuint a = v[s], b = v[(s + 1) % 3], c = v[(s + 2) % 3];
+	GLuint ab = m[s], bc = m[(s + 1) % 3];
+	emit(ab, b, bc);
+	emit(a, ab, bc);
+	emit(a, bc, c);
+      }
+  }
+
+  void loopSubdivision::write(Vertex *outVertices, GLuint *outElements) const
+  {
+    std::size_t faces = refine.size();
+    parallelFor(0, cage->vertices.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t v = lo; v < hi; ++v)
+	  {
+	    writeVertex(static_cast<uint32_t>(v), outVertices[v]);
+	  }
+      });
+    parallelFor(0, 3 * faces, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t h = lo; h < hi; ++h)
+	  {
+	    uint32_t t = adj.twin[h];
+	    if(edgeVertex[h] != invalid && (t == invalid || h < t))
+	      {
+		writeEdge(static_cast<uint32_t>(h), outVertices[edgeVertex[h]]);
+	      }
+	  }
+      });
+    parallelFor(0, faces, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t f = lo; f < hi; ++f)
+	  {
+	    writeFace(static_cast<uint32_t>(f), outElements + 3 * std::size_t(firstTriangle[f]));
+	  }
+      });
+  }
+
+  subdivisionStats subdivide(mesh &m, const subdivisionOptions &options)
+  {
+    subdivisionStats stats;
+    stats.trianglesBefore = m.elements.size() / 3;
+    auto start = std::chrono::steady_clock::now();
+    loopSubdivision level;
+    for(int i = 0; i < options.levels; ++i)
+      {
+	if(level.prepare(m, options) == 0)
+	  {
+	    break;
+	  }
+	mesh out;
+	out.vertices.resize(level.vertexCount());
+	out.elements.resize(level.elementCount());
+	level.write(out.vertices.data(), out.elements.data());
+	for(materialRange &r : m.materialRanges)
+	  {
+	    GLuint last = r.first + r.count;
+	    r.first = 3 * level.faceOffset(r.first / 3);
+	    r.count = 3 * level.faceOffset(last / 3) - r.first;
+	  }
+	out.materials = std::move(m.materials);
+	out.materialRanges = std::move(m.materialRanges);
+	m = std::move(out);
+	++stats.levels;
+      }
+    stats.trianglesAfter = m.elements.size() / 3;
+    stats.seconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+    return stats;
+  }
+
+  subdivisionStats uploadSubdivided(const mesh &cage, const subdivisionOptions &options)
+  {
+    subdivisionStats stats;
+    stats.trianglesBefore = cage.elements.size() / 3;
+    auto start = std::chrono::steady_clock::now();
+    loopSubdivision level;
+    mesh scratch;
+    const mesh *source = &cage;
+    bool pending = false;       // level prepared, not yet written
+    for(int i = 0; i < options.levels; ++i)
+      {
+	if(level.prepare(*source, options) == 0)
+	  {
+	    break;
+	  }
+	++stats.levels;
+	if(i + 1 == options.levels)
+	  {
+	    pending = true;
+	    break;
+	  }
+	mesh out;
+	out.vertices.resize(level.vertexCount());
+	out.elements.resize(level.elementCount());
+	level.write(out.vertices.data(), out.elements.data());
+	scratch = std::move(out);
+	source = &scratch;
+      }
+
+    Vertex *vertices = nullptr;
+    GLuint *elements = nullptr;
+    if(pending)
+      {
+	std::size_t vertexBytes = level.vertexCount() * sizeof(Vertex);
+	std::size_t elementBytes = level.elementCount() * sizeof(GLuint);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementBytes, nullptr, GL_STATIC_DRAW);
+	GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+	vertices = static_cast<Vertex *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes, access));
+	elements = static_cast<GLuint *>(glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0,
+							  elementBytes, access));
+	if(vertices && elements)
+	  {
+	    level.write(vertices, elements);
+	    stats.trianglesAfter = level.elementCount() / 3;
+	  }
+	if(vertices)
+	  {
+	    glUnmapBuffer(GL_ARRAY_BUFFER);
+	  }
+	if(elements)
+	  {
+	    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+	  }
+	if(!vertices || !elements)
+	  {
+	    // No mapping: finish in memory and upload that
+	    LOG("[Error] glMapBufferRange failed, uploading a copy\n");
+	    mesh out;
+	    out.vertices.resize(level.vertexCount());
+	    out.elements.resize(level.elementCount());
+	    level.write(out.vertices.data(), out.elements.data());
+	    scratch = std::move(out);
+	    source = &scratch;
+	    pending = false;
+	  }
+      }
+    if(!pending)
+      {
+	glBufferData(GL_ARRAY_BUFFER, source->vertices.size() * sizeof(Vertex),
+		     source->vertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, source->elements.size() * sizeof(GLuint),
+		     source->elements.data(), GL_STATIC_DRAW);
+	stats.trianglesAfter = source->elements.size() / 3;
+      }
+    stats.seconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+    return stats;
+  }
+
+} /* End twg namespace */
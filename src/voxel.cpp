@@ -0,0 +1,949 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <voxel.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace twg {
+
+  using svo = sparseVoxelOctree;
+
+  static inline uint32_t compactBits(uint64_t v)
+  {
+    v &= 0x1249249249249249ull;
+    v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3ull;
+    v = (v ^ (v >> 4)) & 0x100f00f00f00f00full;
+    v = (v ^ (v >> 8)) & 0x1f0000ff0000ffull;
+    v = (v ^ (v >> 16)) & 0x1f00000000ffffull;
+    v = (v ^ (v >> 32)) & 0x1fffff;
+    return static_cast<uint32_t>(v);
+  }
+
+  bool svo::get(uint32_t x, uint32_t y, uint32_t z) const
+  {
+    if(rootState != ROOT_PARTIAL)
+      {
+	return rootState == ROOT_FULL && x < resolution && y < resolution
+	  && z < resolution;
+      }
+    if(x >= resolution || y >= resolution || z >= resolution)
+      {
+	return false;
+      }
+    uint32_t bx = x >> brickShift, by = y >> brickShift, bz = z >> brickShift;
+    uint32_t index = 0;
+    for(uint32_t level = 0; level < levels; ++level)
+      {
+	uint32_t shift = levels - 1 - level;
+	uint32_t bit = ((bx >> shift) & 1) | ((by >> shift) & 1) << 1
+	  | ((bz >> shift) & 1) << 2;
+	const node &n = nodes[index];
+	if(n.fullMask & (1u << bit))
+	  {
+	    return true;
+	  }
+	if(!(n.childMask & (1u << bit)))
+	  {
+	    return false;
+	  }
+	index = n.firstChild + __builtin_popcount(n.childMask & ((1u << bit) - 1));
+      }
+    const uint32_t *words = &bricks[std::size_t(index) * brickWords];
+    uint32_t lx = x & (brickSize - 1), ly = y & (brickSize - 1);
+    uint32_t lz = z & (brickSize - 1);
+    return (words[lz * brickSize + ly] >> lx) & 1;
+  }
+
+  /**
+   * Occupancy of the voxel box [lo,hi] (inclusive, clamped):
+   * ROOT_EMPTY, ROOT_FULL, or ROOT_PARTIAL when mixed.  Partial
+   * bricks are reported as mixed without looking at their bits.
+   */
+  uint8_t svo::regionState(glm::ivec3 lo, glm::ivec3 hi) const
+  {
+    lo = glm::max(lo, glm::ivec3(0));
+    hi = glm::min(hi, glm::ivec3(resolution - 1));
+    if(rootState != ROOT_PARTIAL || glm::any(glm::greaterThan(lo, hi)))
+      {
+	return rootState;
+      }
+    glm::ivec3 blo = lo >> int(brickShift), bhi = hi >> int(brickShift);
+    bool empty = false, full = false;
+    std::function<bool(uint32_t, uint32_t, glm::ivec3)> visit =
+      [&](uint32_t index, uint32_t level, glm::ivec3 at) {
+      const node &n = nodes[index];
+      int half = 1 << (levels - 1 - level);
+      uint32_t child = n.firstChild;
+      for(uint32_t bit = 0; bit < 8; ++bit)
+	{
+	  glm::ivec3 c = at + half * glm::ivec3(bit & 1, (bit >> 1) & 1,
+						 (bit >> 2) & 1);
+	  bool partial = (n.childMask >> bit) & 1;
+	  bool overlaps = glm::all(glm::lessThanEqual(c, bhi))
+	    && glm::all(glm::greaterThan(c + half, blo));
+	  if(overlaps)
+	    {
+	      if(partial)
+		{
+		  if(level + 1 == levels || visit(child, level + 1, c))
+		    {
+		      return true;
+		    }
+		}
+	      else if((n.fullMask >> bit) & 1)
+		{
+		  full = true;
+		}
+	      else
+		{
+		  empty = true;
+		}
+	      if(empty && full)
+		{
+		  return true;
+		}
+	    }
+	  child += partial;
+	}
+      return false;
+    };
+    if(levels == 0 || visit(0, 0, glm::ivec3(0)))
+      {
+	return ROOT_PARTIAL;
+      }
+    return full ? ROOT_FULL : ROOT_EMPTY;
+  }
+
+  void svo::forEachBrick(const std::function<void(glm::uvec3, uint32_t,
+						  const uint32_t *)> &fn) const
+  {
+    if(rootState == ROOT_EMPTY)
+      {
+	return;
+      }
+    uint32_t side = resolution >> brickShift;
+    if(rootState == ROOT_FULL)
+      {
+	fn(glm::uvec3(0), side, nullptr);
+	return;
+      }
+    std::function<void(uint32_t, uint32_t, glm::uvec3)> visit =
+      [&](uint32_t index, uint32_t level, glm::uvec3 at) {
+      if(level == levels)
+	{
+	  fn(at, 1, &bricks[std::size_t(index) * brickWords]);
+	  return;
+	}
+      const node &n = nodes[index];
+      uint32_t half = 1u << (levels - 1 - level);
+      uint32_t child = n.firstChild;
+      for(uint32_t bit = 0; bit < 8; ++bit)
+	{
+	  glm::uvec3 c = at + half * glm::uvec3(bit & 1, (bit >> 1) & 1,
+						 (bit >> 2) & 1);
+	  if(n.fullMask & (1u << bit))
+	    {
+	      fn(c, half, nullptr);
+	    }
+	  else if(n.childMask & (1u << bit))
+	    {
+	      visit(child++, level + 1, c);
+	    }
+	}
+    };
+    visit(0, 0, glm::uvec3(0));
+  }
+
+  std::size_t svo::voxelCount() const
+  {
+    std::size_t count = 0;
+    forEachBrick([&](glm::uvec3, uint32_t side, const uint32_t *words) {
+	if(!words)
+	  {
+	    std::size_t edge = std::size_t(side) * brickSize;
+	    count += edge * edge * edge;
+	    return;
+	  }
+	for(uint32_t i = 0; i < brickWords; ++i)
+	  {
+	    count += __builtin_popcount(words[i]);
+	  }
+      });
+    return count;
+  }
+
+  /**
+   * Triangle/box overlap by the separating axis theorem
+   * (Akenine-Moller): 9 edge cross axes, the 3 box normals and
+   * the triangle normal.  Box is centered at c with half size h.
+   */
+  static bool triBoxOverlap(const glm::vec3 &c, float h, const glm::vec3 tri[3])
+  {
+    glm::vec3 v0 = tri[0] - c, v1 = tri[1] - c, v2 = tri[2] - c;
+    glm::vec3 e[3] = {v1 - v0, v2 - v1, v0 - v2};
+    for(int i = 0; i < 3; ++i)
+      {
+	for(int a = 0; a < 3; ++a)
+	  {
+	    glm::vec3 axis{0.0f};
+	    axis[(a + 1) % 3] = -e[i][(a + 2) % 3];
+	    axis[(a + 2) % 3] = e[i][(a + 1) % 3];
+	    float p0 = glm::dot(v0, axis), p1 = glm::dot(v1, axis);
+	    float p2 = glm::dot(v2, axis);
+	    float r = h * (std::fabs(axis.x) + std::fabs(axis.y) + std::fabs(axis.z));
+	    if(std::min({p0, p1, p2}) > r || std::max({p0, p1, p2}) < -r)
+	      {
+		return false;
+	      }
+	  }
+      }
+    for(int a = 0; a < 3; ++a)
+      {
+	if(std::min({v0[a], v1[a], v2[a]}) > h || std::max({v0[a], v1[a], v2[a]}) < -h)
+	  {
+	    return false;
+	  }
+      }
+    glm::vec3 n = glm::cross(e[0], e[1]);
+    float r = h * (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    return std::fabs(glm::dot(n, v0)) <= r;
+  }
+
+  struct voxelTri {
+    glm::vec3 v[3];
+    glm::vec3 lo;
+    glm::vec3 hi;
+  };
+
+  struct voxelBrick {
+    uint64_t key;
+    bool full;
+    std::vector<uint32_t> words;
+  };
+
+  static bool allSet(const uint32_t *words)
+  {
+    for(uint32_t i = 0; i < svo::brickWords; ++i)
+      {
+	if(words[i] != ~0u)
+	  {
+	    return false;
+	  }
+      }
+    return true;
+  }
+
+  static bool anySet(const uint32_t *words)
+  {
+    for(uint32_t i = 0; i < svo::brickWords; ++i)
+      {
+	if(words[i])
+	  {
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  /**
+   * Conservative surface voxels of one triangle inside one
+   * brick.  Rows along x are first clipped to the voxels the
+   * triangle plane passes through, only those get the full
+   * overlap test.
+   */
+  static void surfaceVoxels(const voxelTri &t, glm::ivec3 brickMin,
+			    uint32_t *words)
+  {
+    const int B = svo::brickSize;
+    glm::ivec3 lo = glm::max(glm::ivec3(glm::floor(t.lo)), brickMin);
+    glm::ivec3 hi = glm::min(glm::ivec3(glm::floor(t.hi)), brickMin + B - 1);
+    glm::vec3 n = glm::cross(t.v[1] - t.v[0], t.v[2] - t.v[0]);
+    float d = glm::dot(n, t.v[0]);
+    float r = 0.5f * (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    const float h = 0.5f + 1e-4f;
+    for(int z = lo.z; z <= hi.z; ++z)
+      {
+	for(int y = lo.y; y <= hi.y; ++y)
+	  {
+	    float k = n.y * (y + 0.5f) + n.z * (z + 0.5f);
+	    int x0 = lo.x, x1 = hi.x;
+	    if(std::fabs(n.x) > 1e-12f)
+	      {
+		float a = (d - k - r) / n.x, b = (d - k + r) / n.x;
+		if(a > b)
+		  {
+		    std::swap(a, b);
+		  }
+		x0 = std::max(x0, static_cast<int>(std::floor(a - 0.5f)));
+		x1 = std::min(x1, static_cast<int>(std::ceil(b - 0.5f)));
+	      }
+	    else if(std::fabs(k - d) > r)
+	      {
+		continue;
+	      }
+	    uint32_t &word = words[(z - brickMin.z) * B + (y - brickMin.y)];
+	    for(int x = x0; x <= x1; ++x)
+	      {
+		if(triBoxOverlap(glm::vec3(x + 0.5f, y + 0.5f, z + 0.5f), h, t.v))
+		  {
+		    word |= 1u << (x - brickMin.x);
+		  }
+	      }
+	  }
+      }
+  }
+
+  /**
+   * Bin triangles to the cells (bricks or brick columns) their
+   * bounds overlap, as (cell key, triangle) pairs sorted by key.
+   * Counting and filling run in parallel, the sort on the key.
+   */
+  template <typename Cells>
+  static std::vector<std::pair<uint64_t, uint32_t>>
+  binTriangles(const std::vector<voxelTri> &tris, Cells cells)
+  {
+    std::vector<std::size_t> offsets(tris.size() + 1, 0);
+    parallelFor(0, tris.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    offsets[i + 1] = cells(tris[i], nullptr);
+	  }
+      });
+    for(std::size_t i = 0; i < tris.size(); ++i)
+      {
+	offsets[i + 1] += offsets[i];
+      }
+    std::vector<std::pair<uint64_t, uint32_t>> pairs(offsets.back());
+    parallelFor(0, tris.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    std::size_t at = offsets[i];
+	    cells(tris[i], [&](uint64_t key) {
+		pairs[at++] = {key, static_cast<uint32_t>(i)};
+	      });
+	  }
+      });
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+  }
+
+  /**
+   * Start index of every run of equal keys, plus pairs.size().
+   */
+  static std::vector<std::size_t>
+  keyRuns(const std::vector<std::pair<uint64_t, uint32_t>> &pairs)
+  {
+    std::vector<std::size_t> runs;
+    for(std::size_t i = 0; i < pairs.size(); ++i)
+      {
+	if(i == 0 || pairs[i].first != pairs[i - 1].first)
+	  {
+	    runs.push_back(i);
+	  }
+      }
+    runs.push_back(pairs.size());
+    return runs;
+  }
+
+  static std::vector<voxelBrick>
+  surfacePass(const std::vector<voxelTri> &tris, uint32_t bricksPerAxis)
+  {
+    int maxBrick = static_cast<int>(bricksPerAxis) - 1;
+    auto pairs = binTriangles(tris, [&](const voxelTri &t,
+					std::function<void(uint64_t)> emit) {
+	glm::ivec3 lo = glm::clamp(glm::ivec3(glm::floor(t.lo)) >> int(svo::brickShift),
+				   0, maxBrick);
+	glm::ivec3 hi = glm::clamp(glm::ivec3(glm::floor(t.hi)) >> int(svo::brickShift),
+				   0, maxBrick);
+	if(!emit)
+	  {
+	    glm::ivec3 n = hi - lo + 1;
+	    return std::size_t(n.x) * n.y * n.z;
+	  }
+	for(int z = lo.z; z <= hi.z; ++z)
+	  for(int y = lo.y; y <= hi.y; ++y)
+	    for(int x = lo.x; x <= hi.x; ++x)
+	      emit(mortonKey(x, y, z));
+	return std::size_t(0);
+      });
+    std::vector<std::size_t> runs = keyRuns(pairs);
+
+    // One task per brick on the work stealing pool
+    std::vector<voxelBrick> out(runs.size() - 1);
+    threadPool &pool = threadPool::shared();
+    taskGroup group;
+    for(std::size_t r = 0; r + 1 < runs.size(); ++r)
+      {
+	pool.run(group, [&, r] {
+	    uint64_t key = pairs[runs[r]].first;
+	    glm::ivec3 brickMin = glm::ivec3(compactBits(key), compactBits(key >> 1),
+					     compactBits(key >> 2)) * int(svo::brickSize);
+	    voxelBrick &b = out[r];
+	    b.key = key;
+	    b.words.assign(svo::brickWords, 0);
+	    for(std::size_t i = runs[r]; i < runs[r + 1]; ++i)
+	      {
+		surfaceVoxels(tris[pairs[i].second], brickMin, b.words.data());
+	      }
+	    b.full = allSet(b.words.data());
+	    if(b.full || !anySet(b.words.data()))
+	      {
+		b.words.clear();
+		b.words.shrink_to_fit();
+	      }
+	  });
+      }
+    pool.wait(group);
+    out.erase(std::remove_if(out.begin(), out.end(), [](const voxelBrick &b) {
+	  return !b.full && b.words.empty();
+	}), out.end());
+    return out;
+  }
+
+  /**
+   * Set voxels [x0,x1] of one row spread over a run of bricks.
+   */
+  static void fillRow(uint32_t *columnWords, uint32_t row, int x0, int x1)
+  {
+    const int B = svo::brickSize;
+    while(x0 <= x1)
+      {
+	int brick = x0 / B;
+	int first = x0 % B;
+	int last = std::min(x1, brick * B + B - 1) % B;
+	uint32_t mask = (last == 31 ? ~0u : (1u << (last + 1)) - 1) & ~((1u << first) - 1);
+	columnWords[std::size_t(brick) * svo::brickWords + row] |= mask;
+	x0 = brick * B + B;
+      }
+  }
+
+  /**
+   * Solid voxelization by scanline parity: each brick column
+   * along x is a task casting one ray per voxel row through the
+   * triangles binned to it, filling between pairs of crossings.
+   * The rays are offset by a small irrational amount so they
+   * do not graze shared edges.  The surface shell is merged in
+   * so thin parts stay connected.
+   */
+  static std::vector<voxelBrick>
+  solidPass(const std::vector<voxelTri> &tris, uint32_t bricksPerAxis,
+	    const std::vector<voxelBrick> &surface)
+  {
+    const int B = svo::brickSize;
+    int maxBrick = static_cast<int>(bricksPerAxis) - 1;
+    auto pairs = binTriangles(tris, [&](const voxelTri &t,
+					std::function<void(uint64_t)> emit) {
+	int y0 = glm::clamp(static_cast<int>(std::floor(t.lo.y)) >> int(svo::brickShift), 0, maxBrick);
+	int y1 = glm::clamp(static_cast<int>(std::floor(t.hi.y)) >> int(svo::brickShift), 0, maxBrick);
+	int z0 = glm::clamp(static_cast<int>(std::floor(t.lo.z)) >> int(svo::brickShift), 0, maxBrick);
+	int z1 = glm::clamp(static_cast<int>(std::floor(t.hi.z)) >> int(svo::brickShift), 0, maxBrick);
+	if(!emit)
+	  {
+	    return std::size_t(y1 - y0 + 1) * (z1 - z0 + 1);
+	  }
+	for(int z = z0; z <= z1; ++z)
+	  for(int y = y0; y <= y1; ++y)
+	    emit(uint64_t(z) << 21 | uint64_t(y));
+	return std::size_t(0);
+      });
+    std::vector<std::size_t> runs = keyRuns(pairs);
+
+    std::vector<std::vector<voxelBrick>> columns(runs.size() - 1);
+    threadPool &pool = threadPool::shared();
+    taskGroup group;
+    for(std::size_t r = 0; r + 1 < runs.size(); ++r)
+      {
+	pool.run(group, [&, r] {
+	    uint64_t key = pairs[runs[r]].first;
+	    uint32_t by = key & 0x1fffff, bz = static_cast<uint32_t>(key >> 21);
+	    std::vector<uint32_t> words(std::size_t(bricksPerAxis) * svo::brickWords, 0);
+	    std::vector<float> hits;
+	    for(int lz = 0; lz < B; ++lz)
+	      {
+		for(int ly = 0; ly < B; ++ly)
+		  {
+		    float y = by * B + ly + 0.5f + 1.4142135e-4f;
+		    float z = bz * B + lz + 0.5f + 1.7320508e-4f;
+		    hits.clear();
+		    for(std::size_t i = runs[r]; i < runs[r + 1]; ++i)
+		      {
+			const voxelTri &t = tris[pairs[i].second];
+			if(y < t.lo.y || y > t.hi.y || z < t.lo.z || z > t.hi.z)
+			  {
+			    continue;
+			  }
+			// Barycentrics of the ray in the triangle's yz projection
+			const glm::vec3 &a = t.v[0], &b = t.v[1], &c = t.v[2];
+			float w0 = (b.y - y) * (c.z - z) - (c.y - y) * (b.z - z);
+			float w1 = (c.y - y) * (a.z - z) - (a.y - y) * (c.z - z);
+			float w2 = (a.y - y) * (b.z - z) - (b.y - y) * (a.z - z);
+			if(!((w0 > 0 && w1 > 0 && w2 > 0) || (w0 < 0 && w1 < 0 && w2 < 0)))
+			  {
+			    continue;
+			  }
+			float sum = w0 + w1 + w2;
+			hits.push_back((w0 * a.x + w1 * b.x + w2 * c.x) / sum);
+		      }
+		    std::sort(hits.begin(), hits.end());
+		    for(std::size_t h = 0; h + 1 < hits.size(); h += 2)
+		      {
+			int x0 = std::max(0, static_cast<int>(std::ceil(hits[h] - 0.5f)));
+			int x1 = std::min(static_cast<int>(bricksPerAxis) * B - 1,
+					  static_cast<int>(std::ceil(hits[h + 1] - 0.5f)) - 1);
+			if(x0 <= x1)
+			  {
+			    fillRow(words.data(), lz * B + ly, x0, x1);
+			  }
+		      }
+		  }
+	      }
+	    std::vector<voxelBrick> &out = columns[r];
+	    for(uint32_t bx = 0; bx < bricksPerAxis; ++bx)
+	      {
+		uint32_t *w = &words[std::size_t(bx) * svo::brickWords];
+		uint64_t k = mortonKey(bx, by, bz);
+		auto s = std::lower_bound(surface.begin(), surface.end(), k,
+					  [](const voxelBrick &v, uint64_t k) {
+					    return v.key < k;
+					  });
+		if(s != surface.end() && s->key == k)
+		  {
+		    if(s->full)
+		      {
+			std::fill(w, w + svo::brickWords, ~0u);
+		      }
+		    else
+		      {
+			for(uint32_t i = 0; i < svo::brickWords; ++i)
+			  {
+			    w[i] |= s->words[i];
+			  }
+		      }
+		  }
+		if(allSet(w))
+		  {
+		    out.push_back(voxelBrick{k, true, {}});
+		  }
+		else if(anySet(w))
+		  {
+		    out.push_back(voxelBrick{k, false,
+			  std::vector<uint32_t>(w, w + svo::brickWords)});
+		  }
+	      }
+	  });
+      }
+    pool.wait(group);
+
+    std::vector<voxelBrick> out;
+    for(auto &column : columns)
+      {
+	for(auto &b : column)
+	  {
+	    out.push_back(std::move(b));
+	  }
+      }
+    std::sort(out.begin(), out.end(), [](const voxelBrick &a, const voxelBrick &b) {
+	return a.key < b.key;
+      });
+    return out;
+  }
+
+  /**
+   * Build the node levels bottom-up from Morton sorted bricks.
+   * Siblings are adjacent in Morton order, so each parent's
+   * children end up contiguous; eight full children collapse
+   * into a full parent.
+   */
+  static void buildOctree(svo &tree, std::vector<voxelBrick> &bricks)
+  {
+    struct item { uint64_t key; bool full; uint32_t index; };
+    std::vector<item> current;
+    current.reserve(bricks.size());
+    for(voxelBrick &b : bricks)
+      {
+	uint32_t index = 0;
+	if(!b.full)
+	  {
+	    index = static_cast<uint32_t>(tree.bricks.size() / svo::brickWords);
+	    tree.bricks.insert(tree.bricks.end(), b.words.begin(), b.words.end());
+	    std::vector<uint32_t>().swap(b.words);
+	  }
+	current.push_back(item{b.key, b.full, index});
+      }
+
+    std::vector<std::vector<svo::node>> levels; // bottom-up
+    for(uint32_t level = 0; level < tree.levels; ++level)
+      {
+	std::vector<item> parents;
+	std::vector<svo::node> stored;
+	for(std::size_t i = 0; i < current.size();)
+	  {
+	    uint64_t parent = current[i].key >> 3;
+	    svo::node n{0, 0, 0, 0};
+	    bool first = true;
+	    for(; i < current.size() && current[i].key >> 3 == parent; ++i)
+	      {
+		uint32_t bit = current[i].key & 7;
+		if(current[i].full)
+		  {
+		    n.fullMask |= 1u << bit;
+		    continue;
+		  }
+		if(first)
+		  {
+		    n.firstChild = current[i].index;
+		    first = false;
+		  }
+		n.childMask |= 1u << bit;
+	      }
+	    if(n.fullMask == 0xff)
+	      {
+		parents.push_back(item{parent, true, 0});
+	      }
+	    else
+	      {
+		parents.push_back(item{parent, false,
+		      static_cast<uint32_t>(stored.size())});
+		stored.push_back(n);
+	      }
+	  }
+	levels.push_back(std::move(stored));
+	current.swap(parents);
+      }
+
+    if(current.empty())
+      {
+	tree.rootState = svo::ROOT_EMPTY;
+	tree.bricks.clear();
+	return;
+      }
+    tree.rootState = current[0].full ? svo::ROOT_FULL : svo::ROOT_PARTIAL;
+    if(tree.rootState == svo::ROOT_FULL)
+      {
+	tree.bricks.clear();
+	return;
+      }
+
+    // Flatten top-down, children offsets move by their level start
+    std::size_t offset = 0;
+    for(std::size_t l = levels.size(); l-- > 0;)
+      {
+	std::size_t childOffset = offset + levels[l].size();
+	for(svo::node n : levels[l])
+	  {
+	    if(l > 0)
+	      {
+		n.firstChild += static_cast<uint32_t>(childOffset);
+	      }
+	    tree.nodes.push_back(n);
+	  }
+	offset = childOffset;
+      }
+  }
+
+  /**
+   * Static utility voxelize a mesh into a sparse voxel octree
+   * of resolution^3 voxels over its bounding cube.
+   */
+  sparseVoxelOctree voxelize(const mesh &m, uint32_t resolution, voxelMode mode)
+  {
+    svo tree;
+    tree.resolution = svo::brickSize;
+    while(tree.resolution < resolution)
+      {
+	tree.resolution <<= 1;
+      }
+    uint32_t bricksPerAxis = tree.resolution >> svo::brickShift;
+    while((1u << tree.levels) < bricksPerAxis)
+      {
+	++tree.levels;
+      }
+    if(m.vertices.empty() || m.elements.size() < 3)
+      {
+	return tree;
+      }
+
+    glm::vec3 lo{FLT_MAX}, hi{-FLT_MAX};
+    for(const Vertex &v : m.vertices)
+      {
+	lo = glm::min(lo, v.point);
+	hi = glm::max(hi, v.point);
+      }
+    float size = std::max(1e-6f, glm::max(hi.x - lo.x, glm::max(hi.y - lo.y, hi.z - lo.z)));
+    size *= 1.0f + 4.0f / tree.resolution; // keep the shell off the border
+    tree.voxelSize = size / tree.resolution;
+    tree.origin = 0.5f * (lo + hi) - glm::vec3(0.5f * size);
+
+    std::vector<voxelTri> tris(m.elements.size() / 3);
+    parallelFor(0, tris.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    voxelTri &t = tris[i];
+	    for(int k = 0; k < 3; ++k)
+	      {
+		t.v[k] = (m.vertices[m.elements[3 * i + k]].point - tree.origin)
+		  / tree.voxelSize;
+	      }
+	    t.lo = glm::min(t.v[0], glm::min(t.v[1], t.v[2]));
+	    t.hi = glm::max(t.v[0], glm::max(t.v[1], t.v[2]));
+	  }
+      });
+
+    std::vector<voxelBrick> bricks = surfacePass(tris, bricksPerAxis);
+    if(mode == voxelMode::solid)
+      {
+	bricks = solidPass(tris, bricksPerAxis, bricks);
+      }
+    buildOctree(tree, bricks);
+    return tree;
+  }
+
+  /**
+   * Compact binary format (.svo), little endian:
+   *
+   * char[4] "SVO1", uint32 resolution, uint32 levels,
+   * float origin[3], float voxelSize, uint32 rootState,
+   * uint32 nodeCount, uint32 brickCount,
+   * node[nodeCount], uint32[brickCount * brickWords]
+   */
+  bool svo::save(const std::string &filename) const
+  {
+    std::ofstream out{filename, ios::out | ios::binary};
+    if (!out) {
+      LOG("[Error] Not able to write: ");
+      LOG(filename); LOG("\n");
+      return false;
+    }
+    uint32_t dims[2] = {resolution, levels};
+    uint32_t counts[3] = {rootState, static_cast<uint32_t>(nodes.size()),
+			  static_cast<uint32_t>(brickCount())};
+    out.write("SVO1", 4);
+    out.write(reinterpret_cast<const char *>(dims), sizeof(dims));
+    out.write(reinterpret_cast<const char *>(&origin.x), 3 * sizeof(float));
+    out.write(reinterpret_cast<const char *>(&voxelSize), sizeof(float));
+    out.write(reinterpret_cast<const char *>(counts), sizeof(counts));
+    out.write(reinterpret_cast<const char *>(nodes.data()), nodes.size() * sizeof(node));
+    out.write(reinterpret_cast<const char *>(bricks.data()),
+	      bricks.size() * sizeof(uint32_t));
+    return static_cast<bool>(out);
+  }
+
+  /**
+   * Everything read is checked before it is used: the header
+   * against the file length, and each node level's partial
+   * children against the level after it (or the bricks), so
+   * lookups never index out of the arrays.
+   */
+  bool svo::load(const std::string &filename)
+  {
+    std::ifstream in{filename, ios::in | ios::binary};
+    char magic[4];
+    uint32_t header[5];
+    if (!in.read(magic, 4) || std::memcmp(magic, "SVO1", 4) != 0) {
+      LOG("[Error] Not a voxel octree: ");
+      LOG(filename); LOG("\n");
+      return false;
+    }
+    in.read(reinterpret_cast<char *>(header), 2 * sizeof(uint32_t));
+    in.read(reinterpret_cast<char *>(&origin.x), 3 * sizeof(float));
+    in.read(reinterpret_cast<char *>(&voxelSize), sizeof(float));
+    in.read(reinterpret_cast<char *>(header + 2), 3 * sizeof(uint32_t));
+    std::size_t at = in.tellg();
+    in.seekg(0, ios::end);
+    std::size_t remaining = in ? std::size_t(in.tellg()) - at : 0;
+    in.seekg(at);
+    uint32_t nodeCount = header[3], brickTotal = header[4];
+    bool valid = static_cast<bool>(in) && header[1] <= 16
+      && header[0] == brickSize << header[1] && header[2] <= ROOT_FULL
+      && std::size_t(nodeCount) * sizeof(node)
+         + std::size_t(brickTotal) * brickWords * sizeof(uint32_t) <= remaining;
+    if (valid) {
+      resolution = header[0];
+      levels = header[1];
+      rootState = static_cast<uint8_t>(header[2]);
+      nodes.resize(nodeCount);
+      bricks.resize(std::size_t(brickTotal) * brickWords);
+      in.read(reinterpret_cast<char *>(nodes.data()), nodes.size() * sizeof(node));
+      in.read(reinterpret_cast<char *>(bricks.data()), bricks.size() * sizeof(uint32_t));
+      valid = static_cast<bool>(in);
+    }
+    if (valid && rootState == ROOT_PARTIAL) {
+      // Level by level from the root: children of [first, end)
+      // must fall in the next level, which starts at end
+      std::size_t first = 0, end = 1;
+      for (uint32_t level = 0; valid && level <= levels; ++level) {
+	std::size_t limit = level == levels ? brickTotal : nodeCount;
+	if (end > limit) {
+	  valid = false;
+	  break;
+	}
+	if (level == levels) {
+	  break;
+	}
+	std::size_t base = level + 1 == levels ? 0 : end, next = base;
+	for (std::size_t i = first; i < end; ++i) {
+	  const node &n = nodes[i];
+	  if (n.childMask == 0) {
+	    continue;
+	  }
+	  std::size_t childEnd = std::size_t(n.firstChild) + __builtin_popcount(n.childMask);
+	  if (n.firstChild < base || childEnd > (level + 1 == levels ? brickTotal : nodeCount)) {
+	    valid = false;
+	    break;
+	  }
+	  next = std::max(next, childEnd);
+	}
+	first = base;
+	end = next;
+      }
+    }
+    if (!valid) {
+      LOG("[Error] Corrupt voxel octree: ");
+      LOG(filename); LOG("\n");
+      *this = svo{};
+      return false;
+    }
+    return true;
+  }
+
+  static void putInt(std::string &out, int32_t v)
+  {
+    out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+  }
+
+  static void putString(std::string &out, const std::string &s)
+  {
+    putInt(out, static_cast<int32_t>(s.size()));
+    out += s;
+  }
+
+  static void putChunk(std::string &out, const char *id, const std::string &content,
+		       const std::string &children = std::string{})
+  {
+    out.append(id, 4);
+    putInt(out, static_cast<int32_t>(content.size()));
+    putInt(out, static_cast<int32_t>(children.size()));
+    out += content;
+    out += children;
+  }
+
+  /**
+   * MagicaVoxel .vox (version 150).  Volumes above 256^3 are
+   * split into 256^3 models placed by a transform/group/shape
+   * scene graph.  MagicaVoxel is z-up, so y and z swap.
+   */
+  bool svo::saveVox(const std::string &filename) const
+  {
+    const std::size_t voxLimit = std::size_t(1) << 26;
+    std::size_t total = voxelCount();
+    if (total > voxLimit) {
+      LOG("[Error] "); LOG(total);
+      LOG(" voxels is too many for .vox, use .svo\n");
+      return false;
+    }
+    const uint32_t modelSize = std::min<uint32_t>(256, resolution);
+    const uint32_t perAxis = resolution / modelSize;
+    std::vector<std::string> models(std::size_t(perAxis) * perAxis * perAxis);
+    auto emit = [&](uint32_t x, uint32_t y, uint32_t z) {
+      uint32_t vx = x, vy = resolution - 1 - z, vz = y;
+      std::string &xyzi = models[(std::size_t(vz / modelSize) * perAxis
+				  + vy / modelSize) * perAxis + vx / modelSize];
+      char v[4] = {static_cast<char>(vx % modelSize), static_cast<char>(vy % modelSize),
+		   static_cast<char>(vz % modelSize), 1};
+      xyzi.append(v, 4);
+    };
+    forEachBrick([&](glm::uvec3 at, uint32_t side, const uint32_t *words) {
+	glm::uvec3 base = at * brickSize;
+	uint32_t edge = side * brickSize;
+	for(uint32_t z = 0; z < edge; ++z)
+	  for(uint32_t y = 0; y < edge; ++y)
+	    {
+	      uint32_t row = words ? words[z * brickSize + y] : ~0u;
+	      for(uint32_t x = 0; x < edge; ++x)
+		{
+		  if(!words || (row >> x) & 1)
+		    {
+		      emit(base.x + x, base.y + y, base.z + z);
+		    }
+		}
+	    }
+      });
+
+    std::string body, content;
+    std::vector<int32_t> shapes;
+    for(std::size_t i = 0; i < models.size(); ++i)
+      {
+	if(models[i].empty())
+	  {
+	    continue;
+	  }
+	content.clear();
+	putInt(content, modelSize);
+	putInt(content, modelSize);
+	putInt(content, modelSize);
+	putChunk(body, "SIZE", content);
+	content.clear();
+	putInt(content, static_cast<int32_t>(models[i].size() / 4));
+	content += models[i];
+	putChunk(body, "XYZI", content);
+	shapes.push_back(static_cast<int32_t>(i));
+      }
+
+    // Scene graph: root transform 0 -> group 1 -> (transform, shape) pairs
+    content.clear();
+    putInt(content, 0); putInt(content, 0); putInt(content, 1);
+    putInt(content, -1); putInt(content, -1); putInt(content, 1); putInt(content, 0);
+    putChunk(body, "nTRN", content);
+    content.clear();
+    putInt(content, 1); putInt(content, 0);
+    putInt(content, static_cast<int32_t>(shapes.size()));
+    for(std::size_t s = 0; s < shapes.size(); ++s)
+      {
+	putInt(content, static_cast<int32_t>(2 + 2 * s));
+      }
+    putChunk(body, "nGRP", content);
+    int half = static_cast<int>(resolution / 2);
+    for(std::size_t s = 0; s < shapes.size(); ++s)
+      {
+	int32_t i = shapes[s];
+	int mx = i % perAxis, my = (i / perAxis) % perAxis, mz = i / (perAxis * perAxis);
+	std::ostringstream t;
+	t << mx * int(modelSize) + int(modelSize) / 2 - half << " "
+	  << my * int(modelSize) + int(modelSize) / 2 - half << " "
+	  << mz * int(modelSize) + int(modelSize) / 2;
+	content.clear();
+	putInt(content, static_cast<int32_t>(2 + 2 * s));
+	putInt(content, 0);
+	putInt(content, static_cast<int32_t>(3 + 2 * s));
+	putInt(content, -1); putInt(content, 0); putInt(content, 1);
+	putInt(content, 1); putString(content, "_t"); putString(content, t.str());
+	putChunk(body, "nTRN", content);
+	content.clear();
+	putInt(content, static_cast<int32_t>(3 + 2 * s));
+	putInt(content, 0); putInt(content, 1);
+	putInt(content, static_cast<int32_t>(s)); putInt(content, 0);
+	putChunk(body, "nSHP", content);
+      }
+
+    std::string file{"VOX "};
+    putInt(file, 150);
+    putChunk(file, "MAIN", std::string{}, body);
+    std::ofstream out{filename, ios::out | ios::binary};
+    if (!out) {
+      LOG("[Error] Not able to write: ");
+      LOG(filename); LOG("\n");
+      return false;
+    }
+    out.write(file.data(), file.size());
+    return static_cast<bool>(out);
+  }
+
+} /* End twg namespace */
@@ -0,0 +1,245 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <watch.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace twg {
+
+  /**
+   * Blocks of the common prefix of a and b that differ, merged
+   * into ranges.  The blocks are compared in parallel; a length
+   * change is the caller's to handle.
+   */
+  template <typename T>
+  static std::vector<dirtyRange> diffBlocks(const std::vector<T> &a, const std::vector<T> &b,
+					    std::size_t block)
+  {
+    std::size_t n = std::min(a.size(), b.size());
+    std::size_t blocks = (n + block - 1) / block;
+    std::vector<uint8_t> changed(blocks, 0);
+    parallelFor(0, blocks, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    std::size_t first = i * block;
+	    std::size_t count = std::min(block, n - first);
+	    changed[i] = std::memcmp(a.data() + first, b.data() + first, count * sizeof(T)) != 0;
+	  }
+      });
+    std::vector<dirtyRange> ranges;
+    for(std::size_t i = 0; i < blocks; ++i)
+      {
+	if(!changed[i])
+	  {
+	    continue;
+	  }
+	std::size_t first = i * block, end = std::min(n, first + block);
+	if(!ranges.empty() && ranges.back().end == first)
+	  {
+	    ranges.back().end = end;
+	  }
+	else
+	  {
+	    ranges.push_back(dirtyRange{first, end});
+	  }
+      }
+    return ranges;
+  }
+
+  // Union of two range lists, sorted and coalesced
+  static std::vector<dirtyRange> mergeRanges(std::vector<dirtyRange> a,
+					     const std::vector<dirtyRange> &b)
+  {
+    a.insert(a.end(), b.begin(), b.end());
+    std::sort(a.begin(), a.end(), [](const dirtyRange &x, const dirtyRange &y) {
+	return x.first < y.first;
+      });
+    std::vector<dirtyRange> merged;
+    for(const dirtyRange &r : a)
+      {
+	if(!merged.empty() && r.first <= merged.back().end)
+	  {
+	    merged.back().end = std::max(merged.back().end, r.end);
+	  }
+	else
+	  {
+	    merged.push_back(r);
+	  }
+      }
+    return merged;
+  }
+
+  bool meshWatcher::start(const std::string &filename, const mesh &resident, loader load)
+  {
+    stop();
+    std::size_t slash = filename.find_last_of('/');
+    std::string dir = slash == std::string::npos ? std::string{"."} : filename.substr(0, slash + 1);
+    notify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(notify < 0
+       || ::inotify_add_watch(notify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+      {
+	LOG("[Error] Not able to watch "); LOG(dir); LOG(": "); LOG(std::strerror(errno)); LOG("\n");
+	if(notify >= 0)
+	  {
+	    ::close(notify);
+	    notify = -1;
+	  }
+	return false;
+      }
+    this->filename = filename;
+    this->load = std::move(load);
+    this->resident = std::make_shared<const mesh>(resident);
+    stopping = false;
+    thread = std::thread(&meshWatcher::run, this);
+    LOG("[Ok] Watching "); LOG(filename); LOG(" for changes\n");
+    return true;
+  }
+
+  void meshWatcher::stop()
+  {
+    stopping = true;
+    if(thread.joinable())
+      {
+	thread.join();
+      }
+    if(notify >= 0)
+      {
+	::close(notify);
+	notify = -1;
+      }
+  }
+
+  bool meshWatcher::take(meshUpdate &update)
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    if(!hasPending)
+      {
+	return false;
+      }
+    update = std::move(pending);
+    pending = meshUpdate{};
+    hasPending = false;
+    return true;
+  }
+
+  /**
+   * Waits on inotify with a short timeout so stop() is seen.
+   * Exporters write in several steps, so a change is only acted
+   * on once the directory has been quiet for 100 ms.
+   */
+  void meshWatcher::run()
+  {
+    std::size_t slash = filename.find_last_of('/');
+    std::string name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+    alignas(inotify_event) char buffer[4096];
+    auto drain = [&]() {
+      bool ours = false;
+      ssize_t got;
+      while((got = ::read(notify, buffer, sizeof(buffer))) > 0)
+	{
+	  for(char *p = buffer; p < buffer + got;)
+	    {
+	      const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+	      ours = ours || (event->len > 0 && name == event->name);
+	      p += sizeof(inotify_event) + event->len;
+	    }
+	}
+      return ours;
+    };
+    auto ready = [&]() {
+      pollfd fd{notify, POLLIN, 0};
+      return ::poll(&fd, 1, 100) > 0;
+    };
+    while(!stopping)
+      {
+	if(!ready() || !drain())
+	  {
+	    continue;
+	  }
+	while(!stopping && ready())
+	  {
+	    drain();
+	  }
+	if(!stopping)
+	  {
+	    reload();
+	  }
+      }
+  }
+
+  void meshWatcher::reload()
+  {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    std::shared_ptr<mesh> next = std::make_shared<mesh>();
+    // The loader logs in pieces while the render thread logs too
+    std::ostringstream log;
+    std::ostream *sink = logSink;
+    logSink = &log;
+    bool loaded = load(filename, *next) && !next->elements.empty();
+    logSink = sink;
+    LOG(log.str());
+    if(!loaded)
+      {
+	LOG("[Error] Reloading "); LOG(filename); LOG(" failed, keeping the current mesh\n");
+	return;
+      }
+    auto parsed = clock::now();
+
+    meshUpdate update;
+    update.resizeVertices = next->vertices.size() != resident->vertices.size();
+    update.resizeElements = next->elements.size() != resident->elements.size();
+    update.resizeColors = next->colors.size() != resident->colors.size();
+    if(!update.resizeVertices)
+      {
+	update.vertices = diffBlocks(resident->vertices, next->vertices, vertexBlock);
+      }
+    if(!update.resizeElements)
+      {
+	update.elements = diffBlocks(resident->elements, next->elements, elementBlock);
+      }
+    if(!update.resizeColors)
+      {
+	update.colors = diffBlocks(resident->colors, next->colors, vertexBlock);
+      }
+    update.parseMs = std::chrono::duration<double, std::milli>(parsed - start).count();
+    update.diffMs = std::chrono::duration<double, std::milli>(clock::now() - parsed).count();
+    if(!update.resizeVertices && !update.resizeElements && !update.resizeColors
+       && update.vertices.empty() && update.elements.empty() && update.colors.empty())
+      {
+	LOG("[Ok] "); LOG(filename); LOG(" rewritten without changes\n");
+	return;
+      }
+    resident = next;
+    update.m = std::move(next);
+
+    // Ranges of an update still waiting are stale on the GPU too
+    std::lock_guard<std::mutex> guard{lock};
+    if(hasPending)
+      {
+	update.resizeVertices = update.resizeVertices || pending.resizeVertices;
+	update.resizeElements = update.resizeElements || pending.resizeElements;
+	update.resizeColors = update.resizeColors || pending.resizeColors;
+	update.vertices = mergeRanges(std::move(update.vertices), pending.vertices);
+	update.elements = mergeRanges(std::move(update.elements), pending.elements);
+	update.colors = mergeRanges(std::move(update.colors), pending.colors);
+	update.parseMs += pending.parseMs;
+	update.diffMs += pending.diffMs;
+      }
+    pending = std::move(update);
+    hasPending = true;
+  }
+
+} /* End twg namespace */
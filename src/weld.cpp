@@ -0,0 +1,288 @@
+/**
+ * meshtool mesh converter and viewer utility
+ *
+ * Author: Todd Saharchuk, AScT.
+ * Date:   October 19, 2026
+ *
+ *
+ */
+#include <weld.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cfloat>
+
+namespace twg {
+
+  /**
+   * Read only spatial hash over grid cells: vertex indices
+   * sorted by cell, and an open addressing table from cell key
+   * to its run in that order.
+   */
+  struct weldGrid {
+    static constexpr uint64_t empty = ~0ull;
+    glm::vec3 origin;
+    float inverseCell;
+    std::vector<std::pair<uint64_t, uint32_t>> order;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> runStart, runEnd;
+
+    static uint64_t cellKey(glm::ivec3 c)
+    {
+      return uint64_t(c.x) | uint64_t(c.y) << 21 | uint64_t(c.z) << 42;
+    }
+
+    static uint64_t mix(uint64_t k)
+    {
+      k ^= k >> 33;
+      k *= 0xff51afd7ed558ccdull;
+      k ^= k >> 33;
+      return k;
+    }
+
+    glm::vec3 cellPosition(const glm::vec3 &p) const
+    {
+      return (p - origin) * inverseCell;
+    }
+
+    std::size_t find(uint64_t key) const
+    {
+      std::size_t mask = keys.size() - 1;
+      std::size_t slot = mix(key) & mask;
+      while(keys[slot] != empty && keys[slot] != key)
+	{
+	  slot = (slot + 1) & mask;
+	}
+      return keys[slot] == key ? slot : keys.size();
+    }
+  };
+
+  /**
+   * Cells are at least 2 * epsilon wide, so a vertex's
+   * neighbours within epsilon lie in its own cell or in the
+   * cell across the nearer face on each axis: 8 cells, not 27.
+   * Cell coordinates start at 1 so the -1 neighbour is valid.
+   */
+  static void buildGrid(weldGrid &grid, const mesh &m, float epsilon)
+  {
+    struct boundsResult { glm::vec3 lo, hi; };
+    boundsResult b = parallelReduce
+      (0, m.vertices.size(), boundsResult{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)},
+       [&](std::size_t lo, std::size_t hi) {
+	boundsResult r{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    r.lo = glm::min(r.lo, m.vertices[i].point);
+	    r.hi = glm::max(r.hi, m.vertices[i].point);
+	  }
+	return r;
+      },
+       [](const boundsResult &a, const boundsResult &c) {
+	return boundsResult{glm::min(a.lo, c.lo), glm::max(a.hi, c.hi)};
+      });
+    glm::vec3 extent = b.hi - b.lo;
+    float longest = std::max(extent.x, std::max(extent.y, extent.z));
+    float cell = std::max(2.0f * epsilon, longest / float(1 << 20));
+    if(cell <= 0.0f)
+      {
+	cell = 1.0f;
+      }
+    grid.inverseCell = 1.0f / cell;
+    grid.origin = b.lo - cell;
+
+    grid.order.resize(m.vertices.size());
+    parallelFor(0, m.vertices.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    glm::ivec3 c(glm::floor(grid.cellPosition(m.vertices[i].point)));
+	    grid.order[i] = {weldGrid::cellKey(c), static_cast<uint32_t>(i)};
+	  }
+      });
+    std::sort(grid.order.begin(), grid.order.end());
+
+    std::size_t cells = 0;
+    for(std::size_t i = 0; i < grid.order.size(); ++i)
+      {
+	cells += i == 0 || grid.order[i].first != grid.order[i - 1].first;
+      }
+    std::size_t capacity = 16;
+    while(capacity < 2 * cells)
+      {
+	capacity <<= 1;
+      }
+    grid.keys.assign(capacity, weldGrid::empty);
+    grid.runStart.assign(capacity, 0);
+    grid.runEnd.assign(capacity, 0);
+    for(std::size_t i = 0; i < grid.order.size(); ++i)
+      {
+	uint64_t key = grid.order[i].first;
+	if(i > 0 && key == grid.order[i - 1].first)
+	  {
+	    continue;
+	  }
+	std::size_t slot = weldGrid::mix(key) & (capacity - 1);
+	while(grid.keys[slot] != weldGrid::empty)
+	  {
+	    slot = (slot + 1) & (capacity - 1);
+	  }
+	std::size_t end = i + 1;
+	while(end < grid.order.size() && grid.order[end].first == key)
+	  {
+	    ++end;
+	  }
+	grid.keys[slot] = key;
+	grid.runStart[slot] = static_cast<uint32_t>(i);
+	grid.runEnd[slot] = static_cast<uint32_t>(end);
+      }
+  }
+
+  weldStats weldVertices(mesh &m, float epsilon)
+  {
+    auto start = std::chrono::steady_clock::now();
+    weldStats stats;
+    std::size_t n = m.vertices.size();
+    stats.verticesBefore = n;
+    if(n == 0)
+      {
+	return stats;
+      }
+    weldGrid grid;
+    buildGrid(grid, m, epsilon);
+
+    // Lowest indexed vertex within epsilon, always <= i
+    float eps2 = epsilon * epsilon;
+    std::vector<uint32_t> target(n);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    const glm::vec3 &p = m.vertices[i].point;
+	    glm::vec3 g = grid.cellPosition(p);
+	    glm::ivec3 c(glm::floor(g));
+	    glm::ivec3 side = glm::ivec3(glm::greaterThanEqual(g - glm::vec3(c),
+							       glm::vec3(0.5f))) * 2 - 1;
+	    uint32_t best = static_cast<uint32_t>(i);
+	    for(int k = 0; k < 8; ++k)
+	      {
+		glm::ivec3 d = c + side * glm::ivec3(k & 1, (k >> 1) & 1, (k >> 2) & 1);
+		std::size_t slot = grid.find(weldGrid::cellKey(d));
+		if(slot == grid.keys.size())
+		  {
+		    continue;
+		  }
+		for(uint32_t r = grid.runStart[slot]; r < grid.runEnd[slot]; ++r)
+		  {
+		    uint32_t j = grid.order[r].second;
+		    if(j < best)
+		      {
+			glm::vec3 e = m.vertices[j].point - p;
+			if(glm::dot(e, e) <= eps2)
+			  {
+			    best = j;
+			  }
+		      }
+		  }
+	      }
+	    target[i] = best;
+	  }
+      });
+
+    // Follow chains in index order, then number the survivors
+    std::vector<uint32_t> remap(n);
+    uint32_t kept = 0;
+    for(std::size_t i = 0; i < n; ++i)
+      {
+	target[i] = target[target[i]];
+	remap[i] = target[i] == i ? kept++ : remap[target[i]];
+      }
+    std::vector<Vertex> welded(kept);
+    parallelFor(0, n, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    if(target[i] == i)
+	      {
+		welded[remap[i]] = m.vertices[i];
+	      }
+	  }
+      });
+    m.vertices.swap(welded);
+
+    // Remap in place, then squeeze out collapsed triangles
+    std::size_t triangles = m.elements.size() / 3;
+    parallelFor(0, m.elements.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    m.elements[i] = remap[m.elements[i]];
+	  }
+      });
+    std::size_t out = 0;
+    auto squeeze = [&](std::size_t begin, std::size_t end) {
+      for(std::size_t t = begin; t < end; ++t)
+	{
+	  const GLuint *e = &m.elements[3 * t];
+	  if(e[0] != e[1] && e[1] != e[2] && e[2] != e[0])
+	    {
+	      if(out != t)
+		{
+		  std::copy(e, e + 3, &m.elements[3 * out]);
+		}
+	      ++out;
+	    }
+	}
+    };
+    if(m.materialRanges.empty())
+      {
+	squeeze(0, triangles);
+      }
+    for(materialRange &r : m.materialRanges)
+      {
+	// Material ranges shrink with their collapsed triangles
+	std::size_t first = out;
+	squeeze(r.first / 3, (r.first + r.count) / 3);
+	r.first = static_cast<GLuint>(3 * first);
+	r.count = static_cast<GLuint>(3 * (out - first));
+      }
+    stats.trianglesRemoved = triangles - out;
+    m.elements.resize(3 * out);
+    stats.verticesAfter = kept;
+    stats.seconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+    return stats;
+  }
+
+  /**
+   * Face normals are computed in parallel but summed into the
+   * vertices in face order, so the result is deterministic.
+   */
+  void smoothNormals(mesh &m)
+  {
+    std::size_t triangles = m.elements.size() / 3;
+    std::vector<glm::vec3> faceNormals(triangles);
+    parallelFor(0, triangles, [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t t = lo; t < hi; ++t)
+	  {
+	    const glm::vec3 &a = m.vertices[m.elements[3 * t]].point;
+	    const glm::vec3 &b = m.vertices[m.elements[3 * t + 1]].point;
+	    const glm::vec3 &c = m.vertices[m.elements[3 * t + 2]].point;
+	    faceNormals[t] = glm::cross(b - a, c - a);
+	  }
+      });
+    std::vector<glm::vec3> sums(m.vertices.size(), glm::vec3(0.0f));
+    for(std::size_t t = 0; t < triangles; ++t)
+      {
+	for(int k = 0; k < 3; ++k)
+	  {
+	    sums[m.elements[3 * t + k]] += faceNormals[t];
+	  }
+      }
+    parallelFor(0, m.vertices.size(), [&](std::size_t lo, std::size_t hi, unsigned) {
+	for(std::size_t i = lo; i < hi; ++i)
+	  {
+	    float len = glm::length(sums[i]);
+	    if(len > 0.0f)
+	      {
+		m.vertices[i].normal = sums[i] / len;
+	      }
+	  }
+      });
+  }
+
+} /* End twg namespace */